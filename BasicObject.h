@@ -1,68 +1,84 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-#include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "NiagaraSystem.h"
-#include "NiagaraComponent.h"
-#include "BasicObject.generated.h"
-
-
-UCLASS()
-class BRIGHTSPARKSPROJECT_API ABasicObject : public AActor
-{
-	GENERATED_BODY()
-	
-public:	
-	// Sets default values for this actor's properties
-	ABasicObject();
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Fire Nearest Object")
-	class USphereComponent* FireSpreadSphere;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
-	float SpreadRadius = 100.0f;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
-	bool bIsFlammable;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
-	bool bIsOnFire;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
-	bool bDrawDebugLine = false;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
-	float FlammabilityFactor = 1.0f; 
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
-	float MinSpreadDelay = 0.5f;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
-	float MaxSpreadDelay = 2.0f;
-
-	UFUNCTION(BlueprintCallable, Category = "Fire Nearest Object")
-	void StartFire();
-
-	UFUNCTION(BlueprintCallable, Category = "Fire Nearest Object")
-	void SpreadFireNearestObject();
-
-	UFUNCTION(BlueprintCallable, Category = "Fire Nearest Object")
-	void SetNextObjectOnFire(ABasicObject* TargetObject);
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
-	UNiagaraSystem* FireEffect;
-
-	UFUNCTION(BlueprintCallable, Category = "Fire Spreading")
-	void CastRayToDetectGround();
-
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "NiagaraSystem.h"
+#include "NiagaraComponent.h"
+#include "BasicObject.generated.h"
+
+
+UCLASS()
+class BRIGHTSPARKSPROJECT_API ABasicObject : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	ABasicObject();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Fire Nearest Object")
+	class USphereComponent* FireSpreadSphere;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
+	float SpreadRadius = 100.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
+	bool bIsFlammable;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
+	bool bIsOnFire;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
+	bool bDrawDebugLine = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
+	float FlammabilityFactor = 1.0f; 
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
+	float MinSpreadDelay = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
+	float MaxSpreadDelay = 2.0f;
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Nearest Object")
+	void StartFire();
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Nearest Object")
+	void SpreadFireNearestObject();
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Nearest Object")
+	void SetNextObjectOnFire(ABasicObject* TargetObject);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Nearest Object")
+	UNiagaraSystem* FireEffect;
+
+	// Binds the object to the ground tiles under it again, lighting them if it burns. The fire subsystem keeps
+	// the binding, so this no longer traces and is only needed when the object moves without a transform update
+	UFUNCTION(BlueprintCallable, Category = "Fire Spreading")
+	void CastRayToDetectGround();
+
+	// Drops any pending spreads and effects, then starts burning again if bOnFire
+	UFUNCTION(BlueprintCallable, Category = "Fire Nearest Object")
+	void ResetFire(bool bOnFire);
+
+	// This object's slot in the fire subsystem's object table, which binds it to the tiles under it
+	int32 FireObjectIndex = INDEX_NONE;
+
+protected:
+	// Filled by SpreadFireNearestObject every frame it burns, kept so the allocation is reused
+	TArray<AActor*> OverlapScratch;
+
+	// Objects a spread timer is already running for, each gets one until ResetFire
+	TArray<TWeakObjectPtr<ABasicObject>, TInlineAllocator<8>> SpreadTargets;
+
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+public:	
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+};
@@ -0,0 +1,588 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireBurnRisk.h"
+#include "FireSpreadSubsystem.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter.h"
+
+static TAutoConsoleVariable<float> CVarFireRiskInterval(
+    TEXT("fire.Risk.Interval"),
+    2.0f,
+    TEXT("Seconds between burn risk estimates of the current fire, 0 turns them off."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFireRiskRuns(
+    TEXT("fire.Risk.Runs"),
+    1000,
+    TEXT("Seeded runs per burn risk estimate, played in batches of 64."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireRiskHorizon(
+    TEXT("fire.Risk.Horizon"),
+    30.0f,
+    TEXT("Seconds ahead the burn risk estimate looks."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireRiskStepSeconds(
+    TEXT("fire.Risk.StepSeconds"),
+    0.25f,
+    TEXT("Clock step of the burn risk runs, spreads due within a step happen together."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFireRiskTextureSize(
+    TEXT("fire.Risk.TextureSize"),
+    256,
+    TEXT("Texels per side of the burn risk texture. Read when the texture is first created."),
+    ECVF_Default);
+
+namespace
+{
+    constexpr int32 NumLanes = 64;
+    constexpr uint16 NeverStep = MAX_uint16;
+
+    // Per tile bits that are the same in every run, since no digging happens during an estimate
+    enum class EStaticTile : uint8
+    {
+        None        = 0,
+        NoSpread    = 1 << 0,
+        NoIgnite    = 1 << 1
+    };
+    ENUM_CLASS_FLAGS(EStaticTile)
+
+    // A tile with a spread still to come in at least one lane
+    struct FActiveTile
+    {
+        int32 Tile = INDEX_NONE;
+        uint64 PendingLanes = 0;
+        uint16 SpreadStep[NumLanes];
+
+        // Neighbours the spread picks, from the fuel the tile will have left by then
+        uint8 SpreadPicks[NumLanes];
+    };
+
+    // A spread queued when the request was made, the same in every lane
+    struct FStartSpread
+    {
+        int32 Tile = INDEX_NONE;
+        uint16 Step = 0;
+        uint8 Picks = 0;
+    };
+
+    /*
+        Plays up to 64 runs together. A burn out never changes what the fire can do next, a burnt
+        tile blocks spread exactly as a burning one does and its spread still goes ahead, so the
+        runs only track which tiles caught and when each one's spread is due.
+    */
+    class FRolloutBatch
+    {
+    public:
+        FRolloutBatch(const FFireBurnRiskRequest& InRequest, TArrayView<const EStaticTile> InStaticTiles, TArrayView<const FStartSpread> InStartSpreads, float InStepSeconds)
+            : Request(InRequest)
+            , Layout(*InRequest.Layout)
+            , SpreadWeights(*InRequest.SpreadWeights)
+            , StaticTiles(InStaticTiles)
+            , StartSpreads(InStartSpreads)
+            , StepSeconds(InStepSeconds)
+        {
+            Lost.SetNumUninitialized(Layout.Num());
+            ActiveSlots.SetNumUninitialized(Layout.Num());
+        }
+
+        void Run(int32 Seed, int32 NumRuns, int32 NumSteps, TArray<int32>& InOutCounts)
+        {
+            const uint64 AllLanes = NumRuns >= NumLanes ? ~0ull : (1ull << NumRuns) - 1;
+
+            for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+            {
+                Random[Lane].Initialize(Seed + Lane);
+            }
+
+            // Tiles already alight are lost in every run
+            for (int32 Tile = 0; Tile < Layout.Num(); ++Tile)
+            {
+                Lost[Tile] = EnumHasAnyFlags(Request.Flags[Tile], EFireTileFlags::Burning | EFireTileFlags::Burnt) ? AllLanes : 0;
+                ActiveSlots[Tile] = INDEX_NONE;
+            }
+
+            ActiveTiles.Reset();
+            for (const FStartSpread& Start : StartSpreads)
+            {
+                FActiveTile& Active = GetActiveTile(Start.Tile);
+                for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+                {
+                    Active.SpreadStep[Lane] = Start.Step;
+                    Active.SpreadPicks[Lane] = Start.Picks;
+                }
+                Active.PendingLanes = AllLanes;
+            }
+
+            for (int32 Step = 0; Step < NumSteps && ActiveTiles.Num() > 0; ++Step)
+            {
+                // Tiles caught this step are added at the end and are never due before the next step
+                const int32 NumActive = ActiveTiles.Num();
+                const uint16 StepIndex = static_cast<uint16>(Step);
+                for (int32 Slot = 0; Slot < NumActive; ++Slot)
+                {
+                    // Lane compare over the whole batch, vectorises to a few wide compares
+                    const FActiveTile& Active = ActiveTiles[Slot];
+                    uint64 DueLanes = 0;
+                    for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+                    {
+                        DueLanes |= static_cast<uint64>(Active.SpreadStep[Lane] == StepIndex) << Lane;
+                    }
+                    DueLanes &= Active.PendingLanes;
+                    if (DueLanes == 0) continue;
+
+                    ActiveTiles[Slot].PendingLanes &= ~DueLanes;
+                    const int32 Tile = Active.Tile;
+
+                    // Spreading can grow ActiveTiles, Active is not used past here
+                    while (DueLanes != 0)
+                    {
+                        const int32 Lane = FMath::CountTrailingZeros64(DueLanes);
+                        DueLanes &= DueLanes - 1;
+                        Spread(Tile, Lane, ActiveTiles[Slot].SpreadPicks[Lane], Step);
+                    }
+                }
+
+                // Tiles with no spread left in any lane give their slot back
+                for (int32 Slot = ActiveTiles.Num() - 1; Slot >= 0; --Slot)
+                {
+                    if (ActiveTiles[Slot].PendingLanes != 0) continue;
+
+                    ActiveSlots[ActiveTiles[Slot].Tile] = INDEX_NONE;
+                    ActiveTiles.RemoveAtSwap(Slot, 1, false);
+                    if (Slot < ActiveTiles.Num())
+                    {
+                        ActiveSlots[ActiveTiles[Slot].Tile] = Slot;
+                    }
+                }
+            }
+
+            for (int32 Tile = 0; Tile < Layout.Num(); ++Tile)
+            {
+                InOutCounts[Tile] += FMath::CountBits(Lost[Tile] & AllLanes);
+            }
+        }
+
+    private:
+        FActiveTile& GetActiveTile(int32 Tile)
+        {
+            int32& Slot = ActiveSlots[Tile];
+            if (Slot == INDEX_NONE)
+            {
+                Slot = ActiveTiles.AddDefaulted();
+                FActiveTile& Active = ActiveTiles[Slot];
+                Active.Tile = Tile;
+                FMemory::Memset(Active.SpreadStep, 0xFF, sizeof(Active.SpreadStep));
+            }
+            return ActiveTiles[Slot];
+        }
+
+        // UFireSpreadSubsystem::SpreadFromTile for one lane
+        void Spread(int32 Tile, int32 Lane, int32 MaxPicks, int32 Step)
+        {
+            const uint64 LaneBit = 1ull << Lane;
+
+            SpreadWeights.PickBuiltNeighbours(Tile, MaxPicks, Random[Lane],
+                [this, LaneBit](int32 Neighbour)
+                {
+                    return (Lost[Neighbour] & LaneBit) == 0 && !EnumHasAnyFlags(StaticTiles[Neighbour], EStaticTile::NoSpread);
+                },
+                Picked);
+
+            for (int32 Neighbour : Picked)
+            {
+                Ignite(Neighbour, Lane, Step);
+            }
+        }
+
+        void Ignite(int32 Tile, int32 Lane, int32 Step)
+        {
+            if (EnumHasAnyFlags(StaticTiles[Tile], EStaticTile::NoIgnite)) return;
+
+            const uint64 LaneBit = 1ull << Lane;
+            Lost[Tile] |= LaneBit;
+
+            const float Delay = FFireTileTable::GetSpreadDelayScale(Request.BurnTypes[Tile]) *
+                Random[Lane].FRandRange(Layout.MinSpreadDelays[Tile], Layout.MaxSpreadDelays[Tile]);
+            const int32 DelaySteps = FMath::Max(1, FMath::CeilToInt(Delay / StepSeconds));
+
+            // Lit with its full load, burning at its own rate until the spread
+            const float Fuel = Layout.BurnRates[Tile] * (Layout.BurnDurations[Tile] - Delay);
+
+            FActiveTile& Active = GetActiveTile(Tile);
+            Active.SpreadStep[Lane] = static_cast<uint16>(FMath::Min(Step + DelaySteps, NeverStep - 1));
+            Active.SpreadPicks[Lane] = static_cast<uint8>(FFireSpreadWeights::GetMaxPicks(Fuel, Request.FullIntensityFuel));
+            Active.PendingLanes |= LaneBit;
+        }
+
+        const FFireBurnRiskRequest& Request;
+        const FFireTileTable& Layout;
+        const FFireSpreadWeights& SpreadWeights;
+        TArrayView<const EStaticTile> StaticTiles;
+        TArrayView<const FStartSpread> StartSpreads;
+        float StepSeconds = 0.25f;
+
+        // Kept between spreads so picking never allocates
+        TArray<int32, TInlineAllocator<8>> Picked;
+
+        // Runs each tile has caught in, one bit per lane
+        TArray<uint64> Lost;
+
+        TArray<FActiveTile> ActiveTiles;
+        TArray<int32> ActiveSlots;
+
+        FRandomStream Random[NumLanes];
+    };
+
+    // Highest tile risk per texel over the XY bounds of the tiles
+    void SplatTexels(const FFireTileTable& Layout, const TArray<float>& TileRisk, int32 Size, FFireBurnRiskResult& OutResult)
+    {
+        FBox2D Bounds(ForceInit);
+        for (const FVector3f& Location : Layout.Locations)
+        {
+            Bounds += FVector2D(Location.X, Location.Y);
+        }
+
+        OutResult.BoundsMin = Bounds.Min;
+        OutResult.BoundsMax = Bounds.Max;
+        OutResult.Texels.SetNumZeroed(Size * Size);
+
+        const FVector2D Extent = (Bounds.Max - Bounds.Min).ComponentMax(FVector2D(1.0, 1.0));
+        for (int32 Tile = 0; Tile < Layout.Num(); ++Tile)
+        {
+            const FVector2D UV = (FVector2D(Layout.Locations[Tile].X, Layout.Locations[Tile].Y) - Bounds.Min) / Extent;
+            const int32 X = FMath::Clamp(FMath::FloorToInt(UV.X * Size), 0, Size - 1);
+            const int32 Y = FMath::Clamp(FMath::FloorToInt(UV.Y * Size), 0, Size - 1);
+
+            uint8& Texel = OutResult.Texels[Y * Size + X];
+            Texel = FMath::Max(Texel, static_cast<uint8>(FMath::RoundToInt(TileRisk[Tile] * 255.0f)));
+        }
+    }
+}
+
+void FireBurnRisk::Estimate(const FFireBurnRiskRequest& Request, FFireBurnRiskResult& OutResult)
+{
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    const FFireTileTable& Layout = *Request.Layout;
+    const int32 NumTiles = Layout.Num();
+
+    OutResult.TileRisk.SetNumZeroed(NumTiles);
+    if (NumTiles == 0 || Request.NumRuns <= 0 || Request.Flags.Num() != NumTiles || Request.BurnTypes.Num() != NumTiles) return;
+    if (!Request.SpreadWeights.IsValid() || !Request.SpreadWeights->IsInitialised()) return;
+
+    TArray<EStaticTile> StaticTiles;
+    StaticTiles.SetNumUninitialized(NumTiles);
+    for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+    {
+        const EFireTileFlags Dug = Request.Flags[Tile] & EFireTileFlags::Dug;
+        StaticTiles[Tile] = EStaticTile::None;
+        if (!FFireTileTable::CanSpreadInto(Dug)) StaticTiles[Tile] |= EStaticTile::NoSpread;
+        if (!FFireTileTable::CanIgnite(Dug, Request.BurnTypes[Tile])) StaticTiles[Tile] |= EStaticTile::NoIgnite;
+    }
+
+    // Step indices are 16 bit, a very fine step over a long horizon is coarsened to fit
+    const float StepSeconds = FMath::Max3(Request.StepSeconds, Request.Horizon / (NeverStep - 1), 0.01f);
+    const int32 NumSteps = FMath::CeilToInt(Request.Horizon / StepSeconds);
+
+    // Burn outs give the burn time a queued spread's tile has left, tiles without one are taken as just lit
+    TArray<float> BurnTimeLeft = Layout.BurnDurations;
+    for (const FFireHistoryEvent& Event : Request.Events)
+    {
+        if (Event.Type == EFireEventType::BurnOut && Layout.IsValidIndex(Event.TileIndex))
+        {
+            BurnTimeLeft[Event.TileIndex] = Event.Remaining;
+        }
+    }
+
+    TArray<FStartSpread> StartSpreads;
+    for (const FFireHistoryEvent& Event : Request.Events)
+    {
+        if (Event.Type != EFireEventType::Spread || !Layout.IsValidIndex(Event.TileIndex)) continue;
+
+        const float Fuel = Layout.BurnRates[Event.TileIndex] * FMath::Max(BurnTimeLeft[Event.TileIndex] - Event.Remaining, 0.0f);
+
+        FStartSpread& Start = StartSpreads.AddDefaulted_GetRef();
+        Start.Tile = Event.TileIndex;
+        Start.Step = static_cast<uint16>(FMath::Min(FMath::CeilToInt(Event.Remaining / StepSeconds), NeverStep - 1));
+        Start.Picks = static_cast<uint8>(FFireSpreadWeights::GetMaxPicks(Fuel, Request.FullIntensityFuel));
+    }
+
+    const int32 NumBatches = FMath::DivideAndRoundUp(Request.NumRuns, NumLanes);
+    const int32 NumWorkers = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, NumBatches);
+
+    TArray<TArray<int32>> WorkerCounts;
+    WorkerCounts.SetNum(NumWorkers);
+    FThreadSafeCounter NextBatch;
+
+    ParallelFor(NumWorkers, [&](int32 Worker)
+        {
+            TArray<int32>& Counts = WorkerCounts[Worker];
+            Counts.SetNumZeroed(NumTiles);
+
+            FRolloutBatch Batch(Request, StaticTiles, StartSpreads, StepSeconds);
+            for (int32 BatchIndex = NextBatch.Increment() - 1; BatchIndex < NumBatches; BatchIndex = NextBatch.Increment() - 1)
+            {
+                const int32 NumRuns = FMath::Min(NumLanes, Request.NumRuns - BatchIndex * NumLanes);
+                Batch.Run(Request.Seed + BatchIndex * NumLanes, NumRuns, NumSteps, Counts);
+            }
+        });
+
+    const float RunScale = 1.0f / Request.NumRuns;
+    for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+    {
+        int32 Count = 0;
+        for (const TArray<int32>& Counts : WorkerCounts)
+        {
+            Count += Counts[Tile];
+        }
+        OutResult.TileRisk[Tile] = Count * RunScale;
+    }
+
+    SplatTexels(Layout, OutResult.TileRisk, FMath::Max(Request.TextureSize, 1), OutResult);
+    OutResult.EstimateMs = static_cast<float>(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+}
+
+bool UFireBurnRiskSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UFireBurnRiskSubsystem::Deinitialize()
+{
+    // The task only owns copies, but the texture update has to wait for it
+    if (PendingEstimate.IsValid())
+    {
+        PendingEstimate.Wait();
+        PendingEstimate.Reset();
+    }
+    Layout.Reset();
+    SpreadWeights.Reset();
+    TileRisk.Empty();
+    RiskTexture = nullptr;
+
+    Super::Deinitialize();
+}
+
+TStatId UFireBurnRiskSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UFireBurnRiskSubsystem, STATGROUP_Tickables);
+}
+
+void UFireBurnRiskSubsystem::Tick(float DeltaTime)
+{
+    if (PendingEstimate.IsValid() && PendingEstimate.IsReady())
+    {
+        PublishResult(PendingEstimate.Get(), PendingHorizon, PendingRuns);
+        PendingEstimate.Reset();
+    }
+
+    const float Interval = CVarFireRiskInterval.GetValueOnGameThread();
+    if (Interval <= 0.0f) return;
+
+    TimeSinceEstimate += DeltaTime;
+    if (TimeSinceEstimate >= Interval && RequestEstimate())
+    {
+        TimeSinceEstimate = 0.0f;
+    }
+}
+
+bool UFireBurnRiskSubsystem::RequestEstimate()
+{
+    if (PendingEstimate.IsValid()) return false;
+
+    // Clients hold the replicated tile states but not the server's event queue
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+    if (!FireSubsystem || !FireSubsystem->HasSimulationAuthority() || FireSubsystem->GetNumTiles() == 0) return false;
+
+    const FFireTileTable& Tiles = FireSubsystem->GetTiles();
+    if (!Layout.IsValid() || LayoutVersion != FireSubsystem->GetLayoutVersion())
+    {
+        Layout = MakeShared<const FFireTileTable>(Tiles);
+        LayoutVersion = FireSubsystem->GetLayoutVersion();
+    }
+
+    // Built in full on the copy so the batches only read it, which costs a rebuild on the game thread each time the wind turns
+    const FFireSpreadWeights& Weights = FireSubsystem->GetSpreadWeights();
+    if (!SpreadWeights.IsValid() || SpreadWeightsVersion != Weights.GetVersion())
+    {
+        TSharedRef<FFireSpreadWeights> Copy = MakeShared<FFireSpreadWeights>(Weights);
+        Copy->BuildStale();
+        SpreadWeights = Copy;
+        SpreadWeightsVersion = Weights.GetVersion();
+    }
+
+    FFireBurnRiskRequest Request;
+    Request.Layout = Layout;
+    Request.SpreadWeights = SpreadWeights;
+    Request.FullIntensityFuel = FireSubsystem->GetFullIntensityFuel();
+    Request.Flags = Tiles.Flags;
+    Request.BurnTypes = Tiles.BurnTypes;
+    FireSubsystem->GetQueuedEvents(Request.Events);
+    Request.Horizon = FMath::Max(CVarFireRiskHorizon.GetValueOnGameThread(), 0.0f);
+    Request.StepSeconds = FMath::Max(CVarFireRiskStepSeconds.GetValueOnGameThread(), 0.01f);
+    Request.NumRuns = FMath::Max(CVarFireRiskRuns.GetValueOnGameThread(), 1);
+    Request.Seed = NextSeed;
+    Request.TextureSize = RiskTexture ? RiskTexture->GetSizeX() : FMath::Clamp(CVarFireRiskTextureSize.GetValueOnGameThread(), 1, 4096);
+
+    // Fresh seeds each time so the published risk does not settle on one set of runs
+    NextSeed += Request.NumRuns;
+    PendingHorizon = Request.Horizon;
+    PendingRuns = Request.NumRuns;
+
+    PendingEstimate = Async(EAsyncExecution::ThreadPool, [Request = MoveTemp(Request)]()
+        {
+            FFireBurnRiskResult Result;
+            FireBurnRisk::Estimate(Request, Result);
+            return Result;
+        });
+    return true;
+}
+
+float UFireBurnRiskSubsystem::GetTileRisk(int32 TileIndex) const
+{
+    return TileRisk.IsValidIndex(TileIndex) ? TileRisk[TileIndex] : 0.0f;
+}
+
+void UFireBurnRiskSubsystem::PublishResult(FFireBurnRiskResult&& Result, float Horizon, int32 NumRuns)
+{
+    TileRisk = MoveTemp(Result.TileRisk);
+    RiskHorizon = Horizon;
+    RiskRuns = NumRuns;
+    LastEstimateMs = Result.EstimateMs;
+    RiskTextureMin = Result.BoundsMin;
+    RiskTextureMax = Result.BoundsMax;
+
+    const int32 Size = FMath::RoundToInt(FMath::Sqrt(static_cast<float>(Result.Texels.Num())));
+    if (Size > 0 && Size * Size == Result.Texels.Num())
+    {
+        if (!RiskTexture || RiskTexture->GetSizeX() != Size)
+        {
+            RiskTexture = UTexture2D::CreateTransient(Size, Size, PF_G8);
+            RiskTexture->SRGB = false;
+            RiskTexture->Filter = TF_Bilinear;
+            RiskTexture->AddressX = TA_Clamp;
+            RiskTexture->AddressY = TA_Clamp;
+            RiskTexture->UpdateResource();
+        }
+
+        // The render thread frees the texel copy once it has been uploaded
+        uint8* Texels = static_cast<uint8*>(FMemory::Malloc(Result.Texels.Num()));
+        FMemory::Memcpy(Texels, Result.Texels.GetData(), Result.Texels.Num());
+
+        FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, Size, Size);
+        RiskTexture->UpdateTextureRegions(0, 1, Region, Size, 1, Texels,
+            [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+            {
+                FMemory::Free(SrcData);
+                delete Regions;
+            });
+    }
+
+    OnBurnRiskUpdated.Broadcast();
+}
+
+static FAutoConsoleCommandWithArgs FireRiskBenchCommand(
+    TEXT("fire.RiskBench"),
+    TEXT("fire.RiskBench [Tiles=100000] [Runs=1000] [Horizon=30] [Fires=16] [Seed=0]\n")
+    TEXT("Lays out a square grid of about Tiles tiles of mixed ground with Fires burning tiles, each with a spread queued, ")
+    TEXT("then logs how long building the spread weights and one burn risk estimate of Runs runs take."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            int32 NumTiles = 100000;
+            int32 NumRuns = 1000;
+            float Horizon = 30.0f;
+            int32 NumFires = 16;
+            int32 Seed = 0;
+            for (const FString& Arg : Args)
+            {
+                FString Key, Value;
+                if (!Arg.Split(TEXT("="), &Key, &Value)) continue;
+
+                if (Key.Equals(TEXT("Tiles"), ESearchCase::IgnoreCase)) NumTiles = FMath::Clamp(FCString::Atoi(*Value), 16, 16 * 1024 * 1024);
+                else if (Key.Equals(TEXT("Runs"), ESearchCase::IgnoreCase)) NumRuns = FMath::Max(FCString::Atoi(*Value), 1);
+                else if (Key.Equals(TEXT("Horizon"), ESearchCase::IgnoreCase)) Horizon = FMath::Max(FCString::Atof(*Value), 1.0f);
+                else if (Key.Equals(TEXT("Fires"), ESearchCase::IgnoreCase)) NumFires = FMath::Max(FCString::Atoi(*Value), 1);
+                else if (Key.Equals(TEXT("Seed"), ESearchCase::IgnoreCase)) Seed = FCString::Atoi(*Value);
+            }
+
+            // Patches 160 across with the 8 neighbours a dense field gives them
+            const int32 Side = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumTiles)));
+            TSharedPtr<FFireTileTable> Layout = MakeShared<FFireTileTable>();
+            Layout->Reserve(Side * Side);
+
+            FRandomStream Random(Seed);
+            for (int32 Y = 0; Y < Side; ++Y)
+            {
+                for (int32 X = 0; X < Side; ++X)
+                {
+                    const int32 Tile = Layout->AddTile();
+                    Layout->Locations[Tile] = FVector3f(X * 160.0f, Y * 160.0f, 0.0f);
+
+                    // Mostly quick ground, some slow, a few tiles that never burn
+                    const float Ground = Random.FRand();
+                    Layout->BurnTypes[Tile] = Ground < 0.7f ? ESurfaceBurnType::Quick : (Ground < 0.95f ? ESurfaceBurnType::Slow : ESurfaceBurnType::NonBurnable);
+
+                    for (int32 DY = -1; DY <= 1; ++DY)
+                    {
+                        for (int32 DX = -1; DX <= 1; ++DX)
+                        {
+                            const int32 NX = X + DX;
+                            const int32 NY = Y + DY;
+                            if ((DX != 0 || DY != 0) && NX >= 0 && NY >= 0 && NX < Side && NY < Side)
+                            {
+                                Layout->Neighbours[Tile].Add(NY * Side + NX);
+                            }
+                        }
+                    }
+                }
+            }
+
+            FFireBurnRiskRequest Request;
+            Request.Layout = Layout;
+            Request.Flags = Layout->Flags;
+            Request.BurnTypes = Layout->BurnTypes;
+            Request.Horizon = Horizon;
+            Request.NumRuns = NumRuns;
+            Request.Seed = Seed;
+
+            // Each fire is burning with its spread due some time in the next few seconds
+            for (int32 Fire = 0; Fire < NumFires; ++Fire)
+            {
+                const int32 Tile = Random.RandHelper(Layout->Num());
+                Request.Flags[Tile] = EFireTileFlags::Burning;
+
+                FFireHistoryEvent& Spread = Request.Events.AddDefaulted_GetRef();
+                Spread.TileIndex = Tile;
+                Spread.Type = EFireEventType::Spread;
+                Spread.Remaining = Random.FRandRange(0.0f, 5.0f);
+            }
+
+            TSharedPtr<FFireSpreadWeights> SpreadWeights = MakeShared<FFireSpreadWeights>();
+            const uint64 WeightsStart = FPlatformTime::Cycles64();
+            SpreadWeights->Init(*Layout);
+            SpreadWeights->BuildStale();
+            const double WeightsMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - WeightsStart);
+            Request.SpreadWeights = SpreadWeights;
+
+            FFireBurnRiskResult Result;
+            FireBurnRisk::Estimate(Request, Result);
+
+            int32 NumAtRisk = 0;
+            double TotalRisk = 0.0;
+            for (float Risk : Result.TileRisk)
+            {
+                NumAtRisk += Risk >= 0.5f;
+                TotalRisk += Risk;
+            }
+
+            UE_LOG(LogTemp, Display, TEXT("fire.RiskBench: %d x %d tiles, %d fires, %d runs over %.0f s, spread weights built in %.1f ms"),
+                Side, Side, NumFires, NumRuns, Horizon, WeightsMs);
+            UE_LOG(LogTemp, Display, TEXT("fire.RiskBench: estimate took %.1f ms, %.1f us per run, %d tiles at even risk or more, %.0f tiles burnt per run"),
+                Result.EstimateMs, Result.EstimateMs * 1000.0 / NumRuns, NumAtRisk, TotalRisk);
+        }));
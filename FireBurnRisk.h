@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FireHistory.h"
+#include "FireSpreadWeights.h"
+#include "FireTileTable.h"
+#include "FireBurnRisk.generated.h"
+
+class UTexture2D;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnFireBurnRiskUpdated);
+
+// Fire state a burn risk estimate starts from, copied on the game thread and owned by the task
+struct FFireBurnRiskRequest
+{
+	// Neighbours, spread delays and locations, only copied again when the subsystem's layout version moves
+	TSharedPtr<const FFireTileTable> Layout;
+
+	// The subsystem's neighbour weights with every table built, only copied again when they go stale
+	TSharedPtr<const FFireSpreadWeights> SpreadWeights;
+	float FullIntensityFuel = 15.0f;
+
+	// Current state, Layout's own flags and burn types are not read
+	TArray<EFireTileFlags> Flags;
+	TArray<ESurfaceBurnType> BurnTypes;
+	TArray<FFireHistoryEvent> Events;
+
+	float Horizon = 30.0f;
+	float StepSeconds = 0.25f;
+	int32 NumRuns = 1000;
+	int32 Seed = 0;
+
+	// Texels per side of the risk texture, spread over the XY bounds of the tiles
+	int32 TextureSize = 256;
+};
+
+struct FFireBurnRiskResult
+{
+	// Fraction of runs each tile was burning or burnt in by the end of the horizon
+	TArray<float> TileRisk;
+
+	// G8, highest tile risk in each texel
+	TArray<uint8> Texels;
+	FVector2D BoundsMin = FVector2D::ZeroVector;
+	FVector2D BoundsMax = FVector2D::ZeroVector;
+
+	float EstimateMs = 0.0f;
+};
+
+namespace FireBurnRisk
+{
+	/*
+		Monte Carlo estimate of which tiles burn within the horizon if nobody digs.
+		Runs are played 64 at a time as the lanes of one batch: each tile keeps a 64 bit mask of the
+		runs it has caught in, and each tile on fire keeps its spread step per lane, so the per step
+		work is mask operations and lane compares over every run of the batch together. Spreads
+		follow UFireSpreadSubsystem::SpreadFromTile, up to 3 valid neighbours picked from the same
+		weights and fewer on low fuel, with per type delays, on a clock quantised to StepSeconds.
+		Batches are spread over the task graph workers.
+	*/
+	BRIGHTSPARKSPROJECT_API void Estimate(const FFireBurnRiskRequest& Request, FFireBurnRiskResult& OutResult);
+}
+
+/*
+	Keeps a burn risk estimate of the current fire up to date for the HUD and minimap.
+	Every fire.Risk.Interval seconds the fire state is copied and estimated on a background
+	task, the game thread only copies the state and picks the finished result up.
+*/
+UCLASS()
+class BRIGHTSPARKSPROJECT_API UFireBurnRiskSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Starts an estimate now unless one is already running
+	UFUNCTION(BlueprintCallable, Category = "Fire Risk")
+	bool RequestEstimate();
+
+	// Probability of the tile burning within RiskHorizon seconds, 0 before the first estimate
+	UFUNCTION(BlueprintPure, Category = "Fire Risk")
+	float GetTileRisk(int32 TileIndex) const;
+
+	const TArray<float>& GetTileRisks() const { return TileRisk; }
+
+	// Risk over the tiles' XY bounds, texel value is the highest risk of the tiles in it
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Risk")
+	UTexture2D* RiskTexture = nullptr;
+
+	// World XY the texture's corners map to
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Risk")
+	FVector2D RiskTextureMin = FVector2D::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Risk")
+	FVector2D RiskTextureMax = FVector2D::ZeroVector;
+
+	// Settings the published estimate was made with
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Risk")
+	float RiskHorizon = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Risk")
+	int32 RiskRuns = 0;
+
+	// Wall time of the last estimate on the worker threads
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Risk")
+	float LastEstimateMs = 0.0f;
+
+	UPROPERTY(BlueprintAssignable, Category = "Fire Risk")
+	FOnFireBurnRiskUpdated OnBurnRiskUpdated;
+
+private:
+	void PublishResult(FFireBurnRiskResult&& Result, float Horizon, int32 NumRuns);
+
+	TFuture<FFireBurnRiskResult> PendingEstimate;
+	float PendingHorizon = 0.0f;
+	int32 PendingRuns = 0;
+
+	TSharedPtr<const FFireTileTable> Layout;
+	uint32 LayoutVersion = 0;
+
+	TSharedPtr<const FFireSpreadWeights> SpreadWeights;
+	uint32 SpreadWeightsVersion = 0;
+
+	TArray<float> TileRisk;
+	float TimeSinceEstimate = 0.0f;
+	int32 NextSeed = 0;
+};
@@ -1,630 +1,873 @@
-
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "FireGameMode.h"
-#include <Kismet/GameplayStatics.h>
-#include "FireGamePlayerController.h"
-#include "PlayerCharacter.h"
-#include "FireGameInstance.h"
-#include "AudioManager.h"
-
-
-AFireGameMode::AFireGameMode()
-{
-    DefaultPawnClass = nullptr; 
-    PlayerControllerClass = AFireGamePlayerController::StaticClass(); 
-    PrimaryActorTick.bCanEverTick = true;
-}
-
-void AFireGameMode::BeginPlay()
-{
-    Super::BeginPlay();
-
-    if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
-    {
-        CurrentState = GI->PersistentState;
-        UE_LOG(LogTemp, Warning, TEXT("Restored game state from GameInstance: %d"), static_cast<uint8>(CurrentState));
-    }
-
-    UE_LOG(LogTemp, Warning, TEXT("GameMode BeginPlay - CurrentState: %d"), static_cast<uint8>(CurrentState));
-   
-
-    APlayerController* PC = UGameplayStatics::GetPlayerController(this, 0);
-    if (PC && !PC->GetPawn() && DefaultPawnClass)
-    {
-        APawn* SpawnedPawn = GetWorld()->SpawnActor<APawn>(DefaultPawnClass, FVector::ZeroVector, FRotator::ZeroRotator);
-        if (SpawnedPawn)
-        {
-            PC->Possess(SpawnedPawn);
-        }
-    }
-
-    if (CurrentState == EGameState::Playing)
-    {
-        // Start Checking for game over conditions
-        GetWorldTimerManager().SetTimer(
-            GameOverCheckTimerHandle,
-            this,
-            &AFireGameMode::CheckGameOverConditions,
-            GameOverCheckInterval,
-            true
-        );
-
-        // Start checking for game win conditions
-        GetWorldTimerManager().SetTimer(
-            WinGameCheckTimerHandle,
-            this,
-            &AFireGameMode::CheckGameWinConditions,
-            GameWinCheckInterval,
-            true
-        );
-    }
-}
-
-void AFireGameMode::Tick(float DeltaSeconds)
-{
-    Super::Tick(DeltaSeconds);
-
-    // Used to count the current level time
-    if (CurrentState == EGameState::Playing && !bGameEnded)
-    {
-        LevelTimer += DeltaSeconds;
-    }
-}
-
-//  Game Over Conditions
-void AFireGameMode::CheckGameOverConditions()
-{
-    bool bIsOverPercentBurnt = EvaluateBurnPercentage();
-    bool bIsSpecialTilesDestroyed = EvaluateSpecialTiles();
-
-    if (bIsOverPercentBurnt)
-    {
-        if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
-        {
-
-            GI->FinalEndGameText = EndTextLoseByOverBurn;
-        }
-    }
-    else if (bIsSpecialTilesDestroyed)
-    {
-        if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
-        {
-
-            GI->FinalEndGameText = EndTextLoseBySpecialTiles;
-        }
-    }
-    else
-    {
-        if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
-        {
-
-            GI->FinalEndGameText = EndTextLoseByHealth;
-        }
-    }
-
-    if (bIsOverPercentBurnt || bIsSpecialTilesDestroyed)
-    {
-        GameOver();
-    }
-}
-
-void AFireGameMode::GameOver()
-{
-    if (bGameEnded) return;
-    bGameEnded = true;
-    bPlayerWon = false;
-	UE_LOG(LogTemp, Display, TEXT("Game Over Called!"));
-
-    CallGameOverText();
-
-    TArray<AActor*> FoundManagers;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), AAudioManager::StaticClass(), FoundManagers);
-
-    if (FoundManagers.Num() > 0)
-    {
-        AAudioManager* Manager = Cast<AAudioManager>(FoundManagers[0]);
-        if (Manager)
-        {
-            Manager->PlayLoseCue();
-        }
-    }
-
-    GetWorldTimerManager().SetTimer(
-        CallResultsTimerHandle,
-        this,
-        &AFireGameMode::CallResultsScreen,
-        ResultsScreenTimerInterval,
-        true
-    );
-}
-
-bool AFireGameMode::EvaluateBurnPercentage()
-{
-    TArray<AActor*> AllFoundActors;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), AFireSpreadPatch::StaticClass(), AllFoundActors);
-
-    TArray<AFireSpreadPatch*> ValidBurnablePatches;
-    int32 BurntCount = 0;
-
-    // For all patches found check type
-    for (AActor* Actor : AllFoundActors)
-    {
-        // If the wrong actor is accidentally grabbed then skip it 
-        AFireSpreadPatch* Patch = Cast<AFireSpreadPatch>(Actor);
-        if (!Patch) continue;
-
-        // Filter out unusable patch types
-        switch (Patch->BurnType)
-        {
-        case ESurfaceBurnType::Quick:
-        case ESurfaceBurnType::Slow:
-            ValidBurnablePatches.Add(Patch);
-            if (Patch->bIsBurnt || Patch->bIsBurning)
-                BurntCount++;
-            break;
-
-        default:
-            break;
-        }
-    }
-
-    if (ValidBurnablePatches.Num() == 0) return false;
-    BurnPercent = BurntCount / static_cast<float>(ValidBurnablePatches.Num());
-
-    // Returns true or false if the burn percent is hire than the set threshold.
-    return BurnPercent >= (BurnedThresholdPercent / 100.0f);
-}
-
-bool AFireGameMode::EvaluateSpecialTiles()
-{
-    TArray<AActor*> AllFoundActors;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), AFireSpreadPatch::StaticClass(), AllFoundActors);
-
-    int32 TotalSpecial = 0;
-    int32 DestroyedSpecial = 0;
-
-    for (AActor* Actor : AllFoundActors)
-    {
-        AFireSpreadPatch* Patch = Cast<AFireSpreadPatch>(Actor);
-
-        // Skips all tiles that are not special
-        if (!Patch || !Patch->bSpecialTile) continue;
-
-        TotalSpecial++;
-
-        if (Patch->bIsBurning || Patch->bIsBurnt)
-        {
-            DestroyedSpecial++;
-        }
-    }
-
-    // Catch for if there was no special tiles
-    if (TotalSpecial == 0) return false; 
-
-    return DestroyedSpecial >= TotalSpecial;
-}
-
-
-// Game Win Conditions 
-void AFireGameMode::CheckGameWinConditions()
-{
-    if (bGameEnded) return;
-
-    // Prevent win called immediately after start
-    const float MinGameTime = 10.0f; 
-    if (GetWorld()->GetTimeSeconds() < MinGameTime) return;
-
-    bool bIsFireCompletelyGone = EvaluateFireExtinguished();
-
-    if (bIsFireCompletelyGone)
-    {
-        GameWin();
-    }
-}
-
-void AFireGameMode::GameWin()
-{
-    if (bGameEnded) return;
-    bGameEnded = true;
-    bPlayerWon = true;
-
-    UE_LOG(LogTemp, Display, TEXT("Game Win Called!"));
-
-
-    // Used to set widget before end game
-    if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
-    {
-        GI->FinalEndGameText = EndTextWinByBurnout;
-    }
-    CallGameOverText();
-
-    TArray<AActor*> FoundManagers;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), AAudioManager::StaticClass(), FoundManagers);
-
-    if (FoundManagers.Num() > 0)
-    {
-        AAudioManager* Manager = Cast<AAudioManager>(FoundManagers[0]);
-        if (Manager)
-        {
-            Manager->PlayWinCue();
-        }
-    }
-
-    GetWorldTimerManager().SetTimer(
-        CallResultsTimerHandle,
-        this,
-        &AFireGameMode::CallResultsScreen,
-        ResultsScreenTimerInterval,
-        true
-    );
-}
-
-bool AFireGameMode::EvaluateFireExtinguished()
-{
-    TArray<AActor*> AllFoundActors;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), AFireSpreadPatch::StaticClass(), AllFoundActors);
-
-    for (AActor* Actor : AllFoundActors)
-    {
-        AFireSpreadPatch* Patch = Cast<AFireSpreadPatch>(Actor);
-        // If the current item is a patch and if it is burning win has not been met
-        if (Patch && Patch->bIsBurning)
-        {
-            return false; 
-        }
-    }
-    return true; 
-}
-
-EGameState AFireGameMode::GetCurrentState() const
-{
-    return CurrentState;
-}
-
-void AFireGameMode::SetGameState(EGameState NewState)
-{
-    // If the state is already set then exit out 
-    if (CurrentState == NewState) return;
-
-    CurrentState = NewState;
-
-    if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
-    {
-        GI->PersistentState = NewState;
-    }
-
-    // Tell the controller to update input mode
-    if (APlayerController* PC = UGameplayStatics::GetPlayerController(this, 0))
-    {
-        AFireGamePlayerController* FireController = Cast<AFireGamePlayerController>(PC);
-        if (FireController)
-        {
-            FireController->ApplyInputForGameState(NewState);
-        }
-    }
-   
-    // Game Controller
-    switch (CurrentState)
-    {
-        case EGameState::Intro:
-            UE_LOG(LogTemp, Display, TEXT("Intro State Activated"));
-            DefaultPawnClass = nullptr;
-            UGameplayStatics::OpenLevel(GetWorld(), IntroLevelName);
-            break;
-
-        case EGameState::Playing:
-        {
-            UE_LOG(LogTemp, Display, TEXT("Playing State Activated"));
-            DefaultPawnClass = APlayerCharacter::StaticClass();
-
-            // Showing loading logic
-            AFireGamePlayerController* PC = Cast<AFireGamePlayerController>(UGameplayStatics::GetPlayerController(this, 0));
-            if (PC)
-            {
-                PC->ShowLoadingOverlay();
-            }
-            // Delay before level load so overlay can render
-            FTimerHandle LoadTimerHandle;
-            GetWorldTimerManager().SetTimer(
-                LoadTimerHandle,
-                [this]() {
-                    UGameplayStatics::OpenLevel(GetWorld(), GameplayLevelName);
-                },
-                0.5f, // Delay duration in seconds
-                false
-            );
-            break;
-        }
-        case EGameState::Results:
-            UE_LOG(LogTemp, Display, TEXT("Results State Activated"));
-            DefaultPawnClass = nullptr;
-            FetchEndScreenDetails();
-            UGameplayStatics::OpenLevel(GetWorld(), ResultsLevelName);
-            break;
-
-        case EGameState::Quitting:
-            UE_LOG(LogTemp, Display, TEXT("Quitting Game"));
-            // Allows space to add transition / exit messages
-            FGenericPlatformMisc::RequestExit(false);
-            break;
-
-        default:
-            UE_LOG(LogTemp, Display, TEXT("Unknown Game State in use."));
-            break;
-    }
-    
-}
-
-void AFireGameMode::CallResultsScreen()
-{
-    GetWorldTimerManager().ClearTimer(CallResultsTimerHandle);
-    SetGameState(EGameState::Results);
-}
-
-float AFireGameMode::GetThresholdForRank(EGameRank Rank)
-{
-    switch (Rank)
-    {
-    case EGameRank::SS: return 80.0f;
-    case EGameRank::S:  return 70.0f;
-    case EGameRank::A:  return 60.0f;
-    case EGameRank::B:  return 50.0f;
-    case EGameRank::C:  return 40.0f;
-    case EGameRank::D:  return 0.0f;
-    default: return 0.0f;
-    }
-}
-
-void AFireGameMode::FetchEndScreenDetails()
-{
-    UE_LOG(LogTemp, Warning, TEXT("Final level time: %.2f seconds"), LevelTimer);
-    FireLineCalculatorHandler();
-    if (!bPlayerWon)
-    {
-        // Player lost  assign E rank and a default score
-        FinalRank = EGameRank::E;
-        SavedPercent = 0; 
-    }
-    else
-    {
-        // Force one final update 
-        EvaluateBurnPercentage();
-
-        // Fetch the final percent 
-        SavedPercent = round(100 - (BurnPercent * 100));
-
-        UE_LOG(LogTemp, Display, TEXT("BurnPercent: %f, SavedPercent: %d"), BurnPercent, SavedPercent);
-
-
-        // Default to lowest rank
-        FinalRank = EGameRank::D;
-
-        // Loop over all the scores, return the highest match
-        TArray<EGameRank> RankOrder = {
-            EGameRank::SS,
-            EGameRank::S,
-            EGameRank::A,
-            EGameRank::B,
-            EGameRank::C,
-            EGameRank::D
-        };
-
-        for (EGameRank Rank : RankOrder)
-        {
-            float Threshold = GetThresholdForRank(Rank);
-            if (SavedPercent >= Threshold)
-            {
-                FinalRank = Rank;
-                break;
-            }
-        }
-    }
-
-    // Persist this to the Game Instance 
-    if (UFireGameInstance* GI = Cast <UFireGameInstance>(GetGameInstance()))
-    {
-        GI->FinalSavedPercent = SavedPercent;
-        GI->FinalSavedRank = FinalRank;
-        GI->FinalLevelDuration = LevelTimer;
-
-    }
-}
-
-void AFireGameMode::CallGameOverText()
-{
-    AFireGamePlayerController* PC = Cast<AFireGamePlayerController>(UGameplayStatics::GetPlayerController(this, 0));
-    if (PC)
-    {
-        PC->ShowGameOverText();
-    }
-}
-
-void AFireGameMode::FireLineCalculatorHandler()
-{
-    /* There is a large amount of operations needed to calculate the amount of lines dug by the player,
-        therefore for tidier code this is moved into a handler */
-
-    // Global Line Counter
-    int LineCount = 0;
-
-    // Collecting all dug patches
-    TArray<AFireSpreadPatch*> DugPatches = GetAllDugPatches();
-    UE_LOG(LogTemp, Warning, TEXT("Collected %d dug patches for fire line evaluation."), DugPatches.Num());
-
-    if (DugPatches.Num() == 0)
-	{
-        // If there are no dug patches then lines are persisted as 0
-        LineCount = 0;
-	}
-    else
-    {
-        UE_LOG(LogTemp, Warning, TEXT("Starting line calculation for %d dug patches."), DugPatches.Num());
-        LineCount = LineCalculator(DugPatches, LineCount);
-        UE_LOG(LogTemp, Warning, TEXT("Lines found %d."), LineCount);
-    }
-
-    if (UFireGameInstance* GI = Cast <UFireGameInstance>(GetGameInstance()))
-    {
-        GI->FinalLineCount = LineCount;
-    }
-}
-int AFireGameMode::LineCalculator(TArray<AFireSpreadPatch*> DugPatches, int LineCount)
-{
-    for (int32 i = DugPatches.Num() - 1; i >= 0; --i)
-    {
-        AFireSpreadPatch* CurrentPatch = DugPatches[i];
-        if (!CurrentPatch) continue;
-
-        bool bHasValidNeighbor = false;
-
-        UE_LOG(LogTemp, Warning, TEXT("Checking patch %s for valid neighbors..."), *CurrentPatch->GetName());
-        for (AFireSpreadPatch* Neighbor : CurrentPatch->AdjacentPatches)
-        {
-            if (!Neighbor || Neighbor == CurrentPatch) continue;
-            if (!Neighbor->bIsDug) continue;
-
-            UE_LOG(LogTemp, Warning, TEXT("Patch %s at (%f, %f)  Neighbor %s at (%f, %f)"),
-                *CurrentPatch->GetName(),
-                CurrentPatch->GetActorLocation().X, CurrentPatch->GetActorLocation().Y,
-                *Neighbor->GetName(),
-                Neighbor->GetActorLocation().X, Neighbor->GetActorLocation().Y);
-
-            ECompass Dir = GetDirectionBetween(CurrentPatch, Neighbor);
-            UE_LOG(LogTemp, Warning, TEXT("Neighbor %s classified as direction: %s"),
-                *Neighbor->GetName(),
-                *UEnum::GetValueAsString(Dir));
-
-            // Only count horizontal or vertical neighbors
-            if (Dir == ECompass::North || Dir == ECompass::South ||
-                Dir == ECompass::East || Dir == ECompass::West)
-            {
-                bHasValidNeighbor = true;
-                break;
-            }
-        }
-
-        // If no valid neighbors, remove this patch from the list
-        if (!bHasValidNeighbor)
-        {
-            UE_LOG(LogTemp, Warning, TEXT("No neighbours found for patch %s  removing from list."), *CurrentPatch->GetName());
-            DugPatches.RemoveAt(i);
-
-        }
-    }
-
-    // Find the neighbours for the current patch
-    for (AFireSpreadPatch* Patch : DugPatches)
-    {
-      if (!Patch || Patch->bVisitedForLineCheck) continue;
-
-      for (ECompass Dir : {ECompass::East, ECompass::North})
-      {
-          TArray<AFireSpreadPatch*> Line;
-
-          TraceLine(Patch, Dir, Line);
-          TraceLine(Patch, GetOppositeDirection(Dir), Line);
-
-          if (Line.Num() >= 3)
-          {
-            LineCount++;
-            UE_LOG(LogTemp, Warning, TEXT("Found line of %d patches starting at %s in direction %s"), Line.Num(), *Patch->GetName(), *UEnum::GetValueAsString(Dir));
-             
-            for (AFireSpreadPatch* LinePatch : Line)
-            {
-                LinePatch->bVisitedForLineCheck = true;
-            }
-          }
-      }
-    }
-    //UE_LOG(LogTemp, Warning, TEXT("Line calculation complete. Remaining patches: %d"), DugPatches.Num());
-    return LineCount;
-}
-
-
-ECompass  AFireGameMode::GetDirectionBetween(AFireSpreadPatch* From, AFireSpreadPatch* To)
-{
-    // Threshold to account for manual tile placement
-    float Threshold = 10.0f;
-
-    FVector Delta = To->GetActorLocation() - From->GetActorLocation();
-
-    bool bIsHorizontal = FMath::Abs(Delta.X) > Threshold && FMath::Abs(Delta.Y) < Threshold;
-    bool bIsVertical = FMath::Abs(Delta.Y) > Threshold && FMath::Abs(Delta.X) < Threshold;
-
-    if (bIsVertical)
-    {
-        return Delta.Y > 0 ? ECompass::North : ECompass::South;
-    }
-    else if (bIsHorizontal)
-    {
-        return Delta.X > 0 ? ECompass::East : ECompass::West;
-    }
-
-    return ECompass::None;
-}
-
-TArray<AFireSpreadPatch*> AFireGameMode::GetAllDugPatches()
-{
-    TArray<AFireSpreadPatch*> DugPatches;
-
-    TArray<AActor*> EndGameAllPatches;
-    UGameplayStatics::GetAllActorsOfClass(GetWorld(), AFireSpreadPatch::StaticClass(), EndGameAllPatches);
-
-    for (AActor* Actor : EndGameAllPatches)
-    {
-        AFireSpreadPatch* Patch = Cast<AFireSpreadPatch>(Actor);
-        if (Patch && Patch->bIsDug)
-        {
-            DugPatches.Add(Patch);
-        }
-    }
-
-    return DugPatches;
-}
-
-AFireSpreadPatch* AFireGameMode::GetNeighborInDirection(AFireSpreadPatch* From, ECompass Direction)
-{
-    for (AFireSpreadPatch* Neighbor : From->AdjacentPatches)
-    {
-        if (!Neighbor || !Neighbor->bIsDug) continue;
-
-        ECompass Dir = GetDirectionBetween(From, Neighbor);
-        if (Dir == Direction)
-        {
-            return Neighbor;
-        }
-    }
-    return nullptr;
-}
-
-ECompass AFireGameMode::GetOppositeDirection(ECompass Dir)
-{
-    switch (Dir)
-    {
-    case ECompass::North: return ECompass::South;
-    case ECompass::South: return ECompass::North;
-    case ECompass::East:  return ECompass::West;
-    case ECompass::West:  return ECompass::East;
-    default: return ECompass::None;
-    }
-}
-
-void AFireGameMode::TraceLine(AFireSpreadPatch* StartPatch, ECompass Direction, TArray<AFireSpreadPatch*>& OutLine)
-{
-    AFireSpreadPatch* Current = StartPatch;
-
-    while (Current)
-    {
-        if (Current->bVisitedForLineCheck) break;
-
-        OutLine.Add(Current);
-
-        AFireSpreadPatch* Next = GetNeighborInDirection(Current, Direction);
-        if (!Next || !Next->bIsDug || Next->bVisitedForLineCheck)
-            break;
-
-        Current = Next;
-    }
-}
+
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireGameMode.h"
+#include <Kismet/GameplayStatics.h>
+#include "FireGamePlayerController.h"
+#include "PlayerCharacter.h"
+#include "FireGameInstance.h"
+#include "AudioManager.h"
+#include "FireSpreadSubsystem.h"
+#include "FireSimulation.h"
+#include "Async/Async.h"
+#include "Engine/LevelStreaming.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/MemoryReader.h"
+
+namespace
+{
+    // When Play was pressed, kept outside the game mode since opening a level replaces it
+    double PlayRequestSeconds = 0.0;
+}
+
+
+AFireGameMode::AFireGameMode()
+{
+    DefaultPawnClass = nullptr; 
+    PlayerControllerClass = AFireGamePlayerController::StaticClass(); 
+    PrimaryActorTick.bCanEverTick = true;
+}
+
+void AFireGameMode::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
+    {
+        CurrentState = GI->PersistentState;
+        UE_LOG(LogTemp, Warning, TEXT("Restored game state from GameInstance: %d"), static_cast<uint8>(CurrentState));
+    }
+
+    UE_LOG(LogTemp, Warning, TEXT("GameMode BeginPlay - CurrentState: %d"), static_cast<uint8>(CurrentState));
+   
+    SpawnPlayerPawn();
+
+    if (CurrentState == EGameState::Playing)
+    {
+        StartPlayingState();
+    }
+    else if (CurrentState == EGameState::Intro)
+    {
+        // Load the gameplay level behind the intro so Play only has to show it
+        if (ULevelStreaming* GameplayLevel = FindStreamingLevel(GameplayLevelName))
+        {
+            GameplayLevel->SetShouldBeLoaded(true);
+            GameplayLevel->SetShouldBeVisible(false);
+        }
+    }
+}
+
+void AFireGameMode::SpawnPlayerPawn()
+{
+    APlayerController* PC = UGameplayStatics::GetPlayerController(this, 0);
+    if (PC && !PC->GetPawn() && DefaultPawnClass)
+    {
+        APawn* SpawnedPawn = GetWorld()->SpawnActor<APawn>(DefaultPawnClass, FVector::ZeroVector, FRotator::ZeroRotator);
+        if (SpawnedPawn)
+        {
+            PC->Possess(SpawnedPawn);
+        }
+    }
+}
+
+void AFireGameMode::StartPlayingState()
+{
+    SpawnPlayerPawn();
+
+    if (APawn* Pawn = UGameplayStatics::GetPlayerPawn(this, 0))
+    {
+        PlayerStartTransform = Pawn->GetActorTransform();
+    }
+
+    // The first tick from here is the first frame the player can act in
+    bAwaitingFirstPlayingFrame = PlayRequestSeconds > 0.0;
+    LevelShownSeconds = FPlatformTime::Seconds();
+
+    // Start Checking for game over conditions
+    GetWorldTimerManager().SetTimer(
+        GameOverCheckTimerHandle,
+        this,
+        &AFireGameMode::CheckGameOverConditions,
+        GameOverCheckInterval,
+        true
+    );
+
+    // Start checking for game win conditions
+    GetWorldTimerManager().SetTimer(
+        WinGameCheckTimerHandle,
+        this,
+        &AFireGameMode::CheckGameWinConditions,
+        GameWinCheckInterval,
+        true
+    );
+}
+
+void AFireGameMode::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    UpdateLevelStreaming();
+
+    // Used to count the current level time
+    if (CurrentState == EGameState::Playing && !bGameEnded)
+    {
+        LevelTimer += DeltaSeconds;
+    }
+}
+
+//  Game Over Conditions
+void AFireGameMode::CheckGameOverConditions()
+{
+    bool bIsOverPercentBurnt = EvaluateBurnPercentage();
+    bool bIsSpecialTilesDestroyed = EvaluateSpecialTiles();
+
+    if (bIsOverPercentBurnt)
+    {
+        if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
+        {
+
+            GI->FinalEndGameText = EndTextLoseByOverBurn;
+        }
+    }
+    else if (bIsSpecialTilesDestroyed)
+    {
+        if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
+        {
+
+            GI->FinalEndGameText = EndTextLoseBySpecialTiles;
+        }
+    }
+    else
+    {
+        if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
+        {
+
+            GI->FinalEndGameText = EndTextLoseByHealth;
+        }
+    }
+
+    if (bIsOverPercentBurnt || bIsSpecialTilesDestroyed)
+    {
+        GameOver();
+    }
+}
+
+void AFireGameMode::GameOver()
+{
+    if (bGameEnded) return;
+    bGameEnded = true;
+    bPlayerWon = false;
+	UE_LOG(LogTemp, Display, TEXT("Game Over Called!"));
+
+    // The results are scored during the delay before the results screen
+    StartFinalScore();
+
+    CallGameOverText();
+
+    // Only the first manager was ever used, so there is no need to gather them all
+    if (AAudioManager* Manager = Cast<AAudioManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AAudioManager::StaticClass())))
+    {
+        Manager->PlayLoseCue();
+    }
+
+    GetWorldTimerManager().SetTimer(
+        CallResultsTimerHandle,
+        this,
+        &AFireGameMode::CallResultsScreen,
+        ResultsScreenTimerInterval,
+        true
+    );
+}
+
+bool AFireGameMode::EvaluateBurnPercentage()
+{
+    // Patch actors and patch field tiles all live in the fire subsystem's tile table
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+    if (!FireSubsystem) return false;
+
+    const FFireStateCounters& Counters = FireSubsystem->GetStateSnapshot()->Counters;
+    if (Counters.NumBurnable == 0) return false;
+    BurnPercent = Counters.GetBurnPercent();
+
+    // Coarse cells only hold their burn to within a tile, so a close game is left to the per tile fire
+    const float Threshold = BurnedThresholdPercent / 100.0f;
+    if (FireSubsystem->GetNumCoarseCells() > 0 && FMath::Abs(BurnPercent - Threshold) <= FireSubsystem->GetLodBurnTolerance())
+    {
+        FireSubsystem->RefineCoarseCells(GameOverCheckInterval * 2.0f);
+    }
+
+    // Returns true or false if the burn percent is hire than the set threshold.
+    return BurnPercent >= Threshold;
+}
+
+bool AFireGameMode::ComputeBurnPercent(const FFireTileTable& Tiles, float& OutBurnPercent)
+{
+    int32 ValidBurnableCount = 0;
+    int32 BurntCount = 0;
+
+    // For all tiles check type
+    for (int32 Tile = 0; Tile < Tiles.Num(); ++Tile)
+    {
+        // Filter out unusable patch types
+        if (!Tiles.IsBurnableType(Tile)) continue;
+
+        ValidBurnableCount++;
+        if (Tiles.IsBurnt(Tile) || Tiles.IsBurning(Tile))
+            BurntCount++;
+    }
+
+    if (ValidBurnableCount == 0) return false;
+    OutBurnPercent = BurntCount / static_cast<float>(ValidBurnableCount);
+    return true;
+}
+
+bool AFireGameMode::EvaluateSpecialTiles()
+{
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+    if (!FireSubsystem) return false;
+
+    // Counted once when the snapshot was published
+    const FFireStateCounters& Counters = FireSubsystem->GetStateSnapshot()->Counters;
+
+    // Catch for if there was no special tiles
+    if (Counters.NumSpecial == 0) return false; 
+
+    return Counters.NumSpecialLost >= Counters.NumSpecial;
+}
+
+
+// Game Win Conditions 
+void AFireGameMode::CheckGameWinConditions()
+{
+    if (bGameEnded) return;
+
+    // Prevent win called immediately after start
+    const float MinGameTime = 10.0f; 
+    if (LevelTimer < MinGameTime) return;
+
+    bool bIsFireCompletelyGone = EvaluateFireExtinguished();
+
+    if (bIsFireCompletelyGone)
+    {
+        GameWin();
+    }
+}
+
+void AFireGameMode::GameWin()
+{
+    if (bGameEnded) return;
+    bGameEnded = true;
+    bPlayerWon = true;
+
+    UE_LOG(LogTemp, Display, TEXT("Game Win Called!"));
+
+    // The results are scored during the delay before the results screen
+    StartFinalScore();
+
+    // Used to set widget before end game
+    if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
+    {
+        GI->FinalEndGameText = EndTextWinByBurnout;
+    }
+    CallGameOverText();
+
+    // Only the first manager was ever used, so there is no need to gather them all
+    if (AAudioManager* Manager = Cast<AAudioManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AAudioManager::StaticClass())))
+    {
+        Manager->PlayWinCue();
+    }
+
+    GetWorldTimerManager().SetTimer(
+        CallResultsTimerHandle,
+        this,
+        &AFireGameMode::CallResultsScreen,
+        ResultsScreenTimerInterval,
+        true
+    );
+}
+
+bool AFireGameMode::EvaluateFireExtinguished()
+{
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+    if (!FireSubsystem) return true;
+
+    // If any tile is burning win has not been met
+    return FireSubsystem->GetStateSnapshot()->Counters.NumBurning == 0;
+}
+
+EGameState AFireGameMode::GetCurrentState() const
+{
+    return CurrentState;
+}
+
+void AFireGameMode::SetGameState(EGameState NewState)
+{
+    // If the state is already set then exit out 
+    if (CurrentState == NewState) return;
+
+    CurrentState = NewState;
+
+    if (UFireGameInstance* GI = Cast<UFireGameInstance>(GetGameInstance()))
+    {
+        GI->PersistentState = NewState;
+    }
+
+    // Tell the controller to update input mode
+    if (APlayerController* PC = UGameplayStatics::GetPlayerController(this, 0))
+    {
+        AFireGamePlayerController* FireController = Cast<AFireGamePlayerController>(PC);
+        if (FireController)
+        {
+            FireController->ApplyInputForGameState(NewState);
+        }
+    }
+   
+    // Game Controller
+    switch (CurrentState)
+    {
+        case EGameState::Intro:
+            UE_LOG(LogTemp, Display, TEXT("Intro State Activated"));
+            DefaultPawnClass = nullptr;
+            UGameplayStatics::OpenLevel(GetWorld(), IntroLevelName);
+            break;
+
+        case EGameState::Playing:
+        {
+            UE_LOG(LogTemp, Display, TEXT("Playing State Activated"));
+            DefaultPawnClass = APlayerCharacter::StaticClass();
+            PlayRequestSeconds = FPlatformTime::Seconds();
+
+            // Showing loading logic
+            AFireGamePlayerController* PC = Cast<AFireGamePlayerController>(UGameplayStatics::GetPlayerController(this, 0));
+            if (PC)
+            {
+                PC->ShowLoadingOverlay();
+            }
+
+            // Streamed in the background while the overlay shows progress, see UpdateLevelStreaming
+            if (StreamStateLevel(GameplayLevelName))
+            {
+                // This game mode carries on into the new game
+                ResetRunState();
+                break;
+            }
+
+            // Delay before level load so overlay can render
+            FTimerHandle LoadTimerHandle;
+            GetWorldTimerManager().SetTimer(
+                LoadTimerHandle,
+                [this]() {
+                    UGameplayStatics::OpenLevel(GetWorld(), GameplayLevelName);
+                },
+                0.5f, // Delay duration in seconds
+                false
+            );
+            break;
+        }
+        case EGameState::Results:
+            UE_LOG(LogTemp, Display, TEXT("Results State Activated"));
+            DefaultPawnClass = nullptr;
+            FetchEndScreenDetails();
+
+            if (StreamStateLevel(ResultsLevelName))
+            {
+                // The gameplay level is unloading, its tiles and the checks on them go with it
+                GetWorldTimerManager().ClearTimer(GameOverCheckTimerHandle);
+                GetWorldTimerManager().ClearTimer(WinGameCheckTimerHandle);
+                if (UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>())
+                {
+                    FireSubsystem->ResetTiles();
+                }
+
+                APlayerController* PC = UGameplayStatics::GetPlayerController(this, 0);
+                if (APawn* Pawn = PC ? PC->GetPawn() : nullptr)
+                {
+                    PC->UnPossess();
+                    Pawn->Destroy();
+                }
+                break;
+            }
+            UGameplayStatics::OpenLevel(GetWorld(), ResultsLevelName);
+            break;
+
+        case EGameState::Quitting:
+            UE_LOG(LogTemp, Display, TEXT("Quitting Game"));
+            // Allows space to add transition / exit messages
+            FGenericPlatformMisc::RequestExit(false);
+            break;
+
+        default:
+            UE_LOG(LogTemp, Display, TEXT("Unknown Game State in use."));
+            break;
+    }
+    
+}
+
+// Level Streaming
+ULevelStreaming* AFireGameMode::FindStreamingLevel(FName LevelName) const
+{
+    return LevelName.IsNone() ? nullptr : UGameplayStatics::GetStreamingLevel(GetWorld(), LevelName);
+}
+
+bool AFireGameMode::StreamStateLevel(FName LevelName)
+{
+    ULevelStreaming* TargetLevel = FindStreamingLevel(LevelName);
+    if (!TargetLevel) return false;
+
+    for (FName StateLevelName : { GameplayLevelName, ResultsLevelName })
+    {
+        ULevelStreaming* StateLevel = FindStreamingLevel(StateLevelName);
+        if (StateLevel && StateLevel != TargetLevel)
+        {
+            StateLevel->SetShouldBeVisible(false);
+            StateLevel->SetShouldBeLoaded(false);
+        }
+    }
+
+    TargetLevel->SetShouldBeLoaded(true);
+    TargetLevel->SetShouldBeVisible(true);
+
+    StreamingLevelName = LevelName;
+    LevelLoadProgress = 0.0f;
+    return true;
+}
+
+void AFireGameMode::UpdateLevelStreaming()
+{
+    if (bAwaitingFirstPlayingFrame)
+    {
+        bAwaitingFirstPlayingFrame = false;
+
+        const double Now = FPlatformTime::Seconds();
+        UE_LOG(LogTemp, Display, TEXT("Play to first interactive frame: %.0f ms (%.0f ms loading, %.0f ms starting)"),
+            (Now - PlayRequestSeconds) * 1000.0, (LevelShownSeconds - PlayRequestSeconds) * 1000.0, (Now - LevelShownSeconds) * 1000.0);
+        PlayRequestSeconds = 0.0;
+    }
+
+    if (StreamingLevelName.IsNone()) return;
+
+    ULevelStreaming* Level = FindStreamingLevel(StreamingLevelName);
+    AFireGamePlayerController* PC = Cast<AFireGamePlayerController>(UGameplayStatics::GetPlayerController(this, 0));
+
+    if (!Level || Level->IsLevelVisible())
+    {
+        LevelLoadProgress = 1.0f;
+        if (PC)
+        {
+            PC->SetLoadingProgress(LevelLoadProgress);
+        }
+        OnStateLevelShown();
+        return;
+    }
+
+    // Loading the package is most of the wait, adding the loaded level to the world is the rest
+    float Progress = 0.9f;
+    if (!Level->IsLevelLoaded())
+    {
+        const float LoadPercent = GetAsyncLoadPercentage(Level->GetWorldAssetPackageFName());
+        Progress = LoadPercent >= 0.0f ? 0.9f * LoadPercent / 100.0f : 0.0f;
+    }
+
+    LevelLoadProgress = FMath::Max(LevelLoadProgress, Progress);
+    if (PC)
+    {
+        PC->SetLoadingProgress(LevelLoadProgress);
+    }
+}
+
+void AFireGameMode::OnStateLevelShown()
+{
+    UE_LOG(LogTemp, Display, TEXT("Streamed in %s"), *StreamingLevelName.ToString());
+    StreamingLevelName = NAME_None;
+
+    AFireGamePlayerController* PC = Cast<AFireGamePlayerController>(UGameplayStatics::GetPlayerController(this, 0));
+    if (PC)
+    {
+        PC->HideLoadingOverlay();
+        PC->HideGameOverText();
+    }
+
+    if (CurrentState == EGameState::Playing)
+    {
+        StartPlayingState();
+
+        // Input is set up again now there is a pawn to enable it on
+        if (PC)
+        {
+            PC->ApplyInputForGameState(CurrentState);
+        }
+    }
+}
+
+void AFireGameMode::ResetRunState()
+{
+    GetWorldTimerManager().ClearTimer(GameOverCheckTimerHandle);
+    GetWorldTimerManager().ClearTimer(WinGameCheckTimerHandle);
+    GetWorldTimerManager().ClearTimer(CallResultsTimerHandle);
+
+    bGameEnded = false;
+    bPlayerWon = false;
+    LevelTimer = 0.0f;
+    BurnPercent = 0.0f;
+    SavedPercent = 0;
+    PendingFinalScore.Reset();
+}
+
+void AFireGameMode::RetryLevel()
+{
+    if (CurrentState != EGameState::Playing)
+    {
+        SetGameState(EGameState::Playing);
+        return;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("Retrying level in place"));
+    PlayRequestSeconds = FPlatformTime::Seconds();
+
+    // Check and results screen timers, the level timer and the end of game flag
+    ResetRunState();
+
+    if (UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>())
+    {
+        FireSubsystem->ResetToAuthoredState();
+    }
+
+    APlayerController* PC = UGameplayStatics::GetPlayerController(this, 0);
+    if (APlayerCharacter* Player = PC ? Cast<APlayerCharacter>(PC->GetPawn()) : nullptr)
+    {
+        Player->ResetTools();
+        Player->GetCharacterMovement()->StopMovementImmediately();
+        Player->SetActorTransform(PlayerStartTransform, false, nullptr, ETeleportType::ResetPhysics);
+        PC->SetControlRotation(PlayerStartTransform.Rotator());
+    }
+
+    if (AFireGamePlayerController* FireController = Cast<AFireGamePlayerController>(PC))
+    {
+        FireController->HideGameOverText();
+        FireController->ApplyInputForGameState(CurrentState);
+    }
+
+    if (AAudioManager* Manager = Cast<AAudioManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AAudioManager::StaticClass())))
+    {
+        Manager->ResetAudio();
+    }
+
+    StartPlayingState();
+}
+
+void AFireGameMode::CallResultsScreen()
+{
+    GetWorldTimerManager().ClearTimer(CallResultsTimerHandle);
+    SetGameState(EGameState::Results);
+}
+
+float AFireGameMode::GetThresholdForRank(EGameRank Rank)
+{
+    switch (Rank)
+    {
+    case EGameRank::SS: return 80.0f;
+    case EGameRank::S:  return 70.0f;
+    case EGameRank::A:  return 60.0f;
+    case EGameRank::B:  return 50.0f;
+    case EGameRank::C:  return 40.0f;
+    case EGameRank::D:  return 0.0f;
+    default: return 0.0f;
+    }
+}
+
+void AFireGameMode::FetchEndScreenDetails()
+{
+    UE_LOG(LogTemp, Warning, TEXT("Final level time: %.2f seconds"), LevelTimer);
+
+    // Normally finished long before the results screen, only scored here if the game never ended
+    if (!PendingFinalScore.IsValid())
+    {
+        StartFinalScore();
+    }
+    const FFireFinalScore Score = PendingFinalScore.Get();
+    PendingFinalScore.Reset();
+
+    BurnPercent = Score.BurnPercent;
+    SavedPercent = Score.SavedPercent;
+    FinalRank = Score.Rank;
+
+    UE_LOG(LogTemp, Display, TEXT("Lines: %d, BurnPercent: %f, SavedPercent: %d"), Score.LineCount, BurnPercent, SavedPercent);
+
+    // Persist this to the Game Instance 
+    if (UFireGameInstance* GI = Cast <UFireGameInstance>(GetGameInstance()))
+    {
+        GI->FinalLineCount = Score.LineCount;
+        GI->FinalSavedPercent = SavedPercent;
+        GI->FinalSavedRank = FinalRank;
+        GI->FinalLevelDuration = LevelTimer;
+
+    }
+}
+
+void AFireGameMode::StartFinalScore()
+{
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+
+    // Copied here, the fire and the game mode can change or go away while the task runs
+    FFireTileTable Tiles = FireSubsystem ? FireSubsystem->GetTiles() : FFireTileTable();
+    FFireSimParams Rules;
+    for (int32 Rank = 0; Rank < UE_ARRAY_COUNT(Rules.RankThresholds); ++Rank)
+    {
+        Rules.RankThresholds[Rank] = GetThresholdForRank(static_cast<EGameRank>(Rank));
+    }
+
+    PendingFinalScore = Async(EAsyncExecution::ThreadPool, [Tiles = MoveTemp(Tiles), Rules, bWon = bPlayerWon]()
+        {
+            return ComputeFinalScore(Tiles, bWon, Rules);
+        });
+}
+
+FFireFinalScore AFireGameMode::ComputeFinalScore(const FFireTileTable& Tiles, bool bWon, const FFireSimParams& Rules)
+{
+    FFireFinalScore Score;
+
+    TArray<int32> DugTiles = GetAllDugTiles(Tiles);
+    if (DugTiles.Num() > 0)
+    {
+        Score.LineCount = LineCalculator(Tiles, MoveTemp(DugTiles), 0);
+    }
+
+    ComputeBurnPercent(Tiles, Score.BurnPercent);
+
+    if (!bWon)
+    {
+        // Player lost — assign E rank and a default score
+        Score.Rank = EGameRank::E;
+        Score.SavedPercent = 0;
+    }
+    else
+    {
+        // Highest rank whose threshold the saved percent reaches
+        Score.SavedPercent = FMath::RoundToInt(100.0f - Score.BurnPercent * 100.0f);
+        Score.Rank = Rules.GetRank(Score.SavedPercent);
+    }
+    return Score;
+}
+
+void AFireGameMode::CallGameOverText()
+{
+    AFireGamePlayerController* PC = Cast<AFireGamePlayerController>(UGameplayStatics::GetPlayerController(this, 0));
+    if (PC)
+    {
+        PC->ShowGameOverText();
+    }
+}
+
+int AFireGameMode::LineCalculator(const FFireTileTable& Tiles, TArray<int32> DugTiles, int LineCount)
+{
+    // Tiles already counted in a line
+    TBitArray<> VisitedForLineCheck(false, Tiles.Num());
+
+    for (int32 i = DugTiles.Num() - 1; i >= 0; --i)
+    {
+        const int32 CurrentTile = DugTiles[i];
+
+        bool bHasValidNeighbor = false;
+
+        UE_LOG(LogTemp, Verbose, TEXT("Checking tile %d for valid neighbors..."), CurrentTile);
+        for (int32 Neighbor : Tiles.Neighbours[CurrentTile])
+        {
+            if (Neighbor == CurrentTile) continue;
+            if (!Tiles.IsDug(Neighbor)) continue;
+
+            ECompass Dir = GetDirectionBetween(Tiles, CurrentTile, Neighbor);
+            UE_LOG(LogTemp, Verbose, TEXT("Tile %d at (%f, %f) — Neighbor %d at (%f, %f) classified as direction: %s"),
+                CurrentTile, Tiles.Locations[CurrentTile].X, Tiles.Locations[CurrentTile].Y,
+                Neighbor, Tiles.Locations[Neighbor].X, Tiles.Locations[Neighbor].Y,
+                *UEnum::GetValueAsString(Dir));
+
+            // Only count horizontal or vertical neighbors
+            if (Dir == ECompass::North || Dir == ECompass::South ||
+                Dir == ECompass::East || Dir == ECompass::West)
+            {
+                bHasValidNeighbor = true;
+                break;
+            }
+        }
+
+        // If no valid neighbors, remove this patch from the list
+        if (!bHasValidNeighbor)
+        {
+            UE_LOG(LogTemp, Verbose, TEXT("No neighbours found for tile %d — removing from list."), CurrentTile);
+            DugTiles.RemoveAt(i);
+
+        }
+    }
+
+    // Find the neighbours for the current patch
+    for (int32 Tile : DugTiles)
+    {
+      if (VisitedForLineCheck[Tile]) continue;
+
+      for (ECompass Dir : {ECompass::East, ECompass::North})
+      {
+          TArray<int32> Line;
+
+          TraceLine(Tiles, VisitedForLineCheck, Tile, Dir, Line);
+          TraceLine(Tiles, VisitedForLineCheck, Tile, GetOppositeDirection(Dir), Line);
+
+          if (Line.Num() >= 3)
+          {
+            LineCount++;
+            UE_LOG(LogTemp, Verbose, TEXT("Found line of %d patches starting at tile %d in direction %s"), Line.Num(), Tile, *UEnum::GetValueAsString(Dir));
+             
+            for (int32 LineTile : Line)
+            {
+                VisitedForLineCheck[LineTile] = true;
+            }
+          }
+      }
+    }
+    //UE_LOG(LogTemp, Warning, TEXT("Line calculation complete. Remaining patches: %d"), DugTiles.Num());
+    return LineCount;
+}
+
+
+ECompass  AFireGameMode::GetDirectionBetween(const FFireTileTable& Tiles, int32 FromTile, int32 ToTile)
+{
+    // Threshold to account for manual tile placement
+    float Threshold = 10.0f;
+
+    FVector3f Delta = Tiles.Locations[ToTile] - Tiles.Locations[FromTile];
+
+    bool bIsHorizontal = FMath::Abs(Delta.X) > Threshold && FMath::Abs(Delta.Y) < Threshold;
+    bool bIsVertical = FMath::Abs(Delta.Y) > Threshold && FMath::Abs(Delta.X) < Threshold;
+
+    if (bIsVertical)
+    {
+        return Delta.Y > 0 ? ECompass::North : ECompass::South;
+    }
+    else if (bIsHorizontal)
+    {
+        return Delta.X > 0 ? ECompass::East : ECompass::West;
+    }
+
+    return ECompass::None;
+}
+
+TArray<int32> AFireGameMode::GetAllDugTiles(const FFireTileTable& Tiles)
+{
+    TArray<int32> DugTiles;
+
+    for (int32 Tile = 0; Tile < Tiles.Num(); ++Tile)
+    {
+        if (Tiles.IsDug(Tile))
+        {
+            DugTiles.Add(Tile);
+        }
+    }
+
+    return DugTiles;
+}
+
+int32 AFireGameMode::GetNeighborInDirection(const FFireTileTable& Tiles, int32 FromTile, ECompass Direction)
+{
+    for (int32 Neighbor : Tiles.Neighbours[FromTile])
+    {
+        if (!Tiles.IsDug(Neighbor)) continue;
+
+        ECompass Dir = GetDirectionBetween(Tiles, FromTile, Neighbor);
+        if (Dir == Direction)
+        {
+            return Neighbor;
+        }
+    }
+    return INDEX_NONE;
+}
+
+ECompass AFireGameMode::GetOppositeDirection(ECompass Dir)
+{
+    switch (Dir)
+    {
+    case ECompass::North: return ECompass::South;
+    case ECompass::South: return ECompass::North;
+    case ECompass::East:  return ECompass::West;
+    case ECompass::West:  return ECompass::East;
+    default: return ECompass::None;
+    }
+}
+
+void AFireGameMode::TraceLine(const FFireTileTable& Tiles, const TBitArray<>& Visited, int32 StartTile, ECompass Direction, TArray<int32>& OutLine)
+{
+    int32 Current = StartTile;
+
+    while (Current != INDEX_NONE)
+    {
+        if (Visited[Current]) break;
+
+        OutLine.Add(Current);
+
+        int32 Next = GetNeighborInDirection(Tiles, Current, Direction);
+        if (Next == INDEX_NONE || Visited[Next])
+            break;
+
+        Current = Next;
+    }
+}
+
+// Fire Snapshots
+FString AFireGameMode::GetFireSnapshotPath(const FString& SlotName) const
+{
+    return FPaths::ProjectSavedDir() / TEXT("FireSnapshots") / (SlotName + TEXT(".fsnap"));
+}
+
+bool AFireGameMode::SaveFireSnapshot(const FString& SlotName)
+{
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+    if (!FireSubsystem) return false;
+
+    TArray<uint8> FireState;
+    FireSubsystem->SaveSnapshot(FireState);
+
+    FBufferArchive Archive;
+    Archive << LevelTimer;
+    Archive << FireState;
+
+    const FString FilePath = GetFireSnapshotPath(SlotName);
+    if (!FFileHelper::SaveArrayToFile(Archive, *FilePath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Could not write fire snapshot %s"), *FilePath);
+        return false;
+    }
+
+    UE_LOG(LogTemp, Warning, TEXT("Fire snapshot saved to %s"), *FilePath);
+    return true;
+}
+
+bool AFireGameMode::LoadFireSnapshot(const FString& SlotName)
+{
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+    if (!FireSubsystem) return false;
+
+    const FString FilePath = GetFireSnapshotPath(SlotName);
+    TArray<uint8> FileData;
+    if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Could not read fire snapshot %s"), *FilePath);
+        return false;
+    }
+
+    FMemoryReader Archive(FileData);
+    float SavedLevelTimer = 0.0f;
+    TArray<uint8> FireState;
+    Archive << SavedLevelTimer;
+    Archive << FireState;
+
+    if (Archive.IsError() || !FireSubsystem->RestoreSnapshot(FireState))
+    {
+        return false;
+    }
+
+    LevelTimer = SavedLevelTimer;
+    UE_LOG(LogTemp, Warning, TEXT("Fire snapshot loaded from %s"), *FilePath);
+    return true;
+}
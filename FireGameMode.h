@@ -1,183 +1,257 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "FireSpreadPatch.h"
-#include "CoreMinimal.h"
-#include "GameFramework/GameModeBase.h"
-#include "FireGameMode.generated.h"
-
-UENUM(BlueprintType)
-enum class EGameRank : uint8
-{
-	SS,
-	S,
-	A,
-	B,
-	C,
-	D, 
-	E // Only used for game lose
-};
-
-UENUM(BlueprintType, meta = (ScriptName = "BrightSparksGameStateEnum"))
-enum class EGameState : uint8
-{
-	Intro,
-	Playing,
-	Results,
-	Quitting
-};
-
-// Used for getting the final dug line count
-UENUM(BlueprintType)
-enum class ECompass : uint8
-{
-	None,
-	North,
-	East,
-	South,
-	West
-};
-
-UCLASS()
-class BRIGHTSPARKSPROJECT_API AFireGameMode : public AGameModeBase
-{
-	GENERATED_BODY()
-
-public:
-	AFireGameMode();
-	virtual void BeginPlay() override;
-	void Tick(float DeltaSeconds) override;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
-	float BurnedThresholdPercent = 70.f;
-
-	UFUNCTION(BlueprintCallable, Category = "Game Over")
-	void CheckGameOverConditions();
-
-	UFUNCTION(BlueprintCallable, Category = "Game Over")
-	void GameOver();
-
-	UFUNCTION(BlueprintCallable, Category = "Game Over")
-	bool EvaluateBurnPercentage();
-
-	UFUNCTION(BlueprintCallable, Category = "Game Over")
-	bool EvaluateSpecialTiles();
-
-	TArray<AFireSpreadPatch*> AllPatches;
-
-	UFUNCTION(BlueprintCallable, Category = "Game Win")
-	void CheckGameWinConditions();
-
-	UFUNCTION(BlueprintCallable, Category = "Game Win")
-	void GameWin();
-
-	UFUNCTION(BlueprintCallable, Category = "Game Win")
-	bool EvaluateFireExtinguished();
-
-	EGameState GetCurrentState() const;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
-	bool bGameEnded = false;
-
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Game Control")
-	float  BurnPercent = 0.0f;
-
-	// Setup for the game over timer 
-	FTimerHandle GameOverCheckTimerHandle;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
-	float GameOverCheckInterval = 2.0f;
-
-	// Setup for the game win timer 
-	FTimerHandle WinGameCheckTimerHandle;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
-	float GameWinCheckInterval = 2.0f;
-
-	// Setup for the Results Screen Timer
-	FTimerHandle CallResultsTimerHandle;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
-	float ResultsScreenTimerInterval = 5.0f;
-
-	// Game State Logic
-	UPROPERTY(BlueprintReadOnly, Category = "Game State")
-	EGameState CurrentState = EGameState::Intro;
-
-	UFUNCTION(BlueprintCallable, Category = "Game State")
-	void SetGameState(EGameState NewState);
-
-	void CallResultsScreen();
-
-	// Level Set Ups 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game State")
-	FName IntroLevelName;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game State")
-	FName GameplayLevelName;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game State")
-	FName ResultsLevelName;
-
-	// Game Rank Code 
-	UFUNCTION(BlueprintCallable, Category = "Game Rank")
-	float GetThresholdForRank(EGameRank Rank);
-
-	UFUNCTION(BlueprintCallable, Category = "Game Rank")
-	void FetchEndScreenDetails();
-
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Game Rank")
-	int  SavedPercent = 0;
-
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Game Rank")
-	EGameRank FinalRank;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Game Rank")
-	bool bPlayerWon = false;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Game Rank")
-	float LevelTimer = 0.0f;
-
-	// End Text (Loads before results screen)
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Endgame Text")
-	FText EndTextWinByBurnout;
-
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Endgame Text")
-	FText EndTextLoseByHealth;
-
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Endgame Text")
-	FText EndTextLoseBySpecialTiles;
-
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Endgame Text")
-	FText EndTextLoseByOverBurn;
-
-	UFUNCTION()
-	void CallGameOverText();
-
-	// METHODS FOR FIRE LINE CALCULATOR
-	UFUNCTION()
-	void FireLineCalculatorHandler();
-
-	UFUNCTION()
-	TArray<AFireSpreadPatch*> GetAllDugPatches();
-
-	UFUNCTION()
-	int LineCalculator(TArray<AFireSpreadPatch*> DugPatches, int LineCount);
-
-	UFUNCTION()
-	ECompass GetDirectionBetween(AFireSpreadPatch* From, AFireSpreadPatch* To);
-
-	UFUNCTION()
-	AFireSpreadPatch* GetNeighborInDirection(AFireSpreadPatch* From, ECompass Direction);
-
-	UFUNCTION()
-	ECompass GetOppositeDirection(ECompass Dir);
-
-	UFUNCTION()
-	void TraceLine(AFireSpreadPatch* StartPatch, ECompass Direction, TArray<AFireSpreadPatch*>& OutLine);
-
-
-
-};
-
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "FireSpreadPatch.h"
+#include "FireTileTable.h"
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "GameFramework/GameModeBase.h"
+#include "FireGameMode.generated.h"
+
+UENUM(BlueprintType)
+enum class EGameRank : uint8
+{
+	SS,
+	S,
+	A,
+	B,
+	C,
+	D, 
+	E // Only used for game lose
+};
+
+UENUM(BlueprintType, meta = (ScriptName = "BrightSparksGameStateEnum"))
+enum class EGameState : uint8
+{
+	Intro,
+	Playing,
+	Results,
+	Quitting
+};
+
+// Used for getting the final dug line count
+UENUM(BlueprintType)
+enum class ECompass : uint8
+{
+	None,
+	North,
+	East,
+	South,
+	West
+};
+
+struct FFireSimParams;
+class ULevelStreaming;
+
+// Results screen values, worked out from a copy of the tiles so they can be computed off the game thread
+struct FFireFinalScore
+{
+	int32 LineCount = 0;
+	float BurnPercent = 0.0f;
+	int32 SavedPercent = 0;
+	EGameRank Rank = EGameRank::E;
+};
+
+UCLASS()
+class BRIGHTSPARKSPROJECT_API AFireGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	AFireGameMode();
+	virtual void BeginPlay() override;
+	void Tick(float DeltaSeconds) override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
+	float BurnedThresholdPercent = 70.f;
+
+	UFUNCTION(BlueprintCallable, Category = "Game Over")
+	void CheckGameOverConditions();
+
+	UFUNCTION(BlueprintCallable, Category = "Game Over")
+	void GameOver();
+
+	UFUNCTION(BlueprintCallable, Category = "Game Over")
+	bool EvaluateBurnPercentage();
+
+	UFUNCTION(BlueprintCallable, Category = "Game Over")
+	bool EvaluateSpecialTiles();
+
+	TArray<AFireSpreadPatch*> AllPatches;
+
+	UFUNCTION(BlueprintCallable, Category = "Game Win")
+	void CheckGameWinConditions();
+
+	UFUNCTION(BlueprintCallable, Category = "Game Win")
+	void GameWin();
+
+	UFUNCTION(BlueprintCallable, Category = "Game Win")
+	bool EvaluateFireExtinguished();
+
+	EGameState GetCurrentState() const;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
+	bool bGameEnded = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Game Control")
+	float  BurnPercent = 0.0f;
+
+	// Setup for the game over timer 
+	FTimerHandle GameOverCheckTimerHandle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
+	float GameOverCheckInterval = 2.0f;
+
+	// Setup for the game win timer 
+	FTimerHandle WinGameCheckTimerHandle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
+	float GameWinCheckInterval = 2.0f;
+
+	// Setup for the Results Screen Timer
+	FTimerHandle CallResultsTimerHandle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game Control")
+	float ResultsScreenTimerInterval = 5.0f;
+
+	// Game State Logic
+	UPROPERTY(BlueprintReadOnly, Category = "Game State")
+	EGameState CurrentState = EGameState::Intro;
+
+	UFUNCTION(BlueprintCallable, Category = "Game State")
+	void SetGameState(EGameState NewState);
+
+	void CallResultsScreen();
+
+	// Level Set Ups 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game State")
+	FName IntroLevelName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game State")
+	FName GameplayLevelName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Game State")
+	FName ResultsLevelName;
+
+	// Level Streaming
+	/*
+		When the gameplay and results levels are sublevels of the loaded persistent level they are
+		streamed in and out instead of opened, and the gameplay level is loaded in the background
+		while the intro runs. Levels that are not sublevels are opened as before.
+	*/
+	ULevelStreaming* FindStreamingLevel(FName LevelName) const;
+
+	// Starts loading LevelName and the other state levels unloading, false if it is not a sublevel
+	bool StreamStateLevel(FName LevelName);
+
+	// Progress of the level being streamed in, 1 once it is shown
+	UPROPERTY(BlueprintReadOnly, Category = "Game State")
+	float LevelLoadProgress = 0.0f;
+
+	// Spawns the player pawn and starts the game over / win checks
+	void StartPlayingState();
+
+	// Puts the run counters back for another game, the persistent game mode lives across streamed games
+	void ResetRunState();
+
+	/*
+		Plays the level again from the start. While playing, the tiles, objects, audio and player
+		are put back to their authored state in place instead of loading the level again, from
+		any other state it is the same as SetGameState(Playing).
+	*/
+	UFUNCTION(Exec, BlueprintCallable, Category = "Game State")
+	void RetryLevel();
+
+	// Game Rank Code 
+	UFUNCTION(BlueprintCallable, Category = "Game Rank")
+	float GetThresholdForRank(EGameRank Rank);
+
+	UFUNCTION(BlueprintCallable, Category = "Game Rank")
+	void FetchEndScreenDetails();
+
+	// Copies the tiles and starts scoring them on a background task, called as the game ends
+	void StartFinalScore();
+
+	// Thread safe, Rules supplies the rank thresholds
+	static FFireFinalScore ComputeFinalScore(const FFireTileTable& Tiles, bool bWon, const FFireSimParams& Rules);
+
+	// Share of burnable tiles burning or burnt, false if the level has no burnable tiles
+	static bool ComputeBurnPercent(const FFireTileTable& Tiles, float& OutBurnPercent);
+
+	// Scoring of the ended game, taken by FetchEndScreenDetails
+	TFuture<FFireFinalScore> PendingFinalScore;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Game Rank")
+	int  SavedPercent = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Game Rank")
+	EGameRank FinalRank;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Game Rank")
+	bool bPlayerWon = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Game Rank")
+	float LevelTimer = 0.0f;
+
+	// End Text (Loads before results screen)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Endgame Text")
+	FText EndTextWinByBurnout;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Endgame Text")
+	FText EndTextLoseByHealth;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Endgame Text")
+	FText EndTextLoseBySpecialTiles;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Endgame Text")
+	FText EndTextLoseByOverBurn;
+
+	UFUNCTION()
+	void CallGameOverText();
+
+	// METHODS FOR FIRE LINE CALCULATOR
+	// The calculator works on tile indices of a tile table, it reads no actors so it can run on any thread
+	static TArray<int32> GetAllDugTiles(const FFireTileTable& Tiles);
+
+	static int LineCalculator(const FFireTileTable& Tiles, TArray<int32> DugTiles, int LineCount);
+
+	static ECompass GetDirectionBetween(const FFireTileTable& Tiles, int32 FromTile, int32 ToTile);
+
+	// INDEX_NONE when there is no dug neighbour that way
+	static int32 GetNeighborInDirection(const FFireTileTable& Tiles, int32 FromTile, ECompass Direction);
+
+	UFUNCTION()
+	static ECompass GetOppositeDirection(ECompass Dir);
+
+	// Visited holds the tiles already counted in a line
+	static void TraceLine(const FFireTileTable& Tiles, const TBitArray<>& Visited, int32 StartTile, ECompass Direction, TArray<int32>& OutLine);
+
+	// Fire Snapshots
+	// Writes the level timer and the fire subsystem snapshot to Saved/FireSnapshots/<SlotName>.fsnap
+	UFUNCTION(Exec, BlueprintCallable, Category = "Fire Snapshot")
+	bool SaveFireSnapshot(const FString& SlotName);
+
+	// Restores a snapshot saved on this level, the level has to be loaded and playing already
+	UFUNCTION(Exec, BlueprintCallable, Category = "Fire Snapshot")
+	bool LoadFireSnapshot(const FString& SlotName);
+
+	FString GetFireSnapshotPath(const FString& SlotName) const;
+
+private:
+	void SpawnPlayerPawn();
+	void UpdateLevelStreaming();
+	void OnStateLevelShown();
+
+	// State level being streamed in, None when nothing is waiting
+	FName StreamingLevelName;
+	double LevelShownSeconds = 0.0;
+
+	// Where the player was when the game started, a retry puts them back there
+	FTransform PlayerStartTransform;
+	bool bAwaitingFirstPlayingFrame = false;
+
+
+
+};
+
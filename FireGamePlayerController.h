@@ -1,38 +1,58 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/PlayerController.h"
-#include "FireGameMode.h"
-#include "FireGamePlayerController.generated.h"
-
-
-UCLASS()
-class BRIGHTSPARKSPROJECT_API AFireGamePlayerController : public APlayerController
-{
-	GENERATED_BODY()
-
-public:
-	void BeginPlay();
-	void ApplyInputForGameState(EGameState GameState);
-
-	// Loading Wdiget
-	void ShowLoadingOverlay();
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Loading")
-	TSubclassOf<UUserWidget> LoadingOverlayClass;
-
-	UPROPERTY()
-	UUserWidget* ActiveLoadingWidget;
-
-	// Game Over Text Widget
-	UFUNCTION(Category = "UI")
-	void ShowGameOverText();
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UI")
-	TSubclassOf<UUserWidget> GameOverMessageWidgetClass;
-
-	UPROPERTY()
-	UUserWidget* ActiveGameOverWidget;
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerController.h"
+#include "FireGameMode.h"
+#include "FireReplicationComponent.h"
+#include "FireGamePlayerController.generated.h"
+
+
+UCLASS()
+class BRIGHTSPARKSPROJECT_API AFireGamePlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	AFireGamePlayerController();
+
+	void BeginPlay();
+	void ApplyInputForGameState(EGameState GameState);
+
+	// Loading Wdiget
+	void ShowLoadingOverlay();
+	void HideLoadingOverlay();
+
+	// 0 to 1 while a level streams in, the overlay's progress bar can bind to LoadingProgress
+	void SetLoadingProgress(float Progress);
+
+	UPROPERTY(BlueprintReadOnly, Category = "Loading")
+	float LoadingProgress = 0.0f;
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Loading")
+	void OnLoadingProgress(float Progress);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Loading")
+	TSubclassOf<UUserWidget> LoadingOverlayClass;
+
+	UPROPERTY()
+	UUserWidget* ActiveLoadingWidget;
+
+	// Game Over Text Widget
+	UFUNCTION(Category = "UI")
+	void ShowGameOverText();
+
+	// Opening a level clears the viewport, streamed levels have to take the text down themselves
+	void HideGameOverText();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UI")
+	TSubclassOf<UUserWidget> GameOverMessageWidgetClass;
+
+	UPROPERTY()
+	UUserWidget* ActiveGameOverWidget;
+
+	// Receives fire tile states from the server when this is a network client
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Fire Replication")
+	UFireReplicationComponent* FireReplication;
+};
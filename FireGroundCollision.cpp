@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireGroundCollision.h"
+#include "PhysicsEngine/BodySetup.h"
+
+UFireGroundCollisionComponent::UFireGroundCollisionComponent()
+{
+    PrimaryComponentTick.bCanEverTick = false;
+    SetHiddenInGame(true);
+
+    // Same collision as the patch DetectionVolume had, tool and object traces block on it and nothing else does
+    SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+    SetCollisionObjectType(ECC_WorldDynamic);
+    SetCollisionResponseToAllChannels(ECR_Ignore);
+    SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
+    SetGenerateOverlapEvents(false);
+    CanCharacterStepUpOn = ECB_No;
+}
+
+void UFireGroundCollisionComponent::SetBoxes(TArray<FKBoxElem>&& Boxes)
+{
+    if (!BodySetup)
+    {
+        BodySetup = NewObject<UBodySetup>(this, NAME_None, RF_Transient);
+        BodySetup->CollisionTraceFlag = CTF_UseSimpleAsComplex;
+        BodySetup->BodySetupGuid = FGuid::NewGuid();
+    }
+
+    BodySetup->AggGeom.BoxElems = MoveTemp(Boxes);
+    BodySetup->InvalidatePhysicsData();
+    BodySetup->CreatePhysicsMeshes();
+
+    RecreatePhysicsState();
+    UpdateBounds();
+}
+
+int32 UFireGroundCollisionComponent::GetNumBoxes() const
+{
+    return BodySetup ? BodySetup->AggGeom.BoxElems.Num() : 0;
+}
+
+FBoxSphereBounds UFireGroundCollisionComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+    if (!BodySetup || BodySetup->AggGeom.BoxElems.Num() == 0)
+    {
+        return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.0f);
+    }
+    return FBoxSphereBounds(BodySetup->AggGeom.CalcAABB(LocalToWorld));
+}
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "PhysicsEngine/BoxElem.h"
+#include "FireGroundCollision.generated.h"
+
+class UBodySetup;
+
+/*
+	One query only body with a box per fire patch and per patch field row, standing in for the
+	physics body every patch and field instance used to have. Traces on the visibility channel hit
+	this component and the fire subsystem maps the impact point back to a tile, see
+	UFireSpreadSubsystem::GetTileIndexFromHit. Sits at the world origin, boxes are in world space.
+*/
+UCLASS()
+class BRIGHTSPARKSPROJECT_API UFireGroundCollisionComponent : public UPrimitiveComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFireGroundCollisionComponent();
+
+	// Replaces every box and recreates the body
+	void SetBoxes(TArray<FKBoxElem>&& Boxes);
+	int32 GetNumBoxes() const;
+
+	virtual UBodySetup* GetBodySetup() override { return BodySetup; }
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+
+private:
+	UPROPERTY(Transient)
+	UBodySetup* BodySetup = nullptr;
+};
@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireHeatField.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+    // Columns stepped together down a grid, three rows of a block stay in cache while the next row is read
+    constexpr int32 HeatBlockColumns = 512;
+}
+
+FFireHeatMaterial FFireHeatMaterial::ForType(ESurfaceBurnType Type)
+{
+    // Quick tiles light sooner and pass heat on faster, like their shorter spread delays
+    FFireHeatMaterial Material;
+    switch (Type)
+    {
+    case ESurfaceBurnType::Quick:
+        Material.Conductivity = 0.15f;
+        Material.IgnitionTemperature = 1.0f;
+        Material.HeatRate = 3.0f;
+        break;
+    case ESurfaceBurnType::Slow:
+        Material.Conductivity = 0.08f;
+        Material.IgnitionTemperature = 1.6f;
+        Material.HeatRate = 2.0f;
+        break;
+    case ESurfaceBurnType::NonBurnable:
+        Material.Conductivity = 0.05f;
+        break;
+    case ESurfaceBurnType::Burnt:
+        Material.Conductivity = 0.1f;
+        break;
+    default:
+        // Dug earth is a firebreak
+        break;
+    }
+    return Material;
+}
+
+void FFireHeatField::Init(const FFireTileTable& Tiles, TArrayView<const FFireHeatGrid> InGrids)
+{
+    const int32 NumTiles = Tiles.Num();
+    Grids = InGrids;
+
+    Temperature.SetNumZeroed(NumTiles);
+    NextTemperature.SetNumZeroed(NumTiles);
+    Conductivity.SetNumZeroed(NumTiles);
+    Ignition.SetNumZeroed(NumTiles);
+    Source.SetNumZeroed(NumTiles);
+    SyncedVisuals.Init(EFireTileVisual::Unburnt, NumTiles);
+
+    TBitArray<> InGrid(false, NumTiles);
+    for (const FFireHeatGrid& Grid : Grids)
+    {
+        InGrid.SetRange(Grid.FirstTile, Grid.Columns * Grid.Rows, true);
+    }
+
+    GraphTiles.Reset();
+    GraphEdgeStarts.Reset();
+    GraphEdges.Reset();
+    for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+    {
+        if (InGrid[Tile]) continue;
+
+        GraphTiles.Add(Tile);
+        GraphEdgeStarts.Add(GraphEdges.Num());
+        GraphEdges.Append(Tiles.Neighbours[Tile]);
+    }
+    GraphEdgeStarts.Add(GraphEdges.Num());
+
+    for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+    {
+        SyncTile(Tiles, Tile);
+    }
+}
+
+void FFireHeatField::Reset()
+{
+    Grids.Empty();
+    GraphTiles.Empty();
+    GraphEdgeStarts.Empty();
+    GraphEdges.Empty();
+    Temperature.Empty();
+    NextTemperature.Empty();
+    Conductivity.Empty();
+    Ignition.Empty();
+    Source.Empty();
+    SyncedVisuals.Empty();
+}
+
+void FFireHeatField::SyncTile(const FFireTileTable& Tiles, int32 Tile)
+{
+    if (!Temperature.IsValidIndex(Tile)) return;
+
+    const FFireHeatMaterial Material = FFireHeatMaterial::ForType(Tiles.BurnTypes[Tile]);
+    const EFireTileVisual Visual = Tiles.GetVisual(Tile);
+    const bool bBurning = Visual == EFireTileVisual::Burning;
+
+    // Lit by anything, the heat or a torch, it starts hot
+    if (bBurning && SyncedVisuals[Tile] != EFireTileVisual::Burning)
+    {
+        Temperature[Tile] = FMath::Max(Temperature[Tile], Material.IgnitionTemperature == MAX_flt ? 1.0f : Material.IgnitionTemperature);
+    }
+
+    Conductivity[Tile] = Material.Conductivity;
+    Ignition[Tile] = Tiles.CanIgnite(Tile) ? Material.IgnitionTemperature : MAX_flt;
+    Source[Tile] = bBurning ? Material.HeatRate : 0.0f;
+    SyncedVisuals[Tile] = Visual;
+}
+
+void FFireHeatField::Step(float DeltaSeconds)
+{
+    for (const FFireHeatGrid& Grid : Grids)
+    {
+        StepGrid(Grid, DeltaSeconds);
+    }
+    StepGraphTiles(DeltaSeconds);
+
+    Swap(Temperature, NextTemperature);
+}
+
+void FFireHeatField::StepGrid(const FFireHeatGrid& Grid, float DeltaSeconds)
+{
+    const float* T = Temperature.GetData();
+    const float* K = Conductivity.GetData();
+    const float* S = Source.GetData();
+    float* Next = NextTemperature.GetData();
+
+    const VectorRegister4Float Delta = VectorSetFloat1(DeltaSeconds);
+    const VectorRegister4Float Four = VectorSetFloat1(4.0f);
+    const VectorRegister4Float KeepAfterCooling = VectorSetFloat1(1.0f - DeltaSeconds * Cooling);
+
+    // Edges take themselves as the missing neighbour, so no heat crosses the grid border
+    const int32 LastColumn = Grid.Columns - 1;
+    for (int32 BlockStart = 0; BlockStart < Grid.Columns; BlockStart += HeatBlockColumns)
+    {
+        const int32 BlockEnd = FMath::Min(BlockStart + HeatBlockColumns, Grid.Columns);
+
+        for (int32 Y = 0; Y < Grid.Rows; ++Y)
+        {
+            const int32 Row = Grid.FirstTile + Y * Grid.Columns;
+            const int32 Up = Grid.FirstTile + FMath::Max(Y - 1, 0) * Grid.Columns;
+            const int32 Down = Grid.FirstTile + FMath::Min(Y + 1, Grid.Rows - 1) * Grid.Columns;
+
+            int32 X = BlockStart;
+            if (X == 0)
+            {
+                const float Right = T[Row + FMath::Min(1, LastColumn)];
+                Next[Row] = StepTile(Row, T[Row] + Right + T[Up] + T[Down], DeltaSeconds);
+                X = 1;
+            }
+
+            // Interior columns four at a time: T + dt * (K * (sum - 4T) + S) - dt * Cooling * T
+            const int32 VectorEnd = FMath::Min(BlockEnd, LastColumn);
+            for (; X + 4 <= VectorEnd; X += 4)
+            {
+                const int32 Tile = Row + X;
+                const VectorRegister4Float Current = VectorLoad(T + Tile);
+                const VectorRegister4Float Sum = VectorAdd(
+                    VectorAdd(VectorLoad(T + Tile - 1), VectorLoad(T + Tile + 1)),
+                    VectorAdd(VectorLoad(T + Up + X), VectorLoad(T + Down + X)));
+                const VectorRegister4Float Laplacian = VectorNegateMultiplyAdd(Four, Current, Sum);
+                const VectorRegister4Float Change = VectorMultiplyAdd(VectorLoad(K + Tile), Laplacian, VectorLoad(S + Tile));
+                VectorStore(VectorMultiplyAdd(Change, Delta, VectorMultiply(Current, KeepAfterCooling)), Next + Tile);
+            }
+
+            for (; X < BlockEnd; ++X)
+            {
+                const int32 Tile = Row + X;
+                const float Left = T[Tile - (X > 0 ? 1 : 0)];
+                const float Right = T[Tile + (X < LastColumn ? 1 : 0)];
+                Next[Tile] = StepTile(Tile, Left + Right + T[Up + X] + T[Down + X], DeltaSeconds);
+            }
+        }
+    }
+}
+
+void FFireHeatField::StepGraphTiles(float DeltaSeconds)
+{
+    for (int32 Index = 0; Index < GraphTiles.Num(); ++Index)
+    {
+        const int32 Tile = GraphTiles[Index];
+        const int32 Start = GraphEdgeStarts[Index];
+        const int32 NumEdges = GraphEdgeStarts[Index + 1] - Start;
+        if (NumEdges == 0)
+        {
+            NextTemperature[Tile] = StepTile(Tile, 4.0f * Temperature[Tile], DeltaSeconds);
+            continue;
+        }
+
+        // Scaled to 4 neighbours so a patch passes heat on at the rate a field tile does
+        float Sum = 0.0f;
+        for (int32 Edge = Start; Edge < Start + NumEdges; ++Edge)
+        {
+            Sum += Temperature[GraphEdges[Edge]];
+        }
+        NextTemperature[Tile] = StepTile(Tile, Sum * 4.0f / NumEdges, DeltaSeconds);
+    }
+}
+
+void FFireHeatField::FindIgnitions(TArray<int32>& OutIgnitions) const
+{
+    OutIgnitions.Reset();
+
+    const float* T = Temperature.GetData();
+    const float* I = Ignition.GetData();
+
+    // Groups of four with nothing to report, nearly all of them, cost a compare and a branch
+    const int32 NumTiles = Temperature.Num();
+    int32 Tile = 0;
+    for (; Tile + 4 <= NumTiles; Tile += 4)
+    {
+        const int32 LitMask = VectorMaskBits(VectorCompareGE(VectorLoad(T + Tile), VectorLoad(I + Tile)));
+        if (LitMask == 0) continue;
+
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            if (LitMask & (1 << Lane)) OutIgnitions.Add(Tile + Lane);
+        }
+    }
+    for (; Tile < NumTiles; ++Tile)
+    {
+        if (T[Tile] >= I[Tile]) OutIgnitions.Add(Tile);
+    }
+}
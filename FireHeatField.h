@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireTileTable.h"
+
+// How a surface type takes, holds and gives off heat. Temperatures are relative to the air, 1 lights grass
+struct FFireHeatMaterial
+{
+	// Share of the temperature difference to each neighbour taken per second, 0 blocks heat entirely
+	float Conductivity = 0.0f;
+
+	float IgnitionTemperature = MAX_flt;
+
+	// Heat added per second while burning
+	float HeatRate = 0.0f;
+
+	static FFireHeatMaterial ForType(ESurfaceBurnType Type);
+};
+
+// A patch field's tiles as a grid, FirstTile + Y * Columns + X
+struct FFireHeatGrid
+{
+	int32 FirstTile = INDEX_NONE;
+	int32 Columns = 0;
+	int32 Rows = 0;
+};
+
+/*
+	Heat based alternative to the timed spread events. Every tile carries a temperature that
+	diffuses to its neighbours on a fixed timestep, burning tiles add heat and every tile loses
+	some to the air. A tile lights when it reaches its ignition temperature, so the subsystem only
+	has to act on threshold crossings, and burns out when the subsystem's fuel for it runs down. Field tiles step as a 5 point stencil over their grid, four tiles per vector op in
+	column blocks that keep the rows being read in cache, loose patch tiles use their neighbour
+	lists. The cost of a step depends on the number of tiles, not how many of them are burning.
+*/
+class BRIGHTSPARKSPROJECT_API FFireHeatField
+{
+public:
+	// Grids must not overlap, tiles outside every grid diffuse over their neighbour lists
+	void Init(const FFireTileTable& Tiles, TArrayView<const FFireHeatGrid> InGrids);
+	void Reset();
+	bool IsInitialised() const { return Temperature.Num() > 0; }
+
+	// Takes the tile's material, burning state and ignitability from the table after it changed
+	void SyncTile(const FFireTileTable& Tiles, int32 Tile);
+
+	void Step(float DeltaSeconds);
+
+	// Tiles that reached their ignition temperature as of the last step
+	void FindIgnitions(TArray<int32>& OutIgnitions) const;
+
+	float GetTemperature(int32 Tile) const { return Temperature.IsValidIndex(Tile) ? Temperature[Tile] : 0.0f; }
+
+private:
+	void StepGrid(const FFireHeatGrid& Grid, float DeltaSeconds);
+	void StepGraphTiles(float DeltaSeconds);
+
+	// Temperature after one step given the sum of the 4 neighbour temperatures
+	float StepTile(int32 Tile, float NeighbourSum, float DeltaSeconds) const
+	{
+		const float Current = Temperature[Tile];
+		return Current + DeltaSeconds * (Conductivity[Tile] * (NeighbourSum - 4.0f * Current) + Source[Tile] - Cooling * Current);
+	}
+
+	// Share of its temperature a tile loses to the air per second
+	static constexpr float Cooling = 0.2f;
+
+	TArray<FFireHeatGrid> Grids;
+
+	// Tiles in no grid, with their neighbour lists flattened
+	TArray<int32> GraphTiles;
+	TArray<int32> GraphEdgeStarts;
+	TArray<int32> GraphEdges;
+
+	// Per tile, Temperature is read and NextTemperature written during a step
+	TArray<float> Temperature;
+	TArray<float> NextTemperature;
+	TArray<float> Conductivity;
+	TArray<float> Ignition;
+	TArray<float> Source;
+
+	// Visual state each tile was last synced with, to tell when a tile has just lit
+	TArray<EFireTileVisual> SyncedVisuals;
+};
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireHistory.h"
+
+namespace
+{
+    int64 GetChunkBytes(const FFireHistoryChunk& Chunk)
+    {
+        return sizeof(FFireHistoryChunk) + Chunk.States.GetAllocatedSize();
+    }
+}
+
+void FFireHistory::Init(int32 InMaxFrames)
+{
+    Reset();
+    FreeChunks.Empty();
+    Frames.SetNum(FMath::Max(InMaxFrames, 2));
+}
+
+void FFireHistory::Reset()
+{
+    for (FFireHistoryFrame& Frame : Frames)
+    {
+        ReleaseFrame(Frame);
+    }
+    for (const TSharedPtr<const FFireHistoryChunk>& Chunk : CurrentChunks)
+    {
+        RecycleChunk(Chunk);
+    }
+    Head = 0;
+    Count = 0;
+    CurrentChunks.Reset();
+    CapturedVersions.Reset();
+    AllocatedBytes = 0;
+}
+
+void FFireHistory::Capture(double Time, const FFireTileTable& Tiles, TArrayView<const uint32> ChunkVersions, TArrayView<const FFireHistoryEvent> Events, int32 RandomSeed)
+{
+    if (Frames.Num() == 0) return;
+
+    const int32 NumChunks = Tiles.NumChunks();
+
+    // New tiles registered, nothing already captured lines up any more
+    if (CurrentChunks.Num() != NumChunks)
+    {
+        Reset();
+        CurrentChunks.SetNum(NumChunks);
+        CapturedVersions.Init(MAX_uint32, NumChunks);
+    }
+
+    if (Count == Frames.Num())
+    {
+        ReleaseFrame(Frames[Head]);
+        Head = (Head + 1) % Frames.Num();
+        --Count;
+    }
+
+    FFireHistoryFrame& Frame = Frames[(Head + Count) % Frames.Num()];
+    ++Count;
+
+    Frame.Time = Time;
+    Frame.RandomSeed = RandomSeed;
+    // Copied into the frame's own array, which kept its allocation when the frame was last released
+    Frame.Events.Reset();
+    Frame.Events.Append(Events.GetData(), Events.Num());
+    AllocatedBytes += Frame.Events.GetAllocatedSize();
+
+    Frame.Chunks.SetNum(NumChunks);
+    for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+    {
+        const uint32 Version = ChunkVersions.IsValidIndex(Chunk) ? ChunkVersions[Chunk] : 0;
+        if (CurrentChunks[Chunk].IsValid() && CapturedVersions[Chunk] == Version)
+        {
+            Frame.Chunks[Chunk] = CurrentChunks[Chunk];
+            continue;
+        }
+
+        // Copy on write, only chunks that changed since the last capture
+        TSharedPtr<FFireHistoryChunk> Copy;
+        if (FreeChunks.Num() > 0)
+        {
+            Copy = FreeChunks.Pop(false);
+        }
+        else
+        {
+            Copy = MakeShared<FFireHistoryChunk>();
+        }
+        const int32 First = Chunk << FireTileChunkShift;
+        const int32 End = FMath::Min(First + FireTileChunkSize, Tiles.Num());
+        Copy->States.SetNumUninitialized(End - First);
+        for (int32 Tile = First; Tile < End; ++Tile)
+        {
+            Copy->States[Tile - First] = static_cast<uint8>(Tiles.GetVisual(Tile)) | (static_cast<uint8>(Tiles.BurnTypes[Tile]) << 2);
+        }
+        AllocatedBytes += GetChunkBytes(*Copy);
+
+        Frame.Chunks[Chunk] = Copy;
+        SetCurrentChunk(Chunk, Copy);
+        CapturedVersions[Chunk] = Version;
+    }
+}
+
+bool FFireHistory::IsChunkCurrent(int32 Chunk, const FFireHistoryFrame& Frame, uint32 LiveVersion) const
+{
+    return CapturedVersions.IsValidIndex(Chunk) && CapturedVersions[Chunk] == LiveVersion
+        && CurrentChunks[Chunk] == Frame.Chunks[Chunk];
+}
+
+void FFireHistory::MarkRestored(int32 Index, TArrayView<const uint32> ChunkVersions)
+{
+    if (!IsValidIndex(Index)) return;
+
+    const FFireHistoryFrame& Frame = GetFrame(Index);
+    for (int32 Chunk = 0; Chunk < CurrentChunks.Num() && Chunk < Frame.Chunks.Num(); ++Chunk)
+    {
+        SetCurrentChunk(Chunk, Frame.Chunks[Chunk]);
+        CapturedVersions[Chunk] = ChunkVersions.IsValidIndex(Chunk) ? ChunkVersions[Chunk] : 0;
+    }
+}
+
+void FFireHistory::TruncateAfter(int32 Index)
+{
+    if (!IsValidIndex(Index)) return;
+
+    for (int32 Later = Index + 1; Later < Count; ++Later)
+    {
+        ReleaseFrame(Frames[(Head + Later) % Frames.Num()]);
+    }
+    Count = Index + 1;
+}
+
+void FFireHistory::ReleaseFrame(FFireHistoryFrame& Frame)
+{
+    for (const TSharedPtr<const FFireHistoryChunk>& Chunk : Frame.Chunks)
+    {
+        // Last reference, the copy is kept for a later capture
+        if (Chunk.IsValid() && Chunk.GetSharedReferenceCount() == 1)
+        {
+            AllocatedBytes -= GetChunkBytes(*Chunk);
+            RecycleChunk(Chunk);
+        }
+    }
+    AllocatedBytes -= Frame.Events.GetAllocatedSize();
+
+    Frame.Chunks.Reset();
+    Frame.Events.Reset();
+}
+
+void FFireHistory::SetCurrentChunk(int32 Chunk, const TSharedPtr<const FFireHistoryChunk>& NewChunk)
+{
+    // A copy no frame uses any more is kept for reuse when it stops being current
+    const TSharedPtr<const FFireHistoryChunk>& OldChunk = CurrentChunks[Chunk];
+    if (OldChunk.IsValid() && OldChunk != NewChunk && OldChunk.GetSharedReferenceCount() == 1)
+    {
+        AllocatedBytes -= GetChunkBytes(*OldChunk);
+        RecycleChunk(OldChunk);
+    }
+    CurrentChunks[Chunk] = NewChunk;
+}
+
+void FFireHistory::RecycleChunk(const TSharedPtr<const FFireHistoryChunk>& Chunk)
+{
+    if (Chunk.IsValid() && Chunk.GetSharedReferenceCount() == 1)
+    {
+        FreeChunks.Add(ConstCastSharedPtr<FFireHistoryChunk>(Chunk));
+    }
+}
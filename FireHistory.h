@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireTileTable.h"
+
+// One tile chunk's state at a point in history, shared by every frame it did not change in
+struct FFireHistoryChunk
+{
+	// EFireTileVisual in bits 0-1, ESurfaceBurnType above
+	TArray<uint8> States;
+};
+
+// A queued fire event, held as the time it still had to wait when the frame was captured
+struct FFireHistoryEvent
+{
+	int32 TileIndex = INDEX_NONE;
+	EFireEventType Type = EFireEventType::Spread;
+	float Remaining = 0.0f;
+};
+
+struct FFireHistoryFrame
+{
+	double Time = 0.0;
+	int32 RandomSeed = 0;
+	TArray<TSharedPtr<const FFireHistoryChunk>> Chunks;
+	TArray<FFireHistoryEvent> Events;
+};
+
+/*
+	Ring buffer of fire state frames for scrubbing the fire back and forth.
+	Frames hold one pointer per tile chunk, and a chunk is only copied when the subsystem's
+	version for it moved since the last capture, otherwise the frame shares the previous copy.
+	Memory follows how much of the map changed over the window rather than map size times frames.
+	Copies no frame holds any more are kept for later captures, so a running capture stops
+	allocating once the buffer has been round once.
+*/
+class BRIGHTSPARKSPROJECT_API FFireHistory
+{
+public:
+	// At least two frames are kept
+	void Init(int32 InMaxFrames);
+
+	// Drops every frame, their copies are kept for reuse
+	void Reset();
+
+	int32 Num() const { return Count; }
+	bool IsValidIndex(int32 Index) const { return Index >= 0 && Index < Count; }
+
+	// 0 is the oldest frame
+	const FFireHistoryFrame& GetFrame(int32 Index) const { return Frames[(Head + Index) % Frames.Num()]; }
+
+	// Adds a frame, the oldest is dropped once the buffer is full
+	void Capture(double Time, const FFireTileTable& Tiles, TArrayView<const uint32> ChunkVersions, TArrayView<const FFireHistoryEvent> Events, int32 RandomSeed);
+
+	// True when the live chunk still holds exactly what the frame has for it
+	bool IsChunkCurrent(int32 Chunk, const FFireHistoryFrame& Frame, uint32 LiveVersion) const;
+
+	// Called once the live tiles have been set to the frame, with the chunk versions that left them at
+	void MarkRestored(int32 Index, TArrayView<const uint32> ChunkVersions);
+
+	// Drops every frame after Index so captures carry on from it
+	void TruncateAfter(int32 Index);
+
+	int64 GetAllocatedBytes() const { return AllocatedBytes; }
+
+private:
+	void ReleaseFrame(FFireHistoryFrame& Frame);
+	void SetCurrentChunk(int32 Chunk, const TSharedPtr<const FFireHistoryChunk>& NewChunk);
+
+	// Keeps the copy for reuse when nothing else holds it
+	void RecycleChunk(const TSharedPtr<const FFireHistoryChunk>& Chunk);
+
+	TArray<FFireHistoryFrame> Frames;
+	int32 Head = 0;
+	int32 Count = 0;
+
+	// Chunk copies matching the live tiles as of CapturedVersions
+	TArray<TSharedPtr<const FFireHistoryChunk>> CurrentChunks;
+	TArray<uint32> CapturedVersions;
+
+	// Copies nothing holds, not counted in AllocatedBytes
+	TArray<TSharedPtr<FFireHistoryChunk>> FreeChunks;
+
+	int64 AllocatedBytes = 0;
+};
@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireHitchWatchdog.h"
+#include "FireSpreadSubsystem.h"
+#include "AudioManager.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <Kismet/GameplayStatics.h>
+
+static TAutoConsoleVariable<float> CVarFireHitchThresholdMs(
+    TEXT("fire.HitchThresholdMs"),
+    50.0f,
+    TEXT("Frames longer than this write a fire state record to Saved/FireHitches. 0 disables the watchdog."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFireHitchMaxPendingSpread(
+    TEXT("fire.HitchMaxPendingSpread"),
+    64,
+    TEXT("Maximum number of queued spread events listed in a hitch record."),
+    ECVF_Default);
+
+// Stops a run of slow frames from filling the disk
+static const double MinSecondsBetweenDumps = 1.0;
+
+void FFireHitchWatchdog::Init(int32 InHistorySize)
+{
+    History.SetNumZeroed(FMath::Max(InHistorySize, 1));
+    HistoryHead = 0;
+    HistoryCount = 0;
+    LastDumpTime = -1.0;
+}
+
+void FFireHitchWatchdog::RecordEvent(double Time, int32 TileIndex, EFireEventType Type)
+{
+    if (History.Num() == 0) return;
+
+    FFireEventRecord& Record = History[HistoryHead];
+    Record.Time = Time;
+    Record.TileIndex = TileIndex;
+    Record.Type = Type;
+
+    HistoryHead = (HistoryHead + 1) % History.Num();
+    HistoryCount = FMath::Min(HistoryCount + 1, History.Num());
+}
+
+void FFireHitchWatchdog::CheckFrame(const UFireSpreadSubsystem& FireSubsystem, float FrameSeconds)
+{
+    const float ThresholdMs = CVarFireHitchThresholdMs.GetValueOnGameThread();
+    const float FrameMs = FrameSeconds * 1000.0f;
+    if (ThresholdMs <= 0.0f || FrameMs < ThresholdMs) return;
+
+    const double Now = FPlatformTime::Seconds();
+    if (LastDumpTime >= 0.0 && Now - LastDumpTime < MinSecondsBetweenDumps) return;
+    LastDumpTime = Now;
+
+    FFireHitchRecord Record;
+    Record.FrameNumber = GFrameCounter;
+    Record.WorldTime = FireSubsystem.GetWorld()->GetTimeSeconds();
+    Record.FrameMs = FrameMs;
+    Record.EventsRun = FireSubsystem.EventsProcessedLastFrame;
+    Record.EventBacklog = FireSubsystem.BacklogDepth;
+    Record.NumTiles = FireSubsystem.GetNumTiles();
+
+    // The last published snapshot is the end of the previous tick, which is the hitching frame
+    Record.NumBurning = FireSubsystem.GetNumBurningTiles();
+    Record.NumBurnt = FireSubsystem.GetStateSnapshot()->Counters.NumBurnt;
+
+    if (!AudioManager.IsValid())
+    {
+        AudioManager = Cast<AAudioManager>(UGameplayStatics::GetActorOfClass(FireSubsystem.GetWorld(), AAudioManager::StaticClass()));
+    }
+    if (AudioManager.IsValid())
+    {
+        Record.AudioNearbyBurning = AudioManager->NearbyBurningCount;
+    }
+
+    Record.PendingSpreadCount = FireSubsystem.GetPendingSpreadEvents(Record.PendingSpread, CVarFireHitchMaxPendingSpread.GetValueOnGameThread());
+    CopyRecentEvents(Record.RecentEvents);
+
+    UE_LOG(LogTemp, Warning, TEXT("Fire hitch watchdog: frame %llu took %.1f ms, writing fire state record"), Record.FrameNumber, FrameMs);
+
+    Async(EAsyncExecution::ThreadPool, [Record = MoveTemp(Record)]()
+        {
+            WriteRecord(Record);
+        });
+}
+
+void FFireHitchWatchdog::CopyRecentEvents(TArray<FFireEventRecord>& OutEvents) const
+{
+    // Oldest first
+    OutEvents.Reset(HistoryCount);
+    const int32 Start = (HistoryHead - HistoryCount + History.Num()) % FMath::Max(History.Num(), 1);
+    for (int32 i = 0; i < HistoryCount; ++i)
+    {
+        OutEvents.Add(History[(Start + i) % History.Num()]);
+    }
+}
+
+void FFireHitchWatchdog::WriteRecord(const FFireHitchRecord& Record)
+{
+    // One small key=value file per hitch, event lists as index:type@time
+    FString Output;
+    Output += FString::Printf(TEXT("frame=%llu\nworld_time=%.3f\nframe_ms=%.2f\n"), Record.FrameNumber, Record.WorldTime, Record.FrameMs);
+    Output += FString::Printf(TEXT("events_run=%d\nevent_backlog=%d\n"), Record.EventsRun, Record.EventBacklog);
+    Output += FString::Printf(TEXT("patches=%d\nburning=%d\nburnt=%d\n"), Record.NumTiles, Record.NumBurning, Record.NumBurnt);
+    Output += FString::Printf(TEXT("audio_nearby_burning=%d\n"), Record.AudioNearbyBurning);
+
+    Output += FString::Printf(TEXT("pending_spread=%d\npending_spread_list="), Record.PendingSpreadCount);
+    for (const FFireEventRecord& Event : Record.PendingSpread)
+    {
+        Output += FString::Printf(TEXT("%d@%.3f "), Event.TileIndex, Event.Time);
+    }
+
+    Output += FString::Printf(TEXT("\nrecent_events=%d\nrecent_event_list="), Record.RecentEvents.Num());
+    for (const FFireEventRecord& Event : Record.RecentEvents)
+    {
+        Output += FString::Printf(TEXT("%d:%d@%.3f "), Event.TileIndex, static_cast<uint8>(Event.Type), Event.Time);
+    }
+    Output += TEXT("\n");
+
+    const FString FilePath = FPaths::ProjectSavedDir() / TEXT("FireHitches") /
+        FString::Printf(TEXT("Hitch_%s_%llu.txt"), *FDateTime::Now().ToString(), Record.FrameNumber);
+
+    if (!FFileHelper::SaveStringToFile(Output, *FilePath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Fire hitch watchdog could not write %s"), *FilePath);
+    }
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireSpreadPatch.h"
+
+class AAudioManager;
+class UFireSpreadSubsystem;
+
+// One patch transition, either one that has run or one still waiting in the queue
+struct FFireEventRecord
+{
+	double Time = 0.0;
+	int32 TileIndex = INDEX_NONE;
+	EFireEventType Type = EFireEventType::Ignite;
+	EFireIgniteSource Source = EFireIgniteSource::Script;
+};
+
+// Fire state captured on the frame after a hitch, written to disk off the game thread
+struct FFireHitchRecord
+{
+	uint64 FrameNumber = 0;
+	double WorldTime = 0.0;
+	float FrameMs = 0.0f;
+
+	// Fire events (our replacement for the patch timers) run on the hitching frame
+	int32 EventsRun = 0;
+	int32 EventBacklog = 0;
+
+	int32 NumTiles = 0;
+	int32 NumBurning = 0;
+	int32 NumBurnt = 0;
+	int32 AudioNearbyBurning = 0;
+
+	int32 PendingSpreadCount = 0;
+	TArray<FFireEventRecord> PendingSpread;
+	TArray<FFireEventRecord> RecentEvents;
+};
+
+/*
+	Watches the frame time and, when a frame goes over fire.HitchThresholdMs, snapshots the
+	fire simulation so sporadic hitches in big burns can be looked at after the fact.
+	Only the capture happens on the game thread, formatting and file IO run on the thread pool.
+*/
+class BRIGHTSPARKSPROJECT_API FFireHitchWatchdog
+{
+public:
+	void Init(int32 InHistorySize);
+
+	void RecordEvent(double Time, int32 TileIndex, EFireEventType Type);
+
+	// Called at the start of the subsystem tick with the real duration of the previous frame
+	void CheckFrame(const UFireSpreadSubsystem& FireSubsystem, float FrameSeconds);
+
+private:
+	void CopyRecentEvents(TArray<FFireEventRecord>& OutEvents) const;
+
+	static void WriteRecord(const FFireHitchRecord& Record);
+
+	// Ring buffer of the last HistorySize fire events
+	TArray<FFireEventRecord> History;
+	int32 HistoryHead = 0;
+	int32 HistoryCount = 0;
+
+	double LastDumpTime = -1.0;
+
+	// Looked up on the first hitch, and again only once the actor has gone
+	TWeakObjectPtr<AAudioManager> AudioManager;
+};
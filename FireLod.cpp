@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireLod.h"
+
+void FFireLod::SetGrids(FFireTileTable& Tiles, TArrayView<const FFireHeatGrid> InGrids)
+{
+    ClearCells(Tiles);
+    Grids = InGrids;
+}
+
+void FFireLod::ClearCells(FFireTileTable& Tiles)
+{
+    for (const TPair<int32, FFireLodCell>& Pair : CoarseCells)
+    {
+        TArray<int32, TInlineAllocator<16>> CellTiles;
+        GetCellTiles(Pair.Key, CellTiles);
+        for (int32 Tile : CellTiles)
+        {
+            if (Tiles.IsValidIndex(Tile)) Tiles.SetFlag(Tile, EFireTileFlags::Coarse, false);
+        }
+    }
+    CoarseCells.Empty();
+}
+
+void FFireLod::Reset()
+{
+    Grids.Empty();
+    CoarseCells.Empty();
+}
+
+const FFireHeatGrid* FFireLod::FindGrid(int32 Tile) const
+{
+    for (const FFireHeatGrid& Grid : Grids)
+    {
+        if (Tile >= Grid.FirstTile && Tile < Grid.FirstTile + Grid.Columns * Grid.Rows)
+        {
+            return &Grid;
+        }
+    }
+    return nullptr;
+}
+
+int32 FFireLod::FindCell(int32 Tile) const
+{
+    const FFireHeatGrid* Grid = FindGrid(Tile);
+    if (!Grid) return INDEX_NONE;
+
+    const int32 Local = Tile - Grid->FirstTile;
+    const int32 X = Local % Grid->Columns;
+    const int32 Y = Local / Grid->Columns;
+    return Grid->FirstTile + (Y - Y % CellSize) * Grid->Columns + (X - X % CellSize);
+}
+
+void FFireLod::GetCellTiles(int32 Cell, TArray<int32, TInlineAllocator<16>>& OutTiles) const
+{
+    OutTiles.Reset();
+
+    const FFireHeatGrid* Grid = FindGrid(Cell);
+    if (!Grid) return;
+
+    // Cells on the right and bottom edges of a grid can be narrower
+    const int32 Local = Cell - Grid->FirstTile;
+    const int32 X = Local % Grid->Columns;
+    const int32 Y = Local / Grid->Columns;
+    for (int32 DY = 0; DY < CellSize && Y + DY < Grid->Rows; ++DY)
+    {
+        for (int32 DX = 0; DX < CellSize && X + DX < Grid->Columns; ++DX)
+        {
+            OutTiles.Add(Cell + DY * Grid->Columns + DX);
+        }
+    }
+}
+
+bool FFireLod::Coarsen(FFireTileTable& Tiles, int32 Cell)
+{
+    if (CoarseCells.Contains(Cell)) return true;
+
+    TArray<int32, TInlineAllocator<16>> CellTiles;
+    GetCellTiles(Cell, CellTiles);
+    if (CellTiles.Num() == 0) return false;
+
+    FFireLodCell Coarse;
+    Coarse.SpreadDelay = 0.0f;
+    Coarse.BurnDuration = 0.0f;
+    int32 NumBurnt = 0;
+    int32 NumBurning = 0;
+    FVector2f LitSum = FVector2f::ZeroVector;
+    for (int32 Tile : CellTiles)
+    {
+        if (Tiles.HasFlag(Tile, EFireTileFlags::Special | EFireTileFlags::PendingIgnition)) return false;
+
+        Coarse.Centre += Tiles.Locations[Tile] / CellTiles.Num();
+        if (!Tiles.IsBurnableType(Tile)) continue;
+
+        Coarse.Order.Add(Tile);
+        Coarse.SpreadDelay += FFireTileTable::GetSpreadDelayScale(Tiles.BurnTypes[Tile]) * 0.5f * (Tiles.MinSpreadDelays[Tile] + Tiles.MaxSpreadDelays[Tile]);
+        Coarse.BurnDuration += Tiles.BurnDurations[Tile];
+
+        if (Tiles.IsBurnt(Tile) || Tiles.IsBurning(Tile))
+        {
+            LitSum += FVector2f(Tiles.Locations[Tile].X, Tiles.Locations[Tile].Y);
+            ++(Tiles.IsBurnt(Tile) ? NumBurnt : NumBurning);
+        }
+    }
+    if (NumBurning == 0) return false;
+
+    const int32 NumTiles = Coarse.Order.Num();
+    Coarse.SpreadDelay = FMath::Max(Coarse.SpreadDelay / NumTiles, KINDA_SMALL_NUMBER);
+    Coarse.BurnDuration = FMath::Max(Coarse.BurnDuration / NumTiles, KINDA_SMALL_NUMBER);
+    Coarse.FrontOrigin = LitSum / (NumBurnt + NumBurning);
+    Coarse.Burnt = static_cast<float>(NumBurnt) / NumTiles;
+    Coarse.Burning = static_cast<float>(NumBurning) / NumTiles;
+    Coarse.FirstLitRank = NumBurnt + NumBurning;
+
+    // Ranked so writing the shares back leaves every tile as it is now
+    auto GetRank = [&Tiles](int32 Tile)
+        {
+            return Tiles.IsBurnt(Tile) ? 0 : (Tiles.IsBurning(Tile) ? 1 : 2);
+        };
+    const FVector2f Origin = Coarse.FrontOrigin;
+    Coarse.Order.Sort([&Tiles, &GetRank, Origin](int32 A, int32 B)
+        {
+            const int32 RankA = GetRank(A);
+            const int32 RankB = GetRank(B);
+            if (RankA != RankB) return RankA < RankB;
+
+            const FVector2f LocationA(Tiles.Locations[A].X, Tiles.Locations[A].Y);
+            const FVector2f LocationB(Tiles.Locations[B].X, Tiles.Locations[B].Y);
+            return FVector2f::DistSquared(LocationA, Origin) < FVector2f::DistSquared(LocationB, Origin);
+        });
+
+    for (int32 Tile : CellTiles)
+    {
+        Tiles.SetFlag(Tile, EFireTileFlags::Coarse, true);
+    }
+    CoarseCells.Add(Cell, MoveTemp(Coarse));
+    return true;
+}
+
+void FFireLod::Refine(FFireTileTable& Tiles, int32 Cell, TArray<int32>* OutLitTiles)
+{
+    FFireLodCell Coarse;
+    if (!CoarseCells.RemoveAndCopyValue(Cell, Coarse)) return;
+
+    if (OutLitTiles)
+    {
+        for (int32 Rank = FMath::Max(Coarse.FirstLitRank, Coarse.GetNumBurnt()); Rank < Coarse.GetNumLit(); ++Rank)
+        {
+            OutLitTiles->Add(Coarse.Order[Rank]);
+        }
+    }
+
+    TArray<int32, TInlineAllocator<16>> CellTiles;
+    GetCellTiles(Cell, CellTiles);
+    for (int32 Tile : CellTiles)
+    {
+        Tiles.SetFlag(Tile, EFireTileFlags::Coarse, false);
+    }
+}
+
+void FFireLod::GetLitTiles(TArray<int32>& OutTiles) const
+{
+    for (const TPair<int32, FFireLodCell>& Pair : CoarseCells)
+    {
+        const FFireLodCell& Coarse = Pair.Value;
+        for (int32 Rank = FMath::Max(Coarse.FirstLitRank, Coarse.GetNumBurnt()); Rank < Coarse.GetNumLit(); ++Rank)
+        {
+            OutTiles.Add(Coarse.Order[Rank]);
+        }
+    }
+}
+
+void FFireLod::StepCell(FFireLodCell& Cell, float DeltaSeconds)
+{
+    // A burning tile lights up to 3 neighbours over a spread delay, which are unburnt in the share the cell is
+    const float Unburnt = FMath::Max(1.0f - Cell.Burnt - Cell.Burning, 0.0f);
+    const float Lit = Unburnt * FMath::Min(3.0f * Cell.Burning * DeltaSeconds / Cell.SpreadDelay, 1.0f);
+    const float BurntOut = Cell.Burning * FMath::Min(DeltaSeconds / Cell.BurnDuration, 1.0f);
+
+    Cell.Burning += Lit - BurntOut;
+    Cell.Burnt += BurntOut;
+}
+
+bool FFireLod::AddIgnition(FFireLodCell& Cell)
+{
+    if (Cell.GetNumLit() >= Cell.Order.Num()) return false;
+
+    // Up to the next whole tile, so one more tile shows burning
+    const float Step = 1.0f / Cell.Order.Num();
+    Cell.Burning = FMath::Min((Cell.GetNumLit() + 1) * Step - Cell.Burnt, 1.0f - Cell.Burnt);
+    return true;
+}
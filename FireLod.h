@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireHeatField.h"
+#include "FireTileTable.h"
+
+// Up to 4 by 4 field tiles burning as a whole, far from every player
+struct FFireLodCell
+{
+	// Burnable tiles in the order they burn: the ones burnt when the cell went coarse, the ones
+	// burning then, and the rest nearest FrontOrigin first
+	TArray<int32, TInlineAllocator<16>> Order;
+
+	// Shares of Order burnt and burning, the rest is unburnt
+	float Burnt = 0.0f;
+	float Burning = 0.0f;
+
+	// Where the fire in the cell came from, the front is a ring around it moving out through Order
+	FVector2f FrontOrigin = FVector2f::ZeroVector;
+	FVector3f Centre = FVector3f::ZeroVector;
+
+	// Tiles from this rank on were lit by the cell, their spread is still to come when it refines
+	int32 FirstLitRank = 0;
+
+	// Means over Order
+	float SpreadDelay = 1.0f;
+	float BurnDuration = 1.0f;
+
+	int32 GetNumBurnt() const { return FMath::Min(FMath::RoundToInt(Burnt * Order.Num()), GetNumLit()); }
+	int32 GetNumLit() const { return FMath::Min(FMath::RoundToInt((Burnt + Burning) * Order.Num()), Order.Num()); }
+	int32 GetNumBurning() const { return GetNumLit() - GetNumBurnt(); }
+
+	// State the tile at the rank in Order shows
+	EFireTileVisual GetRankVisual(int32 Rank) const
+	{
+		return Rank < GetNumBurnt() ? EFireTileVisual::Burnt : (Rank < GetNumLit() ? EFireTileVisual::Burning : EFireTileVisual::Unburnt);
+	}
+};
+
+/*
+	Level of detail for fire far from the players. Field tiles are grouped into 4 by 4 cells and a
+	burning cell far enough away is simulated as burnt and burning shares instead of per tile
+	spread events: tiles light at a rate set by the share burning and the mean spread delay, and
+	burn out over the mean burn duration. The shares are written back to the tiles in Order, so
+	the tile table, visuals and burn statistics stay within a tile per cell of the coarse state.
+	Tiles of a coarse cell carry EFireTileFlags::Coarse, cells with special tiles never go coarse.
+*/
+class BRIGHTSPARKSPROJECT_API FFireLod
+{
+public:
+	static constexpr int32 CellSize = 4;
+
+	// Cells are laid over these grids, every coarse cell is refined first
+	void SetGrids(FFireTileTable& Tiles, TArrayView<const FFireHeatGrid> InGrids);
+
+	// Drops every coarse cell, clearing the tiles' coarse flags without touching their state
+	void ClearCells(FFireTileTable& Tiles);
+	void Reset();
+
+	// Cell key, the first tile of the cell holding the tile. INDEX_NONE for tiles in no grid
+	int32 FindCell(int32 Tile) const;
+	void GetCellTiles(int32 Cell, TArray<int32, TInlineAllocator<16>>& OutTiles) const;
+
+	// Takes the cell coarse from its tiles as they are now, false if one of them needs the per tile fire
+	bool Coarsen(FFireTileTable& Tiles, int32 Cell);
+
+	// Hands the cell back to the per tile fire, OutLitTiles gets the burning tiles it lit that have yet to spread
+	void Refine(FFireTileTable& Tiles, int32 Cell, TArray<int32>* OutLitTiles);
+
+	FFireLodCell* FindCoarseCell(int32 Cell) { return CoarseCells.Find(Cell); }
+	const TMap<int32, FFireLodCell>& GetCoarseCells() const { return CoarseCells; }
+
+	// Burning tiles every coarse cell lit that have yet to spread
+	void GetLitTiles(TArray<int32>& OutTiles) const;
+
+	static void StepCell(FFireLodCell& Cell, float DeltaSeconds);
+
+	// Lights the next unburnt tile of the cell, false if there is none
+	static bool AddIgnition(FFireLodCell& Cell);
+
+private:
+	const FFireHeatGrid* FindGrid(int32 Tile) const;
+
+	TArray<FFireHeatGrid> Grids;
+	TMap<int32, FFireLodCell> CoarseCells;
+};
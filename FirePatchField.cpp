@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirePatchField.h"
+#include "FireSpreadSubsystem.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "NiagaraComponent.h"
+#include "NiagaraDataInterfaceArrayFunctionLibrary.h"
+#include <NiagaraFunctionLibrary.h>
+
+// Sets default values
+AFirePatchField::AFirePatchField()
+{
+    // The fire subsystem drives the field, nothing to do per frame
+    PrimaryActorTick.bCanEverTick = false;
+
+    // No body per instance, traces hit the fire subsystem's shared ground collision, which covers the field's tiles
+    TileMeshes = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("TileMeshes"));
+    SetRootComponent(TileMeshes);
+    TileMeshes->NumCustomDataFloats = 2;
+    TileMeshes->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
+void AFirePatchField::OnConstruction(const FTransform& Transform)
+{
+    Super::OnConstruction(Transform);
+
+    // Only rebuild when the grid size changed, rebuilding every construction is slow on big fields
+    if (TileMeshes->GetInstanceCount() != GetNumTiles())
+    {
+        BuildInstances();
+    }
+}
+
+// Called when the game starts or when spawned
+void AFirePatchField::BeginPlay()
+{
+    Super::BeginPlay();
+
+    CellInstances.Reset();
+    for (int32 Instance = 0; Instance < BurnableCells.Num(); ++Instance)
+    {
+        CellInstances.Set(BurnableCells[Instance], Instance);
+    }
+
+    if (UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>())
+    {
+        FirstTileIndex = FireSubsystem->RegisterField(this);
+    }
+}
+
+void AFirePatchField::BuildInstances()
+{
+    const int32 NumTiles = GetNumTiles();
+
+    TArray<FTransform> Transforms;
+    Transforms.Reserve(NumTiles);
+    for (int32 Instance = 0; Instance < NumTiles; ++Instance)
+    {
+        const FIntPoint Coord = GetTileCoord(Instance);
+        Transforms.Add(FTransform(FVector(Coord.X * TileSize, Coord.Y * TileSize, 0.0f)));
+    }
+
+    TileMeshes->ClearInstances();
+    TileMeshes->AddInstances(Transforms, false);
+
+    for (int32 Instance = 0; Instance < NumTiles; ++Instance)
+    {
+        const ESurfaceBurnType BurnType = GetAuthoredBurnType(Instance);
+        const EFireTileVisual Visual = BurnType == ESurfaceBurnType::Burnt ? EFireTileVisual::Burnt : EFireTileVisual::Unburnt;
+
+        TileMeshes->SetCustomDataValue(Instance, 0, static_cast<float>(Visual), false);
+        TileMeshes->SetCustomDataValue(Instance, 1, static_cast<float>(BurnType), false);
+    }
+    TileMeshes->MarkRenderStateDirty();
+}
+
+int32 AFirePatchField::GetTileIndex(int32 InstanceIndex) const
+{
+    if (FirstTileIndex == INDEX_NONE || InstanceIndex < 0 || InstanceIndex >= GetNumTiles()) return INDEX_NONE;
+    return FirstTileIndex + InstanceIndex;
+}
+
+int32 AFirePatchField::GetInstanceIndex(int32 TileIndex) const
+{
+    return OwnsTile(TileIndex) ? TileIndex - FirstTileIndex : INDEX_NONE;
+}
+
+bool AFirePatchField::OwnsTile(int32 TileIndex) const
+{
+    return FirstTileIndex != INDEX_NONE && TileIndex >= FirstTileIndex && TileIndex < FirstTileIndex + GetNumTiles();
+}
+
+int32 AFirePatchField::FindInstance(const FIntPoint& Coord) const
+{
+    if (IsSparse()) return CellInstances.Find(Coord);
+    if (Coord.X < 0 || Coord.Y < 0 || Coord.X >= Columns || Coord.Y >= Rows) return INDEX_NONE;
+    return Coord.Y * Columns + Coord.X;
+}
+
+int32 AFirePatchField::FindNeighbourInstances(int32 InstanceIndex, int32 (&OutInstances)[8]) const
+{
+    const FIntPoint Coord = GetTileCoord(InstanceIndex);
+    if (IsSparse()) return CellInstances.FindNeighbours(Coord, OutInstances);
+
+    int32 NumFound = 0;
+    for (int32 DY = -1; DY <= 1; ++DY)
+    {
+        for (int32 DX = -1; DX <= 1; ++DX)
+        {
+            const int32 Neighbour = (DX == 0 && DY == 0) ? INDEX_NONE : FindInstance(Coord + FIntPoint(DX, DY));
+            if (Neighbour != INDEX_NONE) OutInstances[NumFound++] = Neighbour;
+        }
+    }
+    return NumFound;
+}
+
+FVector AFirePatchField::GetTileLocation(int32 InstanceIndex) const
+{
+    const FIntPoint Coord = GetTileCoord(InstanceIndex);
+    return GetActorTransform().TransformPosition(FVector(Coord.X * TileSize, Coord.Y * TileSize, 0.0f));
+}
+
+ESurfaceBurnType AFirePatchField::GetAuthoredBurnType(int32 InstanceIndex) const
+{
+    return TileBurnTypes.IsValidIndex(InstanceIndex) ? TileBurnTypes[InstanceIndex] : DefaultBurnType;
+}
+
+void AFirePatchField::ApplyTileVisuals(TArrayView<const int32> TileIndices, TArrayView<const EFireTileVisual> Visuals)
+{
+    check(TileIndices.Num() == Visuals.Num());
+
+    bool bEffectChanged = false;
+    for (int32 i = 0; i < TileIndices.Num(); ++i)
+    {
+        const int32 Instance = GetInstanceIndex(TileIndices[i]);
+        if (Instance == INDEX_NONE) continue;
+
+        TileMeshes->SetCustomDataValue(Instance, 0, static_cast<float>(Visuals[i]), false);
+
+        if (Visuals[i] == EFireTileVisual::Burning)
+        {
+            bEffectChanged |= StartTileEffect(Instance);
+        }
+        else
+        {
+            bEffectChanged |= StopTileEffect(Instance);
+        }
+    }
+
+    // One render state update for the whole batch
+    TileMeshes->MarkRenderStateDirty();
+
+    if (bEffectChanged)
+    {
+        UpdateFireEffect();
+    }
+}
+
+bool AFirePatchField::StartTileEffect(int32 InstanceIndex)
+{
+    if (!FireEffect) return false;
+
+    if (EffectSlots.Num() != GetNumTiles())
+    {
+        EffectSlots.Init(INDEX_NONE, GetNumTiles());
+    }
+    if (EffectSlots[InstanceIndex] != INDEX_NONE) return false;
+
+    EffectSlots[InstanceIndex] = EffectPositions.Add(GetTileLocation(InstanceIndex));
+    EffectInstances.Add(InstanceIndex);
+    return true;
+}
+
+bool AFirePatchField::StopTileEffect(int32 InstanceIndex)
+{
+    const int32 Slot = EffectSlots.IsValidIndex(InstanceIndex) ? EffectSlots[InstanceIndex] : INDEX_NONE;
+    if (Slot == INDEX_NONE) return false;
+
+    // The last burning tile takes the slot
+    const int32 LastInstance = EffectInstances.Last();
+    EffectPositions.RemoveAtSwap(Slot, 1, false);
+    EffectInstances.RemoveAtSwap(Slot, 1, false);
+    EffectSlots[LastInstance] = Slot;
+    EffectSlots[InstanceIndex] = INDEX_NONE;
+    return true;
+}
+
+void AFirePatchField::UpdateFireEffect()
+{
+    if (EffectPositions.Num() == 0)
+    {
+        if (FireEffectComponent)
+        {
+            FireEffectComponent->Deactivate();
+        }
+        return;
+    }
+
+    if (!FireEffectComponent)
+    {
+        FireEffectComponent = UNiagaraFunctionLibrary::SpawnSystemAttached(
+            FireEffect,
+            GetRootComponent(),
+            NAME_None,
+            FVector::ZeroVector,
+            FRotator::ZeroRotator,
+            EAttachLocation::KeepRelativeOffset,
+            false
+        );
+        if (!FireEffectComponent) return;
+    }
+
+    UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(FireEffectComponent, FireEffectPositionsParameter, EffectPositions);
+    if (!FireEffectComponent->IsActive())
+    {
+        FireEffectComponent->Activate(true);
+    }
+}
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "FireSparseGrid.h"
+#include "FireSpreadPatch.h"
+#include "FireTileTable.h"
+#include "FirePatchField.generated.h"
+
+class UHierarchicalInstancedStaticMeshComponent;
+class UNiagaraComponent;
+
+/*
+	A grid of fire tiles drawn through one hierarchical instanced static mesh instead of one
+	AFireSpreadPatch actor per tile. Tiles are registered with the fire subsystem as a
+	contiguous block of tile indices, instance i of the mesh is tile FirstTileIndex + i.
+	Burn state reaches the material through per instance custom data:
+		0: EFireTileVisual (0 unburnt, 1 burning, 2 burnt, 3 dug)
+		1: ESurfaceBurnType as authored
+	The optional FireEffect is a single system for the field, fed the locations of its burning tiles.
+	A sparse field lists its burnable cells instead, and only those become tiles and instances.
+*/
+UCLASS()
+class BRIGHTSPARKSPROJECT_API AFirePatchField : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AFirePatchField();
+
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+public:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Patch Field")
+	UHierarchicalInstancedStaticMeshComponent* TileMeshes;
+
+	// Grid Set Up
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Patch Field", meta = (ClampMin = "1"))
+	int32 Columns = 64;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Patch Field", meta = (ClampMin = "1"))
+	int32 Rows = 64;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Patch Field")
+	float TileSize = 160.0f;
+
+	// When set the field only has tiles at these cells, in this order, and Columns and Rows are unused.
+	// Lets one field cover kilometres of ground where only the meadows can burn
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Patch Field")
+	TArray<FIntPoint> BurnableCells;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Patch Field")
+	ESurfaceBurnType DefaultBurnType = ESurfaceBurnType::Quick;
+
+	// Optional per tile type, row major, tiles past the end use DefaultBurnType
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Patch Field")
+	TArray<ESurfaceBurnType> TileBurnTypes;
+
+	// Instance indices of tiles that lose the game when all of them burn
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Patch Field")
+	TArray<int32> SpecialTiles;
+
+	// Fire Tuning, shared by every tile in the field
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	float MinSpreadDelay = 5.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	float MaxSpreadDelay = 15.0f;
+
+	UPROPERTY(EditAnywhere, Category = "FireSpread")
+	float BurnDuration = 45.0f;
+
+	// Fuel mass on each tile, burnt off at BurnRate per second while it burns. 0 gives it BurnDuration seconds worth
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FireSpread")
+	float FuelLoad = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FireSpread")
+	float BurnRate = 1.0f;
+
+	// Optional, one system for the whole field. Leave empty to show fire through the material only
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	UNiagaraSystem* FireEffect;
+
+	// Vector Array user parameter of FireEffect that gets the world location of every burning tile
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	FName FireEffectPositionsParameter = TEXT("TilePositions");
+
+	// Rebuilds the mesh instances from the grid settings
+	UFUNCTION(CallInEditor, Category = "Patch Field")
+	void BuildInstances();
+
+	bool IsSparse() const { return BurnableCells.Num() > 0; }
+	int32 GetNumTiles() const { return IsSparse() ? BurnableCells.Num() : Columns * Rows; }
+
+	// First fire subsystem tile index of this field, INDEX_NONE until BeginPlay
+	int32 FirstTileIndex = INDEX_NONE;
+
+	int32 GetTileIndex(int32 InstanceIndex) const;
+	int32 GetInstanceIndex(int32 TileIndex) const;
+	bool OwnsTile(int32 TileIndex) const;
+
+	FIntPoint GetTileCoord(int32 InstanceIndex) const
+	{
+		return IsSparse() ? BurnableCells[InstanceIndex] : FIntPoint(InstanceIndex % Columns, InstanceIndex / Columns);
+	}
+
+	// Instance at the cell, INDEX_NONE if the field has no tile there
+	int32 FindInstance(const FIntPoint& Coord) const;
+
+	// Instances in the 8 cells around the instance's cell, returns how many were written
+	int32 FindNeighbourInstances(int32 InstanceIndex, int32 (&OutInstances)[8]) const;
+
+	FVector GetTileLocation(int32 InstanceIndex) const;
+	ESurfaceBurnType GetAuthoredBurnType(int32 InstanceIndex) const;
+
+	// Pushes the custom data of every changed tile in one render state update, and the burning tiles to the fire effect once
+	void ApplyTileVisuals(TArrayView<const int32> TileIndices, TArrayView<const EFireTileVisual> Visuals);
+
+private:
+	// Add or remove the instance's location in the effect's position array, true if it changed
+	bool StartTileEffect(int32 InstanceIndex);
+
+	// Instance index by cell of a sparse field, built at BeginPlay
+	FFireSparseGrid CellInstances;
+
+	bool StopTileEffect(int32 InstanceIndex);
+
+	// Hands the positions to the fire effect, spawning it on the first burning tile and deactivating it once none are left
+	void UpdateFireEffect();
+
+	UPROPERTY()
+	UNiagaraComponent* FireEffectComponent = nullptr;
+
+	// Burning instances in the order of their positions, and each instance's slot in them or INDEX_NONE
+	TArray<int32> EffectInstances;
+	TArray<FVector> EffectPositions;
+	TArray<int32> EffectSlots;
+};
@@ -0,0 +1,562 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirePathfinding.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Reverse.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+    // Cached paths past this are dropped, the stale ones first
+    constexpr int32 MaxCachedPaths = 8192;
+
+    // Queries one worker takes at a time
+    constexpr int32 QueriesPerBatch = 8;
+
+    const int32 StepX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    const int32 StepY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+    struct FOpenBefore
+    {
+        bool operator()(const FFirePathScratch::FOpen& A, const FFirePathScratch::FOpen& B) const { return A.F < B.F; }
+    };
+
+    float GetOctileDistance(int32 DX, int32 DY)
+    {
+        DX = FMath::Abs(DX);
+        DY = FMath::Abs(DY);
+        return FMath::Max(DX, DY) + (UE_SQRT_2 - 1.0f) * FMath::Min(DX, DY);
+    }
+
+    // 8 way A* over a Columns by Rows grid, GetCost gives the cost of stepping onto a node and 0 where it cannot be
+    // walked. Diagonal steps may not cut the corner of a node that cannot be walked. MinCost is the lowest cost
+    // GetCost can give, which keeps the octile estimate from overshooting
+    template<typename CostFuncType>
+    bool RunAStar(int32 Columns, int32 Rows, int32 Start, int32 Goal, float MinCost, const CostFuncType& GetCost, FFirePathScratch& Scratch, TArray<int32>& OutPath)
+    {
+        OutPath.Reset();
+        Scratch.Prepare(Columns * Rows);
+        const uint32 Stamp = Scratch.Stamp;
+
+        const int32 GoalX = Goal % Columns;
+        const int32 GoalY = Goal / Columns;
+
+        Scratch.Stamps[Start] = Stamp;
+        Scratch.G[Start] = 0.0f;
+        Scratch.Parents[Start] = INDEX_NONE;
+        Scratch.Open.HeapPush({ MinCost * GetOctileDistance(Start % Columns - GoalX, Start / Columns - GoalY), 0.0f, Start }, FOpenBefore());
+
+        while (Scratch.Open.Num() > 0)
+        {
+            FFirePathScratch::FOpen Entry;
+            Scratch.Open.HeapPop(Entry, FOpenBefore(), false);
+
+            // A cheaper way here was pushed after this one
+            if (Entry.G > Scratch.G[Entry.Node]) continue;
+
+            if (Entry.Node == Goal)
+            {
+                for (int32 Node = Goal; Node != INDEX_NONE; Node = Scratch.Parents[Node])
+                {
+                    OutPath.Add(Node);
+                }
+                Algo::Reverse(OutPath);
+                return true;
+            }
+
+            const int32 X = Entry.Node % Columns;
+            const int32 Y = Entry.Node / Columns;
+            for (int32 Step = 0; Step < 8; ++Step)
+            {
+                const int32 NextX = X + StepX[Step];
+                const int32 NextY = Y + StepY[Step];
+                if (NextX < 0 || NextX >= Columns || NextY < 0 || NextY >= Rows) continue;
+
+                const int32 Next = NextY * Columns + NextX;
+                const float Cost = GetCost(Next);
+                if (Cost <= 0.0f) continue;
+
+                const bool bDiagonal = Step >= 4;
+                if (bDiagonal && (GetCost(Y * Columns + NextX) <= 0.0f || GetCost(NextY * Columns + X) <= 0.0f)) continue;
+
+                const float NextG = Entry.G + (bDiagonal ? Cost * UE_SQRT_2 : Cost);
+                if (Scratch.Stamps[Next] == Stamp && NextG >= Scratch.G[Next]) continue;
+
+                Scratch.Stamps[Next] = Stamp;
+                Scratch.G[Next] = NextG;
+                Scratch.Parents[Next] = Entry.Node;
+                Scratch.Open.HeapPush({ NextG + MinCost * GetOctileDistance(NextX - GoalX, NextY - GoalY), NextG, Next }, FOpenBefore());
+            }
+        }
+        return false;
+    }
+}
+
+void FFirePathScratch::Prepare(int32 NumNodes)
+{
+    if (Stamps.Num() < NumNodes)
+    {
+        G.SetNumUninitialized(NumNodes);
+        Parents.SetNumUninitialized(NumNodes);
+        Stamps.SetNumZeroed(NumNodes);
+    }
+
+    if (++Stamp == 0)
+    {
+        FMemory::Memzero(Stamps.GetData(), Stamps.Num() * sizeof(uint32));
+        Stamp = 1;
+    }
+    Open.Reset();
+}
+
+void FFirePathGrid::Init(int32 InFirstTile, int32 InColumns, int32 InRows, uint8 Cost)
+{
+    FirstTile = InFirstTile;
+    Columns = InColumns;
+    Rows = InRows;
+    SectorColumns = FMath::DivideAndRoundUp(Columns, SectorSize);
+    SectorRows = FMath::DivideAndRoundUp(Rows, SectorSize);
+
+    const int32 NumSectors = SectorColumns * SectorRows;
+    Costs.Init(Cost, Columns * Rows);
+    SectorCostSums.Init(0, NumSectors);
+    SectorWalkable.Init(0, NumSectors);
+    SectorVersions.Init(0, NumSectors);
+    Version = 0;
+
+    if (Cost > 0)
+    {
+        for (int32 Local = 0; Local < Costs.Num(); ++Local)
+        {
+            const int32 Sector = GetSector(Local);
+            SectorCostSums[Sector] += Cost;
+            ++SectorWalkable[Sector];
+        }
+    }
+}
+
+bool FFirePathGrid::SetCost(int32 Local, uint8 Cost)
+{
+    uint8& Current = Costs[Local];
+    if (Current == Cost) return false;
+
+    const int32 Sector = GetSector(Local);
+    if (Current > 0)
+    {
+        SectorCostSums[Sector] -= Current;
+        --SectorWalkable[Sector];
+    }
+    if (Cost > 0)
+    {
+        SectorCostSums[Sector] += Cost;
+        ++SectorWalkable[Sector];
+    }
+    Current = Cost;
+
+    ++SectorVersions[Sector];
+    ++Version;
+    return true;
+}
+
+bool FFirePathGrid::FindPath(int32 Start, int32 Goal, TArray<int32>& OutPath, FFirePathSearchContext& Context) const
+{
+    OutPath.Reset();
+    if (!Costs.IsValidIndex(Start) || !Costs.IsValidIndex(Goal)) return false;
+    if (Start == Goal)
+    {
+        OutPath.Add(Start);
+        return true;
+    }
+
+    // Sectors cost the mean of their walkable tiles, one with none cannot be crossed at all
+    const int32 GoalSector = GetSector(Goal);
+    const auto GetSectorStepCost = [this, GoalSector](int32 Sector)
+        {
+            return Sector == GoalSector ? FMath::Max(GetSectorCost(Sector), 1.0f) : GetSectorCost(Sector);
+        };
+    if (!RunAStar(SectorColumns, SectorRows, GetSector(Start), GoalSector, 1.0f, GetSectorStepCost, Context.Sectors, Context.SectorPath))
+    {
+        return false;
+    }
+
+    const int32 NumSectors = SectorColumns * SectorRows;
+    if (Context.Corridor.Num() < NumSectors)
+    {
+        Context.Corridor.SetNumZeroed(NumSectors);
+    }
+    if (++Context.CorridorStamp == 0)
+    {
+        FMemory::Memzero(Context.Corridor.GetData(), Context.Corridor.Num() * sizeof(uint32));
+        Context.CorridorStamp = 1;
+    }
+
+    const uint32 CorridorStamp = Context.CorridorStamp;
+    for (const int32 Sector : Context.SectorPath)
+    {
+        const int32 SectorX = Sector % SectorColumns;
+        const int32 SectorY = Sector / SectorColumns;
+        for (int32 Y = FMath::Max(SectorY - 1, 0); Y <= FMath::Min(SectorY + 1, SectorRows - 1); ++Y)
+        {
+            for (int32 X = FMath::Max(SectorX - 1, 0); X <= FMath::Min(SectorX + 1, SectorColumns - 1); ++X)
+            {
+                Context.Corridor[Y * SectorColumns + X] = CorridorStamp;
+            }
+        }
+    }
+
+    const auto GetStepCost = [this, Goal](int32 Local)
+        {
+            return Local == Goal ? FMath::Max<float>(Costs[Local], BurntCost) : static_cast<float>(Costs[Local]);
+        };
+    const auto GetCorridorStepCost = [this, &Context, CorridorStamp, &GetStepCost](int32 Local)
+        {
+            return Context.Corridor[GetSector(Local)] == CorridorStamp ? GetStepCost(Local) : 0.0f;
+        };
+    if (RunAStar(Columns, Rows, Start, Goal, BurntCost, GetCorridorStepCost, Context.Tiles, OutPath))
+    {
+        return true;
+    }
+
+    // The mean sector costs hid a wall of burning tiles, search the whole grid
+    return RunAStar(Columns, Rows, Start, Goal, BurntCost, GetStepCost, Context.Tiles, OutPath);
+}
+
+uint8 FFirePathGrid::GetTileCost(const FFireTileTable& Tiles, int32 Tile)
+{
+    if (Tiles.IsBurning(Tile)) return 0;
+    if (Tiles.IsBurnt(Tile) || Tiles.IsDug(Tile)) return BurntCost;
+    if (Tiles.HasFlag(Tile, EFireTileFlags::PendingIgnition)) return IgnitingCost;
+    return UnburntCost;
+}
+
+void FFirePathfinder::Reset()
+{
+    if (PendingBatch.IsValid())
+    {
+        PendingBatch.Wait();
+        PendingBatch.Reset();
+    }
+
+    Grids.Reset();
+    Snapshots.Reset();
+    Cache.Reset();
+    Queued.Reset();
+    QueuedKeys.Reset();
+    LastBatchMs = 0.0f;
+}
+
+int32 FFirePathfinder::AddGrid(int32 FirstTile, int32 Columns, int32 Rows, uint8 Cost)
+{
+    Grids.AddDefaulted_GetRef().Init(FirstTile, Columns, Rows, Cost);
+    Snapshots.AddDefaulted();
+    return Grids.Num() - 1;
+}
+
+int32 FFirePathfinder::FindGrid(int32 Tile) const
+{
+    for (int32 Index = 0; Index < Grids.Num(); ++Index)
+    {
+        if (Grids[Index].OwnsTile(Tile)) return Index;
+    }
+    return INDEX_NONE;
+}
+
+void FFirePathfinder::SetTileCost(int32 Tile, uint8 Cost)
+{
+    const int32 GridIndex = FindGrid(Tile);
+    if (GridIndex != INDEX_NONE && Grids[GridIndex].SetCost(Tile - Grids[GridIndex].FirstTile, Cost))
+    {
+        Snapshots[GridIndex].Reset();
+    }
+}
+
+bool FFirePathfinder::IsCurrent(const FCachedPath& Path) const
+{
+    const FFirePathGrid& Grid = Grids[Path.Grid];
+    if (Path.Tiles.Num() == 0) return Path.GridVersion == Grid.Version;
+
+    for (int32 Index = 0; Index < Path.Sectors.Num(); ++Index)
+    {
+        if (Grid.SectorVersions[Path.Sectors[Index]] != Path.SectorVersions[Index]) return false;
+    }
+    return true;
+}
+
+EFirePathStatus FFirePathfinder::FindPath(int32 StartTile, int32 GoalTile, TArray<int32>& OutTiles)
+{
+    OutTiles.Reset();
+
+    const int32 GridIndex = FindGrid(StartTile);
+    if (GridIndex == INDEX_NONE || !Grids[GridIndex].OwnsTile(GoalTile)) return EFirePathStatus::Invalid;
+
+    const uint64 Key = MakeKey(StartTile, GoalTile);
+    if (const FCachedPath* Cached = Cache.Find(Key))
+    {
+        if (IsCurrent(*Cached))
+        {
+            OutTiles = Cached->Tiles;
+            return OutTiles.Num() > 0 ? EFirePathStatus::Found : EFirePathStatus::NoPath;
+        }
+        Cache.Remove(Key);
+    }
+
+    bool bAlreadyQueued = false;
+    QueuedKeys.Add(Key, &bAlreadyQueued);
+    if (!bAlreadyQueued)
+    {
+        const int32 FirstTile = Grids[GridIndex].FirstTile;
+        Queued.Add({ GridIndex, StartTile - FirstTile, GoalTile - FirstTile });
+    }
+    return EFirePathStatus::Pending;
+}
+
+void FFirePathfinder::SearchBatch(TArrayView<const TSharedPtr<const FFirePathGrid>> InGrids, TArrayView<const FFirePathQuery> Queries, TArray<TArray<int32>>& OutPaths, bool bSingleThread)
+{
+    OutPaths.SetNum(Queries.Num());
+    if (Queries.Num() == 0) return;
+
+    const int32 NumBatches = FMath::DivideAndRoundUp(Queries.Num(), QueriesPerBatch);
+    const int32 NumWorkers = bSingleThread ? 1 : FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, NumBatches);
+    FThreadSafeCounter NextBatch;
+
+    ParallelFor(NumWorkers, [&](int32 Worker)
+        {
+            FFirePathSearchContext Context;
+            for (int32 BatchIndex = NextBatch.Increment() - 1; BatchIndex < NumBatches; BatchIndex = NextBatch.Increment() - 1)
+            {
+                const int32 End = FMath::Min((BatchIndex + 1) * QueriesPerBatch, Queries.Num());
+                for (int32 Index = BatchIndex * QueriesPerBatch; Index < End; ++Index)
+                {
+                    const FFirePathQuery& Query = Queries[Index];
+                    InGrids[Query.Grid]->FindPath(Query.Start, Query.Goal, OutPaths[Index], Context);
+                }
+            }
+        }, bSingleThread);
+}
+
+void FFirePathfinder::Update()
+{
+    if (PendingBatch.IsValid())
+    {
+        if (!PendingBatch.IsReady()) return;
+
+        ApplyBatch(PendingBatch.Get());
+        PendingBatch.Reset();
+    }
+
+    if (Queued.Num() == 0) return;
+
+    // Workers read copies, a grid is only copied again once it has changed
+    for (int32 Index = 0; Index < Grids.Num(); ++Index)
+    {
+        if (!Snapshots[Index].IsValid())
+        {
+            Snapshots[Index] = MakeShared<FFirePathGrid>(Grids[Index]);
+        }
+    }
+
+    FFirePathBatch Batch;
+    Batch.Grids = Snapshots;
+    Batch.Queries = MoveTemp(Queued);
+    Queued.Reset();
+
+    PendingBatch = Async(EAsyncExecution::ThreadPool, [Batch = MoveTemp(Batch)]() mutable
+        {
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            SearchBatch(Batch.Grids, Batch.Queries, Batch.Paths);
+            Batch.SearchMs = static_cast<float>(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+            return MoveTemp(Batch);
+        });
+}
+
+void FFirePathfinder::Flush()
+{
+    while (PendingBatch.IsValid() || Queued.Num() > 0)
+    {
+        if (PendingBatch.IsValid())
+        {
+            PendingBatch.Wait();
+        }
+        Update();
+    }
+}
+
+void FFirePathfinder::ApplyBatch(const FFirePathBatch& Batch)
+{
+    LastBatchMs = Batch.SearchMs;
+
+    for (int32 Index = 0; Index < Batch.Queries.Num(); ++Index)
+    {
+        const FFirePathQuery& Query = Batch.Queries[Index];
+        const FFirePathGrid& Searched = *Batch.Grids[Query.Grid];
+        const uint64 Key = MakeKey(Searched.FirstTile + Query.Start, Searched.FirstTile + Query.Goal);
+        QueuedKeys.Remove(Key);
+
+        FCachedPath Path;
+        Path.Grid = Query.Grid;
+        Path.GridVersion = Searched.Version;
+
+        const TArray<int32>& LocalTiles = Batch.Paths[Index];
+        Path.Tiles.Reserve(LocalTiles.Num());
+        for (const int32 Local : LocalTiles)
+        {
+            Path.Tiles.Add(Searched.FirstTile + Local);
+
+            const int32 Sector = Searched.GetSector(Local);
+            if (!Path.Sectors.Contains(Sector))
+            {
+                Path.Sectors.Add(Sector);
+                Path.SectorVersions.Add(Searched.SectorVersions[Sector]);
+            }
+        }
+
+        // Tiles on the way changed cost while it was being searched, the next request queues it again
+        if (IsCurrent(Path))
+        {
+            Cache.Add(Key, MoveTemp(Path));
+        }
+    }
+
+    if (Cache.Num() > MaxCachedPaths)
+    {
+        for (auto It = Cache.CreateIterator(); It; ++It)
+        {
+            if (!IsCurrent(It.Value())) It.RemoveCurrent();
+        }
+        if (Cache.Num() > MaxCachedPaths)
+        {
+            Cache.Reset();
+        }
+    }
+}
+
+static FAutoConsoleCommandWithArgs FirePathBenchCommand(
+    TEXT("fire.PathBench"),
+    TEXT("fire.PathBench [Agents=128] [Size=512] [Burning=0.05] [Seed=0]\n")
+    TEXT("Lays out a Size by Size grid of burnt ground and burning patches covering Burning of it, then logs how long paths ")
+    TEXT("for Agents crews take on all cores and on one thread, how fast the cache answers, and how many paths one new fire drops."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            int32 NumAgents = 128;
+            int32 Size = 512;
+            float Burning = 0.05f;
+            int32 Seed = 0;
+            for (const FString& Arg : Args)
+            {
+                FString Key, Value;
+                if (!Arg.Split(TEXT("="), &Key, &Value)) continue;
+
+                if (Key.Equals(TEXT("Agents"), ESearchCase::IgnoreCase)) NumAgents = FMath::Max(FCString::Atoi(*Value), 1);
+                else if (Key.Equals(TEXT("Size"), ESearchCase::IgnoreCase)) Size = FMath::Clamp(FCString::Atoi(*Value), 16, 4096);
+                else if (Key.Equals(TEXT("Burning"), ESearchCase::IgnoreCase)) Burning = FMath::Clamp(FCString::Atof(*Value), 0.0f, 0.5f);
+                else if (Key.Equals(TEXT("Seed"), ESearchCase::IgnoreCase)) Seed = FCString::Atoi(*Value);
+            }
+
+            FRandomStream Random(Seed);
+            FFirePathGrid Grid;
+            Grid.Init(0, Size, Size, FFirePathGrid::UnburntCost);
+
+            const auto Paint = [&Grid, Size](const FIntPoint& Centre, int32 Radius, uint8 Cost)
+                {
+                    int32 NumPainted = 0;
+                    for (int32 Y = FMath::Max(Centre.Y - Radius, 0); Y <= FMath::Min(Centre.Y + Radius, Size - 1); ++Y)
+                    {
+                        for (int32 X = FMath::Max(Centre.X - Radius, 0); X <= FMath::Min(Centre.X + Radius, Size - 1); ++X)
+                        {
+                            if ((FIntPoint(X, Y) - Centre).SizeSquared() <= Radius * Radius && Grid.SetCost(Y * Size + X, Cost)) ++NumPainted;
+                        }
+                    }
+                    return NumPainted;
+                };
+
+            // Burnt meadows over about a third of the grid, dug lines through them, then the fires
+            for (int32 Painted = 0; Painted < Size * Size / 3;)
+            {
+                Painted += Paint(FIntPoint(Random.RandHelper(Size), Random.RandHelper(Size)), Random.RandRange(4, Size / 8), FFirePathGrid::BurntCost);
+            }
+            for (int32 Line = 0; Line < Size / 16; ++Line)
+            {
+                const int32 Y = Random.RandHelper(Size);
+                for (int32 X = Random.RandHelper(Size / 2), End = FMath::Min(X + Size / 4, Size); X < End; ++X)
+                {
+                    Grid.SetCost(Y * Size + X, FFirePathGrid::BurntCost);
+                }
+            }
+            for (int32 Painted = 0; Painted < Size * Size * Burning;)
+            {
+                const int32 Radius = Random.RandRange(2, 10);
+                Painted += Paint(FIntPoint(Random.RandHelper(Size), Random.RandHelper(Size)), Radius, 0);
+                Paint(FIntPoint(Random.RandHelper(Size), Random.RandHelper(Size)), Radius / 2, FFirePathGrid::IgnitingCost);
+            }
+
+            TArray<FFirePathQuery> Queries;
+            while (Queries.Num() < NumAgents)
+            {
+                const int32 Start = Random.RandHelper(Size * Size);
+                if (Grid.Costs[Start] > 0) Queries.Add({ 0, Start, Random.RandHelper(Size * Size) });
+            }
+
+            const TArray<TSharedPtr<const FFirePathGrid>> Grids = { MakeShared<FFirePathGrid>(Grid) };
+            TArray<TArray<int32>> Paths;
+            const uint64 SingleStart = FPlatformTime::Cycles64();
+            FFirePathfinder::SearchBatch(Grids, Queries, Paths, true);
+            const double SingleMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - SingleStart);
+
+            const uint64 BatchStart = FPlatformTime::Cycles64();
+            FFirePathfinder::SearchBatch(Grids, Queries, Paths);
+            const double BatchMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - BatchStart);
+
+            int32 NumFound = 0;
+            int64 NumSteps = 0;
+            for (const TArray<int32>& Path : Paths)
+            {
+                NumFound += Path.Num() > 0;
+                NumSteps += Path.Num();
+            }
+            UE_LOG(LogTemp, Display, TEXT("fire.PathBench: %d x %d tiles, %d crews, %d paths found averaging %.0f steps"),
+                Size, Size, NumAgents, NumFound, static_cast<double>(NumSteps) / FMath::Max(NumFound, 1));
+            UE_LOG(LogTemp, Display, TEXT("fire.PathBench: %.2f ms on all cores, %.2f ms on one thread, %.1f us per path on one thread"),
+                BatchMs, SingleMs, SingleMs * 1000.0 / NumAgents);
+
+            // Same queries through the service, searched once and then answered from the cache
+            FFirePathfinder Pathfinder;
+            Pathfinder.AddGrid(0, Size, Size, FFirePathGrid::UnburntCost);
+            for (int32 Tile = 0; Tile < Size * Size; ++Tile)
+            {
+                Pathfinder.SetTileCost(Tile, Grid.Costs[Tile]);
+            }
+
+            TArray<int32> Tiles;
+            for (const FFirePathQuery& Query : Queries)
+            {
+                Pathfinder.FindPath(Query.Start, Query.Goal, Tiles);
+            }
+            Pathfinder.Flush();
+
+            const uint64 CachedStart = FPlatformTime::Cycles64();
+            for (const FFirePathQuery& Query : Queries)
+            {
+                Pathfinder.FindPath(Query.Start, Query.Goal, Tiles);
+            }
+            const double CachedMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - CachedStart);
+
+            // A new fire in the middle of the grid only drops the paths through the sectors it touches
+            for (int32 Y = Size / 2 - Size / 16; Y <= Size / 2 + Size / 16; ++Y)
+            {
+                for (int32 X = Size / 2 - Size / 16; X <= Size / 2 + Size / 16; ++X)
+                {
+                    Pathfinder.SetTileCost(Y * Size + X, 0);
+                }
+            }
+
+            int32 NumKept = 0;
+            for (const FFirePathQuery& Query : Queries)
+            {
+                NumKept += Pathfinder.FindPath(Query.Start, Query.Goal, Tiles) != EFirePathStatus::Pending;
+            }
+            Pathfinder.Flush();
+
+            UE_LOG(LogTemp, Display, TEXT("fire.PathBench: cached lookups %.1f us per path, a new fire kept %d of %d paths, the rest searched again in %.2f ms"),
+                CachedMs * 1000.0 / NumAgents, NumKept, NumAgents, Pathfinder.GetLastBatchMs());
+        }));
@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "FireTileTable.h"
+
+// Reusable A* state for one worker, nodes are only reset by moving the stamp on
+struct FFirePathScratch
+{
+	struct FOpen
+	{
+		float F = 0.0f;
+		float G = 0.0f;
+		int32 Node = INDEX_NONE;
+	};
+
+	TArray<float> G;
+	TArray<int32> Parents;
+	TArray<uint32> Stamps;
+	uint32 Stamp = 0;
+	TArray<FOpen> Open;
+
+	void Prepare(int32 NumNodes);
+};
+
+struct FFirePathSearchContext
+{
+	FFirePathScratch Tiles;
+	FFirePathScratch Sectors;
+	TArray<int32> SectorPath;
+
+	// Sectors stamped with CorridorStamp are the ones the tile search may enter
+	TArray<uint32> Corridor;
+	uint32 CorridorStamp = 0;
+};
+
+/*
+	A dense field's tiles as a walking grid, one step cost per tile and 16 by 16 tile sectors over
+	them. A sector's version moves whenever a tile in it changes cost, which is what cached paths
+	crossing it are checked against.
+*/
+struct BRIGHTSPARKSPROJECT_API FFirePathGrid
+{
+	static constexpr int32 SectorSize = 16;
+
+	// Step costs, a diagonal step costs the square root of 2 times as much
+	static constexpr uint8 BurntCost = 1;
+	static constexpr uint8 UnburntCost = 3;
+	static constexpr uint8 IgnitingCost = 8;
+
+	int32 FirstTile = INDEX_NONE;
+	int32 Columns = 0;
+	int32 Rows = 0;
+	int32 SectorColumns = 0;
+	int32 SectorRows = 0;
+
+	// Step cost of each tile, 0 where it cannot be walked
+	TArray<uint8> Costs;
+
+	// Sum and number of each sector's walkable tile costs
+	TArray<uint32> SectorCostSums;
+	TArray<uint16> SectorWalkable;
+	TArray<uint32> SectorVersions;
+
+	// Moves with every sector version
+	uint32 Version = 0;
+
+	void Init(int32 InFirstTile, int32 InColumns, int32 InRows, uint8 Cost);
+
+	// False if the tile already had the cost
+	bool SetCost(int32 Local, uint8 Cost);
+
+	bool OwnsTile(int32 Tile) const { return Tile >= FirstTile && Tile < FirstTile + Columns * Rows; }
+	int32 GetSector(int32 Local) const { return (Local / Columns / SectorSize) * SectorColumns + (Local % Columns) / SectorSize; }
+
+	// Mean cost of the sector's walkable tiles, 0 when it has none
+	float GetSectorCost(int32 Sector) const
+	{
+		return SectorWalkable[Sector] > 0 ? static_cast<float>(SectorCostSums[Sector]) / SectorWalkable[Sector] : 0.0f;
+	}
+
+	/*
+		8 way A* from Start to Goal, tiles local to the grid. A path over the sectors comes first and
+		the tile search is kept to the sectors on it and the ones around them, then every tile is
+		searched if burning tiles cut that corridor. The goal is always walkable so crews can head
+		for a burning tile. Only reads the grid, so any number of workers can search one copy
+	*/
+	bool FindPath(int32 Start, int32 Goal, TArray<int32>& OutPath, FFirePathSearchContext& Context) const;
+
+	// Burning tiles cannot be walked, burnt and dug tiles are the cheapest ground and tiles about to light the dearest
+	static uint8 GetTileCost(const FFireTileTable& Tiles, int32 Tile);
+};
+
+// A path wanted between two tiles of one grid, local to it
+struct FFirePathQuery
+{
+	int32 Grid = INDEX_NONE;
+	int32 Start = INDEX_NONE;
+	int32 Goal = INDEX_NONE;
+};
+
+// Queries searched together on worker threads, against copies of the grids taken when the batch started
+struct FFirePathBatch
+{
+	TArray<FFirePathQuery> Queries;
+
+	// Local tiles of each query's path from start to goal, empty when there is none
+	TArray<TArray<int32>> Paths;
+
+	TArray<TSharedPtr<const FFirePathGrid>> Grids;
+	float SearchMs = 0.0f;
+};
+
+/*
+	Walking paths over the dense field grids for AI crews. Paths are cached by start and goal tile
+	and stay valid while no tile in a sector they cross changes cost, so a change only drops the
+	paths through its region. Paths that are not cached are queued and searched as one batch on
+	worker threads, the results are taken in on the game thread by Update.
+*/
+class BRIGHTSPARKSPROJECT_API FFirePathfinder
+{
+public:
+	void Reset();
+
+	// Adds a grid with every tile at the cost, returns its index
+	int32 AddGrid(int32 FirstTile, int32 Columns, int32 Rows, uint8 Cost);
+
+	// Tiles in no grid are ignored
+	void SetTileCost(int32 Tile, uint8 Cost);
+
+	// Found and the path in OutTiles when a current one is cached, Pending while it is being searched.
+	// NoPath is cached too, until anything in the grid changes
+	EFirePathStatus FindPath(int32 StartTile, int32 GoalTile, TArray<int32>& OutTiles);
+
+	// Takes in the batch in flight once it is done and launches the queued queries, one batch at a time
+	void Update();
+
+	// Runs Update until nothing is queued or in flight
+	void Flush();
+
+	int32 GetNumCachedPaths() const { return Cache.Num(); }
+	int32 GetNumQueuedPaths() const { return QueuedKeys.Num(); }
+	float GetLastBatchMs() const { return LastBatchMs; }
+
+	// Searches every query, on all cores unless bSingleThread
+	static void SearchBatch(TArrayView<const TSharedPtr<const FFirePathGrid>> InGrids, TArrayView<const FFirePathQuery> Queries, TArray<TArray<int32>>& OutPaths, bool bSingleThread = false);
+
+private:
+	struct FCachedPath
+	{
+		int32 Grid = INDEX_NONE;
+		TArray<int32> Tiles;
+
+		// Sectors the path crosses and their versions when it was searched
+		TArray<int32, TInlineAllocator<8>> Sectors;
+		TArray<uint32, TInlineAllocator<8>> SectorVersions;
+
+		// The whole grid's version, what a path that was not found is checked against
+		uint32 GridVersion = 0;
+	};
+
+	static uint64 MakeKey(int32 StartTile, int32 GoalTile) { return (static_cast<uint64>(StartTile) << 32) | static_cast<uint32>(GoalTile); }
+
+	int32 FindGrid(int32 Tile) const;
+	bool IsCurrent(const FCachedPath& Path) const;
+	void ApplyBatch(const FFirePathBatch& Batch);
+
+	TArray<FFirePathGrid> Grids;
+
+	// Copy of each grid the workers read, null once the grid has changed since it was taken
+	TArray<TSharedPtr<const FFirePathGrid>> Snapshots;
+
+	TMap<uint64, FCachedPath> Cache;
+	TArray<FFirePathQuery> Queued;
+
+	// Keys queued or in flight
+	TSet<uint64> QueuedKeys;
+
+	TFuture<FFirePathBatch> PendingBatch;
+	float LastBatchMs = 0.0f;
+};
@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireReplay.h"
+#include "FireTileTable.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+
+// Writer
+FFireReplayWriter::~FFireReplayWriter()
+{
+    Close();
+}
+
+bool FFireReplayWriter::Open(const FString& FilePath, const TArray<uint8>& Snapshot, double InStartTime)
+{
+    Close();
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+
+    FileHandle.Reset(PlatformFile.OpenWrite(*FilePath));
+    if (!FileHandle) return false;
+
+    StartTime = InStartTime;
+    LastTimeMs = 0;
+    NumRecords = 0;
+
+    Buffer.Reset();
+    FMemoryWriter Header(Buffer);
+    uint32 Magic = FireReplay::Magic;
+    uint16 Version = FireReplay::Version;
+    uint32 SnapshotSize = Snapshot.Num();
+    Header << Magic << Version << SnapshotSize;
+    Header.Serialize(const_cast<uint8*>(Snapshot.GetData()), Snapshot.Num());
+
+    Flush();
+    return true;
+}
+
+void FFireReplayWriter::Close()
+{
+    if (!FileHandle) return;
+
+    Flush();
+    FileHandle.Reset();
+}
+
+void FFireReplayWriter::Append(double Time, int32 TileIndex, EFireEventType Type, EFireIgniteSource Source)
+{
+    // Times are kept as whole milliseconds from the start so rounding never drifts
+    const int64 TimeMs = FMath::RoundToInt64((Time - StartTime) * 1000.0);
+    const int64 DeltaMs = FMath::Max<int64>(TimeMs - LastTimeMs, 0);
+    LastTimeMs += DeltaMs;
+
+    Buffer.Add(static_cast<uint8>(Type) | (static_cast<uint8>(Source) << 2));
+    FireEncoding::WriteVarint(Buffer, DeltaMs);
+    FireEncoding::WriteVarint(Buffer, TileIndex);
+    ++NumRecords;
+}
+
+void FFireReplayWriter::Flush()
+{
+    if (!FileHandle || Buffer.Num() == 0) return;
+
+    FileHandle->Write(Buffer.GetData(), Buffer.Num());
+    Buffer.Reset();
+}
+
+// Reader
+FFireReplayReader::~FFireReplayReader()
+{
+    Close();
+}
+
+bool FFireReplayReader::Open(const FString& FilePath)
+{
+    Close();
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    MappedFile.Reset(PlatformFile.OpenMapped(*FilePath));
+    if (MappedFile)
+    {
+        MappedRegion.Reset(MappedFile->MapRegion());
+    }
+
+    if (MappedRegion)
+    {
+        Data = MappedRegion->GetMappedPtr();
+        Size = MappedRegion->GetMappedSize();
+    }
+    else
+    {
+        if (!FFileHelper::LoadFileToArray(FileData, *FilePath)) return false;
+        Data = FileData.GetData();
+        Size = FileData.Num();
+    }
+
+    // Same layout FMemoryWriter gave the header in Open
+    uint32 Magic = 0;
+    uint16 Version = 0;
+    uint32 SnapshotSize = 0;
+    constexpr int64 HeaderSize = sizeof(Magic) + sizeof(Version) + sizeof(SnapshotSize);
+    if (Size >= HeaderSize)
+    {
+        FMemory::Memcpy(&Magic, Data, sizeof(Magic));
+        FMemory::Memcpy(&Version, Data + sizeof(Magic), sizeof(Version));
+        FMemory::Memcpy(&SnapshotSize, Data + sizeof(Magic) + sizeof(Version), sizeof(SnapshotSize));
+    }
+
+    if (Magic != FireReplay::Magic || Version != FireReplay::Version || SnapshotSize > Size - HeaderSize)
+    {
+        Close();
+        return false;
+    }
+
+    Snapshot.SetNumUninitialized(SnapshotSize);
+    FMemory::Memcpy(Snapshot.GetData(), Data + HeaderSize, SnapshotSize);
+
+    Offset = HeaderSize + SnapshotSize;
+    TimeMs = 0;
+    return true;
+}
+
+void FFireReplayReader::Close()
+{
+    // The region has to go before the file it maps
+    MappedRegion.Reset();
+    MappedFile.Reset();
+    FileData.Empty();
+    Snapshot.Empty();
+    Data = nullptr;
+    Size = 0;
+    Offset = 0;
+    TimeMs = 0;
+}
+
+bool FFireReplayReader::Decode(int64& InOutOffset, int64& InOutTimeMs, FFireEventRecord& OutRecord) const
+{
+    if (!Data || InOutOffset >= Size) return false;
+
+    const uint8 TypeAndSource = Data[InOutOffset++];
+
+    uint64 DeltaMs = 0;
+    uint64 TileIndex = 0;
+    if (!FireEncoding::ReadVarint(Data, Size, InOutOffset, DeltaMs) || !FireEncoding::ReadVarint(Data, Size, InOutOffset, TileIndex)) return false;
+
+    InOutTimeMs += DeltaMs;
+
+    OutRecord.Time = InOutTimeMs / 1000.0;
+    OutRecord.TileIndex = static_cast<int32>(TileIndex);
+    OutRecord.Type = static_cast<EFireEventType>(TypeAndSource & 0x3);
+    OutRecord.Source = static_cast<EFireIgniteSource>((TypeAndSource >> 2) & 0x3);
+    return true;
+}
+
+bool FFireReplayReader::Peek(FFireEventRecord& OutRecord) const
+{
+    int64 PeekOffset = Offset;
+    int64 PeekTimeMs = TimeMs;
+    return Decode(PeekOffset, PeekTimeMs, OutRecord);
+}
+
+bool FFireReplayReader::Next(FFireEventRecord& OutRecord)
+{
+    int64 NextOffset = Offset;
+    int64 NextTimeMs = TimeMs;
+    if (!Decode(NextOffset, NextTimeMs, OutRecord)) return false;
+
+    Offset = NextOffset;
+    TimeMs = NextTimeMs;
+    return true;
+}
+
+bool FFireReplayReader::IsAtEnd() const
+{
+    FFireEventRecord Record;
+    return !Peek(Record);
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireHitchWatchdog.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/*
+	Fire replay file, Saved/FireReplays/<Name>.frep:
+		uint32   magic "FREP"
+		uint16   version
+		uint32   snapshot size, then a UFireSpreadSubsystem snapshot of the state recording started from
+	followed by one record per fire transition until the end of the file:
+		1 byte   EFireEventType in bits 0-1, EFireIgniteSource in bits 2-3
+		varint   milliseconds since the previous record
+		varint   tile index
+*/
+namespace FireReplay
+{
+	constexpr uint32 Magic = 0x50455246;
+	constexpr uint16 Version = 1;
+}
+
+// Appends records to a replay file, buffered and written once per frame
+class BRIGHTSPARKSPROJECT_API FFireReplayWriter
+{
+public:
+	~FFireReplayWriter();
+
+	// Creates the file and writes the header, record times are taken relative to StartTime
+	bool Open(const FString& FilePath, const TArray<uint8>& Snapshot, double StartTime);
+	void Close();
+	bool IsOpen() const { return FileHandle.IsValid(); }
+
+	void Append(double Time, int32 TileIndex, EFireEventType Type, EFireIgniteSource Source);
+
+	// Writes the buffered records to the end of the file
+	void Flush();
+
+	int64 GetNumRecords() const { return NumRecords; }
+
+private:
+	TUniquePtr<IFileHandle> FileHandle;
+	TArray<uint8> Buffer;
+	double StartTime = 0.0;
+	int64 LastTimeMs = 0;
+	int64 NumRecords = 0;
+};
+
+// Reads a replay file through a memory mapping, records are decoded in place as playback asks for them
+class BRIGHTSPARKSPROJECT_API FFireReplayReader
+{
+public:
+	~FFireReplayReader();
+
+	// Maps the file and reads the header, returns false if it is not a fire replay
+	bool Open(const FString& FilePath);
+	void Close();
+
+	const TArray<uint8>& GetSnapshot() const { return Snapshot; }
+
+	// Record times are seconds from the start of the recording
+	bool Peek(FFireEventRecord& OutRecord) const;
+	bool Next(FFireEventRecord& OutRecord);
+
+	// True at the end of the file, or at a record cut short by the recording stopping mid write
+	bool IsAtEnd() const;
+
+private:
+	bool Decode(int64& InOutOffset, int64& InOutTimeMs, FFireEventRecord& OutRecord) const;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	// Used instead of the mapping on platforms that cannot map files
+	TArray<uint8> FileData;
+
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	int64 Offset = 0;
+	int64 TimeMs = 0;
+
+	TArray<uint8> Snapshot;
+};
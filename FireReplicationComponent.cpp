@@ -0,0 +1,328 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireReplicationComponent.h"
+#include "FireSpreadSubsystem.h"
+#include "FireTileTable.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Encode Tile Deltas"), STAT_FireEncodeTileDeltas, STATGROUP_FireSpread);
+DECLARE_CYCLE_STAT(TEXT("Decode Tile Deltas"), STAT_FireDecodeTileDeltas, STATGROUP_FireSpread);
+
+static TAutoConsoleVariable<float> CVarFireNetBytesPerSecond(
+    TEXT("fire.Net.BytesPerSecond"),
+    16000.0f,
+    TEXT("Bytes per second of tile state each client may be sent. Changes over the limit wait for later frames."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFireNetMaxPayloadBytes(
+    TEXT("fire.Net.MaxPayloadBytes"),
+    1024,
+    TEXT("Largest tile delta payload sent to a client in one frame, a single chunk may go over it."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFireNetLogStats(
+    TEXT("fire.Net.LogStats"),
+    0,
+    TEXT("1 logs bandwidth and CPU for every fire replication connection once a second."),
+    ECVF_Default);
+
+namespace
+{
+    constexpr uint8 UnknownState = 0xFF;
+}
+
+UFireReplicationComponent::UFireReplicationComponent()
+{
+    PrimaryComponentTick.bCanEverTick = true;
+    SetIsReplicatedByDefault(true);
+}
+
+void UFireReplicationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+    APlayerController* PC = Cast<APlayerController>(GetOwner());
+    if (!FireSubsystem || !PC) return;
+
+    // A listen server's own player sees the simulation directly
+    if (FireSubsystem->HasSimulationAuthority() && !PC->IsLocalController())
+    {
+        TickServer(*FireSubsystem, DeltaTime);
+    }
+    else if (!FireSubsystem->HasSimulationAuthority() && HeldPayloads.Num() > 0 && IsLayoutReady(*FireSubsystem))
+    {
+        for (const TArray<uint8>& Payload : HeldPayloads)
+        {
+            DecodePayload(*FireSubsystem, Payload);
+        }
+        HeldPayloads.Empty();
+    }
+
+    TickMetrics(DeltaTime);
+}
+
+// Server Side
+void UFireReplicationComponent::TickServer(UFireSpreadSubsystem& FireSubsystem, float DeltaTime)
+{
+    const FFireTileTable& Tiles = FireSubsystem.GetTiles();
+    if (Tiles.Num() == 0) return;
+
+    // First send, or more tiles registered since: the client gets the layout and everything again
+    if (KnownStates.Num() != Tiles.Num())
+    {
+        ClientReceiveLayout(Tiles.Num(), static_cast<int32>(FireSubsystem.ComputeLayoutHash()));
+        KnownStates.Init(UnknownState, Tiles.Num());
+        SentChunkVersions.Init(MAX_uint32, Tiles.NumChunks());
+        NextChunk = 0;
+    }
+
+    const float Rate = CVarFireNetBytesPerSecond.GetValueOnGameThread();
+    ByteAllowance = FMath::Min(ByteAllowance + Rate * DeltaTime, Rate);
+    if (ByteAllowance <= 0.0f) return;
+
+    SCOPE_CYCLE_COUNTER(STAT_FireEncodeTileDeltas);
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    const int32 MaxPayload = FMath::Min(FMath::FloorToInt(ByteAllowance), CVarFireNetMaxPayloadBytes.GetValueOnGameThread());
+    const int32 NumChunks = Tiles.NumChunks();
+
+    TArray<uint8>& Payload = SendPayload;
+    Payload.Reset();
+    int32 TilesSent = 0;
+    int32 ResumeChunk = NextChunk;
+    PendingChunks = 0;
+
+    for (int32 i = 0; i < NumChunks; ++i)
+    {
+        const int32 Chunk = (NextChunk + i) % NumChunks;
+        const uint32 Version = FireSubsystem.GetChunkVersion(Chunk);
+        if (SentChunkVersions[Chunk] == Version) continue;
+
+        if (Payload.Num() >= MaxPayload)
+        {
+            if (PendingChunks == 0) ResumeChunk = Chunk;
+            ++PendingChunks;
+            continue;
+        }
+
+        TilesSent += EncodeChunk(Tiles, Chunk, Payload);
+        SentChunkVersions[Chunk] = Version;
+    }
+    NextChunk = ResumeChunk;
+
+    if (Payload.Num() > 0)
+    {
+        ClientReceiveTileDeltas(Payload);
+
+        // A chunk bigger than the allowance leaves it negative, which holds back the next sends
+        ByteAllowance -= Payload.Num();
+        WindowBytes += Payload.Num();
+        WindowTiles += TilesSent;
+        TotalBytes += Payload.Num();
+    }
+
+    WindowCycles += FPlatformTime::Cycles64() - StartCycles;
+}
+
+int32 UFireReplicationComponent::EncodeChunk(const FFireTileTable& Tiles, int32 Chunk, TArray<uint8>& Out)
+{
+    const int32 First = Chunk << FireTileChunkShift;
+    const int32 End = FMath::Min(First + FireTileChunkSize, Tiles.Num());
+
+    DirtyStates.Reset();
+    const int32 Start = Out.Num();
+    FireEncoding::WriteVarint(Out, Chunk);
+
+    // Dirty bitmap as run lengths, starting with a clean run that may be empty
+    bool bInDirtyRun = false;
+    int32 RunStart = First;
+    for (int32 Tile = First; Tile < End; ++Tile)
+    {
+        const uint8 State = static_cast<uint8>(Tiles.GetVisual(Tile));
+        const bool bDirty = KnownStates[Tile] != State;
+        if (bDirty != bInDirtyRun)
+        {
+            FireEncoding::WriteVarint(Out, Tile - RunStart);
+            RunStart = Tile;
+            bInDirtyRun = bDirty;
+        }
+        if (bDirty)
+        {
+            DirtyStates.Add(State);
+            KnownStates[Tile] = State;
+        }
+    }
+
+    // Version bumps that ended in the same state need nothing sent
+    if (DirtyStates.Num() == 0)
+    {
+        Out.SetNum(Start, false);
+        return 0;
+    }
+    FireEncoding::WriteVarint(Out, End - RunStart);
+
+    // States of the dirty tiles, run length encoded since a fire front changes in long same state runs
+    int32 Index = 0;
+    while (Index < DirtyStates.Num())
+    {
+        int32 RunEnd = Index + 1;
+        while (RunEnd < DirtyStates.Num() && DirtyStates[RunEnd] == DirtyStates[Index])
+        {
+            ++RunEnd;
+        }
+        FireEncoding::WriteVarint(Out, RunEnd - Index);
+        Out.Add(DirtyStates[Index]);
+        Index = RunEnd;
+    }
+
+    return DirtyStates.Num();
+}
+
+// Client Side
+void UFireReplicationComponent::ClientReceiveLayout_Implementation(int32 NumTiles, int32 LayoutHash)
+{
+    ExpectedNumTiles = NumTiles;
+    ExpectedLayoutHash = static_cast<uint32>(LayoutHash);
+    bLayoutReady = false;
+    bWarnedLayout = false;
+    HeldPayloads.Empty();
+}
+
+void UFireReplicationComponent::ClientReceiveTileDeltas_Implementation(const TArray<uint8>& Payload)
+{
+    UFireSpreadSubsystem* FireSubsystem = GetWorld()->GetSubsystem<UFireSpreadSubsystem>();
+    if (!FireSubsystem) return;
+
+    // Deltas build on each other, so hold them in order until the tiles are ready
+    if (HeldPayloads.Num() > 0 || !IsLayoutReady(*FireSubsystem))
+    {
+        HeldPayloads.Add(Payload);
+        return;
+    }
+
+    DecodePayload(*FireSubsystem, Payload);
+}
+
+bool UFireReplicationComponent::IsLayoutReady(const UFireSpreadSubsystem& FireSubsystem)
+{
+    if (bLayoutReady) return true;
+    if (ExpectedNumTiles == INDEX_NONE) return false;
+
+    // Patches can still be registering, only a count match is worth hashing
+    if (FireSubsystem.GetNumTiles() == ExpectedNumTiles)
+    {
+        bLayoutReady = FireSubsystem.ComputeLayoutHash() == ExpectedLayoutHash;
+    }
+
+    if (!bLayoutReady && !bWarnedLayout && FireSubsystem.GetNumTiles() >= ExpectedNumTiles)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Fire replication: client tiles (%d) do not match the server (%d), holding deltas"),
+            FireSubsystem.GetNumTiles(), ExpectedNumTiles);
+        bWarnedLayout = true;
+    }
+    return bLayoutReady;
+}
+
+bool UFireReplicationComponent::DecodePayload(UFireSpreadSubsystem& FireSubsystem, const TArray<uint8>& Payload)
+{
+    SCOPE_CYCLE_COUNTER(STAT_FireDecodeTileDeltas);
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    const FFireTileTable& Tiles = FireSubsystem.GetTiles();
+    const uint8* Data = Payload.GetData();
+    const int64 Size = Payload.Num();
+    int64 Offset = 0;
+    int32 TilesApplied = 0;
+    bool bValid = true;
+
+    while (bValid && Offset < Size)
+    {
+        uint64 Chunk = 0;
+        if (!FireEncoding::ReadVarint(Data, Size, Offset, Chunk) || Chunk >= static_cast<uint64>(Tiles.NumChunks()))
+        {
+            bValid = false;
+            break;
+        }
+
+        const int32 First = static_cast<int32>(Chunk) << FireTileChunkShift;
+        const int32 End = FMath::Min(First + FireTileChunkSize, Tiles.Num());
+
+        DirtyTiles.Reset();
+        bool bDirtyRun = false;
+        int32 Tile = First;
+        while (Tile < End)
+        {
+            uint64 Run = 0;
+            if (!FireEncoding::ReadVarint(Data, Size, Offset, Run) || Run > static_cast<uint64>(End - Tile))
+            {
+                bValid = false;
+                break;
+            }
+            if (bDirtyRun)
+            {
+                for (int32 i = 0; i < static_cast<int32>(Run); ++i)
+                {
+                    DirtyTiles.Add(Tile + i);
+                }
+            }
+            Tile += static_cast<int32>(Run);
+            bDirtyRun = !bDirtyRun;
+        }
+
+        int32 Applied = 0;
+        while (bValid && Applied < DirtyTiles.Num())
+        {
+            uint64 Run = 0;
+            if (!FireEncoding::ReadVarint(Data, Size, Offset, Run) || Offset >= Size ||
+                Run == 0 || Run > static_cast<uint64>(DirtyTiles.Num() - Applied) || Data[Offset] > static_cast<uint8>(EFireTileVisual::Dug))
+            {
+                bValid = false;
+                break;
+            }
+
+            const EFireTileVisual Visual = static_cast<EFireTileVisual>(Data[Offset++]);
+            for (int32 i = 0; i < static_cast<int32>(Run); ++i)
+            {
+                FireSubsystem.ApplyReplicatedTileVisual(DirtyTiles[Applied++], Visual);
+            }
+        }
+        TilesApplied += Applied;
+    }
+
+    if (!bValid)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Fire replication: dropped the rest of a malformed %d byte payload"), Payload.Num());
+    }
+
+    WindowBytes += Payload.Num();
+    WindowTiles += TilesApplied;
+    TotalBytes += Payload.Num();
+    WindowCycles += FPlatformTime::Cycles64() - StartCycles;
+    return bValid;
+}
+
+void UFireReplicationComponent::TickMetrics(float DeltaTime)
+{
+    WindowSeconds += DeltaTime;
+    if (WindowSeconds < 1.0) return;
+
+    BytesPerSecond = static_cast<float>(WindowBytes / WindowSeconds);
+    TilesPerSecond = static_cast<float>(WindowTiles / WindowSeconds);
+    CpuMsPerSecond = static_cast<float>(FPlatformTime::ToMilliseconds64(WindowCycles) / WindowSeconds);
+
+    if (CVarFireNetLogStats.GetValueOnGameThread() != 0 && (WindowBytes > 0 || PendingChunks > 0))
+    {
+        APlayerController* PC = Cast<APlayerController>(GetOwner());
+        const FString Remote = PC && PC->NetConnection ? PC->NetConnection->LowLevelGetRemoteAddress(true) : TEXT("local");
+        UE_LOG(LogTemp, Display, TEXT("Fire replication %s (%s): %.2f KB/s, %.0f tiles/s, %.3f ms CPU/s, %d chunks pending, %lld bytes total"),
+            *GetNameSafe(PC), *Remote, BytesPerSecond / 1024.0f, TilesPerSecond, CpuMsPerSecond, PendingChunks, TotalBytes);
+    }
+
+    WindowSeconds = 0.0;
+    WindowBytes = 0;
+    WindowTiles = 0;
+    WindowCycles = 0;
+}
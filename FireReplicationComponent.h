@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "FireReplicationComponent.generated.h"
+
+class UFireSpreadSubsystem;
+struct FFireTileTable;
+
+/*
+	Sends the fire subsystem's tile states to one client, living on that client's player controller.
+	Patch actors and fields do not replicate, instead the server compares each tile chunk against
+	what this client was last sent and ships only the changes, under a per client byte budget.
+	Payload, repeated per chunk:
+		varint   chunk index
+		varints  dirty bitmap of the chunk as alternating clean / dirty run lengths, clean first
+		pairs    changed tiles in order as (varint run length, EFireTileVisual byte)
+	The client applies the states through the subsystem so visuals are rebuilt by its normal batch.
+*/
+UCLASS(ClassGroup = (Fire), meta = (BlueprintSpawnableComponent))
+class BRIGHTSPARKSPROJECT_API UFireReplicationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFireReplicationComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Sent before any deltas so the client can check it has the same tile layout as the server
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveLayout(int32 NumTiles, int32 LayoutHash);
+
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveTileDeltas(const TArray<uint8>& Payload);
+
+	// Connection Metrics, for sends on the server and receives on the client, over the last second
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Replication")
+	float BytesPerSecond = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Replication")
+	float TilesPerSecond = 0.0f;
+
+	// Game thread time spent encoding or decoding payloads
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Replication")
+	float CpuMsPerSecond = 0.0f;
+
+	// Changed chunks held back by the bandwidth limit
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Replication")
+	int32 PendingChunks = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Replication")
+	int64 TotalBytes = 0;
+
+private:
+	void TickServer(UFireSpreadSubsystem& FireSubsystem, float DeltaTime);
+	void TickMetrics(float DeltaTime);
+
+	// Appends the chunk's changes against KnownStates, returns how many tiles changed
+	int32 EncodeChunk(const FFireTileTable& Tiles, int32 Chunk, TArray<uint8>& Out);
+
+	// Applies one payload, false if it was malformed
+	bool DecodePayload(UFireSpreadSubsystem& FireSubsystem, const TArray<uint8>& Payload);
+
+	// Client side, true once the local tiles match the layout the server sent
+	bool IsLayoutReady(const UFireSpreadSubsystem& FireSubsystem);
+
+	// Server Side
+	// Visual state this client was last sent per tile, 0xFF before its first send
+	TArray<uint8> KnownStates;
+
+	// Subsystem chunk version each chunk had when it was last sent
+	TArray<uint32> SentChunkVersions;
+
+	// Chunk the next send starts from, so a tight budget still reaches every chunk
+	int32 NextChunk = 0;
+	float ByteAllowance = 0.0f;
+
+	// Reused between sends
+	TArray<uint8> SendPayload;
+
+	// Client Side
+	int32 ExpectedNumTiles = INDEX_NONE;
+	uint32 ExpectedLayoutHash = 0;
+	bool bLayoutReady = false;
+	bool bWarnedLayout = false;
+
+	// Payloads that arrived before the client's tiles had all registered
+	TArray<TArray<uint8>> HeldPayloads;
+
+	// Reused between payloads
+	TArray<uint8> DirtyStates;
+	TArray<int32> DirtyTiles;
+
+	// Current metrics window
+	double WindowSeconds = 0.0;
+	int64 WindowBytes = 0;
+	int64 WindowTiles = 0;
+	uint64 WindowCycles = 0;
+};
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireSimulation.h"
+
+namespace
+{
+    struct FSimEventDueBefore
+    {
+        template <typename EventType>
+        bool operator()(const EventType& A, const EventType& B) const
+        {
+            return A.DueTime < B.DueTime;
+        }
+    };
+
+    bool IsLost(EFireTileFlags Flags)
+    {
+        return EnumHasAnyFlags(Flags, EFireTileFlags::Burning | EFireTileFlags::Burnt);
+    }
+}
+
+FFireHeadlessSim::FFireHeadlessSim(const FFireTileTable& InLayout, const FFireSpreadWeights& InSpreadWeights)
+    : Layout(InLayout)
+    , SpreadWeights(InSpreadWeights)
+{
+}
+
+FFireSimResult FFireHeadlessSim::Run(const FFireSimParams& InParams, int32 Seed, TArrayView<const FFireHistoryEvent> StartEvents, TArrayView<const FFireEventRecord> Plan)
+{
+    Params = &InParams;
+    Random.Initialize(Seed);
+    Now = 0.0;
+
+    // Copying into the arrays kept from the last run reuses their allocations
+    Flags = Layout.Flags;
+    BurnTypes = Layout.BurnTypes;
+
+    // Tiles the start events give no burn out for are taken as just lit
+    BurnOutTimes.SetNumUninitialized(Layout.Num());
+    for (int32 Tile = 0; Tile < Layout.Num(); ++Tile)
+    {
+        BurnOutTimes[Tile] = Params->BurnDuration > 0.0f ? Params->BurnDuration : Layout.BurnDurations[Tile];
+    }
+
+    NumBurning = NumBurnable = NumBurnableLost = NumSpecial = NumSpecialLost = 0;
+    for (int32 Tile = 0; Tile < Flags.Num(); ++Tile)
+    {
+        EnumRemoveFlags(Flags[Tile], EFireTileFlags::PendingIgnition | EFireTileFlags::VisualDirty);
+
+        const bool bLost = IsLost(Flags[Tile]);
+        NumBurning += EnumHasAnyFlags(Flags[Tile], EFireTileFlags::Burning) ? 1 : 0;
+
+        if (FFireTileTable::IsBurnableType(BurnTypes[Tile]))
+        {
+            NumBurnable++;
+            NumBurnableLost += bLost ? 1 : 0;
+        }
+        if (EnumHasAnyFlags(Flags[Tile], EFireTileFlags::Special))
+        {
+            NumSpecial++;
+            NumSpecialLost += bLost ? 1 : 0;
+        }
+    }
+
+    Queue.Reset();
+    for (const FFireHistoryEvent& Event : StartEvents)
+    {
+        if (Layout.IsValidIndex(Event.TileIndex))
+        {
+            Schedule(Event.TileIndex, Event.Type, Event.Remaining);
+        }
+    }
+
+    FFireSimResult Result;
+    double NextCheck = Params->CheckInterval;
+    int32 PlanIndex = 0;
+
+    while (true)
+    {
+        const double NextEvent = Queue.Num() > 0 ? Queue.HeapTop().DueTime : DBL_MAX;
+        const double NextInput = PlanIndex < Plan.Num() ? Plan[PlanIndex].Time : DBL_MAX;
+
+        // Events due on the check itself run before it, as the subsystem ticks before the game mode's timers
+        if (NextCheck < NextEvent && NextCheck < NextInput)
+        {
+            Now = NextCheck;
+            if (CheckGameEnded(Result)) break;
+
+            if (Now >= Params->MaxSeconds)
+            {
+                Result.End = EFireSimEnd::Timeout;
+                Result.EndTime = static_cast<float>(Now);
+                break;
+            }
+            NextCheck += Params->CheckInterval;
+            continue;
+        }
+
+        if (NextInput <= NextEvent)
+        {
+            const FFireEventRecord& Input = Plan[PlanIndex++];
+            Now = Input.Time;
+            if (!Layout.IsValidIndex(Input.TileIndex)) continue;
+
+            if (Input.Type == EFireEventType::Dig)
+            {
+                Dig(Input.TileIndex);
+            }
+            else if (Input.Type == EFireEventType::Ignite)
+            {
+                Ignite(Input.TileIndex);
+            }
+            continue;
+        }
+
+        FSimEvent Event;
+        Queue.HeapPop(Event, FSimEventDueBefore(), false);
+        Now = Event.DueTime;
+        Result.EventsRun++;
+
+        if (Event.Type == EFireEventType::Spread)
+        {
+            Spread(Event.TileIndex);
+        }
+        else if (Event.Type == EFireEventType::BurnOut)
+        {
+            BurnOut(Event.TileIndex);
+        }
+    }
+
+    Result.SpecialTiles = NumSpecial;
+    Result.SpecialTilesLost = NumSpecialLost;
+    Params = nullptr;
+    return Result;
+}
+
+bool FFireHeadlessSim::CheckGameEnded(FFireSimResult& OutResult) const
+{
+    // AFireGameMode::CheckGameOverConditions
+    OutResult.BurnPercent = NumBurnable > 0 ? NumBurnableLost / static_cast<float>(NumBurnable) : 0.0f;
+
+    const bool bOverBurnt = NumBurnable > 0 && OutResult.BurnPercent >= Params->BurnedThresholdPercent / 100.0f;
+    const bool bSpecialLost = NumSpecial > 0 && NumSpecialLost >= NumSpecial;
+
+    if (bOverBurnt || bSpecialLost)
+    {
+        OutResult.End = bOverBurnt ? EFireSimEnd::OverBurn : EFireSimEnd::SpecialTiles;
+        OutResult.bWon = false;
+        OutResult.SavedPercent = 0;
+        OutResult.Rank = EGameRank::E;
+        OutResult.EndTime = static_cast<float>(Now);
+        return true;
+    }
+
+    // AFireGameMode::CheckGameWinConditions
+    if (Now >= Params->MinWinTime && NumBurning == 0)
+    {
+        OutResult.End = EFireSimEnd::Extinguished;
+        OutResult.bWon = true;
+        OutResult.SavedPercent = FMath::RoundToInt(100.0f - OutResult.BurnPercent * 100.0f);
+        OutResult.Rank = Params->GetRank(OutResult.SavedPercent);
+        OutResult.EndTime = static_cast<float>(Now);
+        return true;
+    }
+    return false;
+}
+
+// Transitions, same rules as UFireSpreadSubsystem
+bool FFireHeadlessSim::Ignite(int32 Tile)
+{
+    if (!FFireTileTable::CanIgnite(Flags[Tile], BurnTypes[Tile])) return false;
+
+    EnumAddFlags(Flags[Tile], EFireTileFlags::Burning);
+    NumBurning++;
+    NumBurnableLost += FFireTileTable::IsBurnableType(BurnTypes[Tile]) ? 1 : 0;
+    NumSpecialLost += EnumHasAnyFlags(Flags[Tile], EFireTileFlags::Special) ? 1 : 0;
+
+    const float BurnDuration = Params->BurnDuration > 0.0f ? Params->BurnDuration : Layout.BurnDurations[Tile];
+    Schedule(Tile, EFireEventType::BurnOut, BurnDuration);
+
+    const float SpreadDelay = Params->GetSpreadDelayScale(BurnTypes[Tile]) *
+        Random.FRandRange(Layout.MinSpreadDelays[Tile], Layout.MaxSpreadDelays[Tile]);
+    Schedule(Tile, EFireEventType::Spread, SpreadDelay);
+    return true;
+}
+
+void FFireHeadlessSim::Spread(int32 Tile)
+{
+    // The fuel left is the load scaled by the share of the burn time still to go
+    const float BurnDuration = Params->BurnDuration > 0.0f ? Params->BurnDuration : Layout.BurnDurations[Tile];
+    const float Fuel = Layout.FuelLoads[Tile] * FMath::Max(static_cast<float>(BurnOutTimes[Tile] - Now), 0.0f) / FMath::Max(BurnDuration, KINDA_SMALL_NUMBER);
+    const int32 MaxPicks = FFireSpreadWeights::GetMaxPicks(Fuel, Params->FullIntensityFuel);
+
+    SpreadWeights.PickBuiltNeighbours(Tile, MaxPicks, Random,
+        [this](int32 Neighbour) { return FFireTileTable::CanSpreadInto(Flags[Neighbour]); },
+        Picked);
+
+    for (int32 Neighbour : Picked)
+    {
+        Ignite(Neighbour);
+    }
+}
+
+void FFireHeadlessSim::BurnOut(int32 Tile)
+{
+    if (EnumHasAnyFlags(Flags[Tile], EFireTileFlags::Burning))
+    {
+        EnumRemoveFlags(Flags[Tile], EFireTileFlags::Burning);
+        NumBurning--;
+    }
+    EnumAddFlags(Flags[Tile], EFireTileFlags::Burnt);
+}
+
+bool FFireHeadlessSim::Dig(int32 Tile)
+{
+    if (EnumHasAnyFlags(Flags[Tile], EFireTileFlags::Burning | EFireTileFlags::Burnt | EFireTileFlags::Dug)) return false;
+
+    // A dug tile stops counting towards the burnable total, as it does for EvaluateBurnPercentage
+    NumBurnable -= FFireTileTable::IsBurnableType(BurnTypes[Tile]) ? 1 : 0;
+
+    EnumAddFlags(Flags[Tile], EFireTileFlags::Dug);
+    BurnTypes[Tile] = ESurfaceBurnType::Dug;
+    return true;
+}
+
+void FFireHeadlessSim::Schedule(int32 Tile, EFireEventType Type, float Delay)
+{
+    FSimEvent Event;
+    Event.DueTime = Now + Delay;
+    Event.TileIndex = Tile;
+    Event.Type = Type;
+    Queue.HeapPush(Event, FSimEventDueBefore());
+
+    if (Type == EFireEventType::BurnOut)
+    {
+        BurnOutTimes[Tile] = Event.DueTime;
+    }
+}
@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireGameMode.h"
+#include "FireHistory.h"
+#include "FireHitchWatchdog.h"
+#include "FireSpreadWeights.h"
+#include "FireTileTable.h"
+
+// Rules and tuning a headless run is played with, the defaults match the game
+struct FFireSimParams
+{
+	// AFireGameMode::BurnedThresholdPercent
+	float BurnedThresholdPercent = 70.0f;
+
+	// Lowest SavedPercent for SS, S, A, B, C and D in that order, see AFireGameMode::GetThresholdForRank
+	float RankThresholds[6] = { 80.0f, 70.0f, 60.0f, 50.0f, 40.0f, 0.0f };
+
+	// Multipliers on the random spread delay, see FFireTileTable::GetSpreadDelayScale
+	float QuickDelayScale = 2.0f;
+	float SlowDelayScale = 5.0f;
+
+	// Used for every tile instead of its own burn duration when above 0
+	float BurnDuration = 0.0f;
+
+	// Fuel a tile needs left to spread into 3 neighbours, fire.Fuel.FullIntensity
+	float FullIntensityFuel = 15.0f;
+
+	// Game mode check timers, the win check only counts after MinWinTime like CheckGameWinConditions
+	float CheckInterval = 2.0f;
+	float MinWinTime = 10.0f;
+
+	// Runs still going after this long end as a timeout
+	float MaxSeconds = 3600.0f;
+
+	float GetSpreadDelayScale(ESurfaceBurnType Type) const
+	{
+		switch (Type)
+		{
+		case ESurfaceBurnType::Quick: return QuickDelayScale;
+		case ESurfaceBurnType::Slow:  return SlowDelayScale;
+		default:                      return 0.0f;
+		}
+	}
+
+	// Same ladder as AFireGameMode::FetchEndScreenDetails
+	EGameRank GetRank(int32 SavedPercent) const
+	{
+		for (int32 Rank = 0; Rank < UE_ARRAY_COUNT(RankThresholds); ++Rank)
+		{
+			if (SavedPercent >= RankThresholds[Rank])
+			{
+				return static_cast<EGameRank>(Rank);
+			}
+		}
+		return EGameRank::D;
+	}
+};
+
+enum class EFireSimEnd : uint8
+{
+	Extinguished,
+	OverBurn,
+	SpecialTiles,
+	Timeout
+};
+
+struct FFireSimResult
+{
+	EFireSimEnd End = EFireSimEnd::Timeout;
+	bool bWon = false;
+
+	// Seconds from the start of the run to the check that ended it
+	float EndTime = 0.0f;
+
+	float BurnPercent = 0.0f;
+	int32 SavedPercent = 0;
+	EGameRank Rank = EGameRank::E;
+
+	int32 SpecialTiles = 0;
+	int32 SpecialTilesLost = 0;
+
+	int32 EventsRun = 0;
+};
+
+/*
+	Plays the fire and the game mode's win / lose checks over a tile table with no world,
+	actors or timers, as fast as the events can be run. The spread, burn out and dig rules are
+	the fire subsystem's, player input comes from a plan of timed dig and ignite records.
+	Spreads pick from the subsystem's neighbour weights, copied with every table built.
+	The layout and weights are only read, so they can be shared by sims running on several threads.
+	Each sim keeps its working arrays between runs, run many games on one sim per thread.
+*/
+class BRIGHTSPARKSPROJECT_API FFireHeadlessSim
+{
+public:
+	FFireHeadlessSim(const FFireTileTable& InLayout, const FFireSpreadWeights& InSpreadWeights);
+
+	/*
+		Runs one game from the layout's current tile states. StartEvents carry on the events that
+		were queued when the layout was copied, Plan is applied in time order with times in
+		seconds from the start of the run, and every random choice comes from Seed.
+	*/
+	FFireSimResult Run(const FFireSimParams& Params, int32 Seed, TArrayView<const FFireHistoryEvent> StartEvents, TArrayView<const FFireEventRecord> Plan);
+
+private:
+	struct FSimEvent
+	{
+		double DueTime = 0.0;
+		int32 TileIndex = INDEX_NONE;
+		EFireEventType Type = EFireEventType::Spread;
+	};
+
+	bool Ignite(int32 Tile);
+	void Spread(int32 Tile);
+	void BurnOut(int32 Tile);
+	bool Dig(int32 Tile);
+	void Schedule(int32 Tile, EFireEventType Type, float Delay);
+
+	// Runs the game mode's checks, returns true and fills the result when the game ended
+	bool CheckGameEnded(FFireSimResult& OutResult) const;
+
+	const FFireTileTable& Layout;
+	const FFireSpreadWeights& SpreadWeights;
+	const FFireSimParams* Params = nullptr;
+
+	// Working copies of the layout's per tile state
+	TArray<EFireTileFlags> Flags;
+	TArray<ESurfaceBurnType> BurnTypes;
+
+	// When each tile's fuel runs out, what its spreads pick by
+	TArray<double> BurnOutTimes;
+	TArray<int32, TInlineAllocator<8>> Picked;
+
+	// Min heap on DueTime
+	TArray<FSimEvent> Queue;
+
+	FRandomStream Random;
+	double Now = 0.0;
+
+	// Kept up to date by the transitions so the checks do not walk the tiles
+	int32 NumBurning = 0;
+	int32 NumBurnable = 0;
+	int32 NumBurnableLost = 0;
+	int32 NumSpecial = 0;
+	int32 NumSpecialLost = 0;
+};
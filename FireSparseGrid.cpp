@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireSparseGrid.h"
+#include "HAL/IConsoleManager.h"
+
+void FFireSparseGrid::Reset()
+{
+    Blocks.Empty();
+    NumSetCells = 0;
+}
+
+const FFireSparseGrid::FBlock* FFireSparseGrid::FindBlock(const FIntPoint& BlockCoord) const
+{
+    const TUniquePtr<FBlock>* Block = Blocks.Find(BlockCoord);
+    return Block ? Block->Get() : nullptr;
+}
+
+FFireSparseGrid::FBlock& FFireSparseGrid::FindOrAddBlock(const FIntPoint& BlockCoord)
+{
+    if (TUniquePtr<FBlock>* Existing = Blocks.Find(BlockCoord))
+    {
+        return **Existing;
+    }
+
+    FBlock* Block = Blocks.Add(BlockCoord, MakeUnique<FBlock>()).Get();
+    for (int32& Cell : Block->Cells)
+    {
+        Cell = INDEX_NONE;
+    }
+
+    // Link both ways with the blocks already around it
+    for (int32 DY = -1; DY <= 1; ++DY)
+    {
+        for (int32 DX = -1; DX <= 1; ++DX)
+        {
+            const TUniquePtr<FBlock>* Other = (DX == 0 && DY == 0) ? nullptr : Blocks.Find(BlockCoord + FIntPoint(DX, DY));
+            FBlock* OtherBlock = Other ? Other->Get() : nullptr;
+
+            Block->Around[(DY + 1) * 3 + DX + 1] = (DX == 0 && DY == 0) ? Block : OtherBlock;
+            if (OtherBlock)
+            {
+                OtherBlock->Around[(1 - DY) * 3 + 1 - DX] = Block;
+            }
+        }
+    }
+    return *Block;
+}
+
+void FFireSparseGrid::Set(const FIntPoint& Coord, int32 Value)
+{
+    const FIntPoint BlockCoord = GetBlockCoord(Coord);
+    if (Value == INDEX_NONE && !FindBlock(BlockCoord)) return;
+
+    int32& Cell = FindOrAddBlock(BlockCoord).Cells[GetCellIndex(Coord.X, Coord.Y)];
+    NumSetCells += (Value != INDEX_NONE) - (Cell != INDEX_NONE);
+    Cell = Value;
+}
+
+int32 FFireSparseGrid::Find(const FIntPoint& Coord) const
+{
+    const FBlock* Block = FindBlock(GetBlockCoord(Coord));
+    return Block ? Block->Cells[GetCellIndex(Coord.X, Coord.Y)] : INDEX_NONE;
+}
+
+int32 FFireSparseGrid::FindNeighbours(const FIntPoint& Coord, int32 (&OutValues)[8]) const
+{
+    int32 NumFound = 0;
+
+    const FBlock* Block = FindBlock(GetBlockCoord(Coord));
+    if (!Block)
+    {
+        // An empty cell in an unallocated block can still border set cells in the next block over
+        for (int32 DY = -1; DY <= 1; ++DY)
+        {
+            for (int32 DX = -1; DX <= 1; ++DX)
+            {
+                const int32 Value = (DX == 0 && DY == 0) ? INDEX_NONE : Find(Coord + FIntPoint(DX, DY));
+                if (Value != INDEX_NONE) OutValues[NumFound++] = Value;
+            }
+        }
+        return NumFound;
+    }
+
+    const int32 LocalX = Coord.X & BlockMask;
+    const int32 LocalY = Coord.Y & BlockMask;
+    for (int32 DY = -1; DY <= 1; ++DY)
+    {
+        const int32 Y = LocalY + DY;
+        const int32 AroundRow = (Y < 0 ? 0 : (Y >= BlockSize ? 2 : 1)) * 3;
+        for (int32 DX = -1; DX <= 1; ++DX)
+        {
+            if (DX == 0 && DY == 0) continue;
+
+            const int32 X = LocalX + DX;
+            const FBlock* Other = Block->Around[AroundRow + (X < 0 ? 0 : (X >= BlockSize ? 2 : 1))];
+            const int32 Value = Other ? Other->Cells[GetCellIndex(X, Y)] : INDEX_NONE;
+            if (Value != INDEX_NONE) OutValues[NumFound++] = Value;
+        }
+    }
+    return NumFound;
+}
+
+SIZE_T FFireSparseGrid::GetAllocatedSize() const
+{
+    return Blocks.GetAllocatedSize() + Blocks.Num() * sizeof(FBlock);
+}
+
+static FAutoConsoleCommandWithArgs FireSparseBenchCommand(
+    TEXT("fire.SparseBench"),
+    TEXT("fire.SparseBench [Cells=10000000] [Fill=0.1] [Seed=0]\n")
+    TEXT("Fills a square sparse grid of about Cells potential cells with round meadows up to Fill of its area, ")
+    TEXT("then logs the memory per burnable tile and the neighbour lookup rate through the cached blocks and through the map."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            int64 NumCells = 10000000;
+            float Fill = 0.1f;
+            int32 Seed = 0;
+            for (const FString& Arg : Args)
+            {
+                FString Key, Value;
+                if (!Arg.Split(TEXT("="), &Key, &Value)) continue;
+
+                if (Key.Equals(TEXT("Cells"), ESearchCase::IgnoreCase)) NumCells = FMath::Max<int64>(FCString::Atoi64(*Value), 1);
+                else if (Key.Equals(TEXT("Fill"), ESearchCase::IgnoreCase)) Fill = FMath::Clamp(FCString::Atof(*Value), 0.0f, 1.0f);
+                else if (Key.Equals(TEXT("Seed"), ESearchCase::IgnoreCase)) Seed = FCString::Atoi(*Value);
+            }
+
+            const int32 Side = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<double>(NumCells))), 1);
+            const int64 TargetCells = static_cast<int64>(static_cast<double>(Side) * Side * Fill);
+
+            // Meadows of 10 to 150 cells across, overlaps only count once
+            FFireSparseGrid Grid;
+            TArray<FIntPoint> SetCoords;
+            FRandomStream Random(Seed);
+            const uint64 FillStart = FPlatformTime::Cycles64();
+            while (SetCoords.Num() < TargetCells)
+            {
+                const FIntPoint Centre(Random.RandHelper(Side), Random.RandHelper(Side));
+                const int32 Radius = Random.RandRange(5, 75);
+                for (int32 Y = FMath::Max(Centre.Y - Radius, 0); Y <= FMath::Min(Centre.Y + Radius, Side - 1) && SetCoords.Num() < TargetCells; ++Y)
+                {
+                    for (int32 X = FMath::Max(Centre.X - Radius, 0); X <= FMath::Min(Centre.X + Radius, Side - 1) && SetCoords.Num() < TargetCells; ++X)
+                    {
+                        const FIntPoint Coord(X, Y);
+                        if ((Coord - Centre).SizeSquared() > Radius * Radius || Grid.Find(Coord) != INDEX_NONE) continue;
+
+                        Grid.Set(Coord, SetCoords.Add(Coord));
+                    }
+                }
+            }
+            const double FillMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - FillStart);
+
+            const SIZE_T Bytes = Grid.GetAllocatedSize();
+            const double DenseBytes = static_cast<double>(Side) * Side * sizeof(int32);
+            UE_LOG(LogTemp, Display, TEXT("fire.SparseBench: %d x %d cells, %d burnable in %d blocks, filled in %.1f ms"),
+                Side, Side, Grid.GetNumSetCells(), Grid.GetNumBlocks(), FillMs);
+            UE_LOG(LogTemp, Display, TEXT("fire.SparseBench: %.1f MB, %.1f bytes per burnable tile, a dense grid would be %.1f MB"),
+                Bytes / (1024.0 * 1024.0), static_cast<double>(Bytes) / FMath::Max(Grid.GetNumSetCells(), 1), DenseBytes / (1024.0 * 1024.0));
+
+            // Every burnable tile's 8 neighbours, through the cached block pointers and then one map lookup per cell
+            int32 Values[8];
+            int64 Checksum = 0;
+            const uint64 CachedStart = FPlatformTime::Cycles64();
+            for (const FIntPoint& Coord : SetCoords)
+            {
+                Checksum += Grid.FindNeighbours(Coord, Values);
+            }
+            const double CachedSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - CachedStart);
+
+            int64 MapChecksum = 0;
+            const uint64 MapStart = FPlatformTime::Cycles64();
+            for (const FIntPoint& Coord : SetCoords)
+            {
+                for (int32 DY = -1; DY <= 1; ++DY)
+                {
+                    for (int32 DX = -1; DX <= 1; ++DX)
+                    {
+                        MapChecksum += (DX != 0 || DY != 0) && Grid.Find(Coord + FIntPoint(DX, DY)) != INDEX_NONE;
+                    }
+                }
+            }
+            const double MapSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - MapStart);
+
+            const double NumLookups = 8.0 * SetCoords.Num();
+            UE_LOG(LogTemp, Display, TEXT("fire.SparseBench: neighbour lookups %.1f M/s through cached blocks, %.1f M/s through the map (%lld, %lld neighbours found)"),
+                NumLookups / FMath::Max(CachedSeconds, 1e-9) / 1e6, NumLookups / FMath::Max(MapSeconds, 1e-9) / 1e6, Checksum, MapChecksum);
+        }));
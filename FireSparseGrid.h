@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+	Int32 per grid cell for grids that are mostly empty, such as the burnable meadows scattered
+	over a landscape. Cells are stored in 64 by 64 blocks found through a hash map from block
+	coordinate, and a block is only allocated when the first cell in it is set, so memory follows
+	the filled area rather than the grid's bounds. Every block keeps pointers to the 8 blocks
+	around it, so neighbour lookups that cross a block edge do not go back through the map.
+	Cells that were never set read as INDEX_NONE. Coordinates may be negative.
+*/
+class BRIGHTSPARKSPROJECT_API FFireSparseGrid
+{
+public:
+	static constexpr int32 BlockShift = 6;
+	static constexpr int32 BlockSize = 1 << BlockShift;
+	static constexpr int32 BlockMask = BlockSize - 1;
+
+	void Reset();
+
+	void Set(const FIntPoint& Coord, int32 Value);
+	int32 Find(const FIntPoint& Coord) const;
+
+	// Values of the set cells among the 8 around Coord, returns how many were written
+	int32 FindNeighbours(const FIntPoint& Coord, int32 (&OutValues)[8]) const;
+
+	int32 GetNumBlocks() const { return Blocks.Num(); }
+	int32 GetNumSetCells() const { return NumSetCells; }
+
+	// Bytes held by the blocks and the map
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FBlock
+	{
+		// 3 by 3 blocks around this one, row major with this block in the middle, null where none is allocated
+		FBlock* Around[9];
+		int32 Cells[BlockSize * BlockSize];
+	};
+
+	static FIntPoint GetBlockCoord(const FIntPoint& Coord) { return FIntPoint(Coord.X >> BlockShift, Coord.Y >> BlockShift); }
+	static int32 GetCellIndex(int32 X, int32 Y) { return ((Y & BlockMask) << BlockShift) | (X & BlockMask); }
+
+	const FBlock* FindBlock(const FIntPoint& BlockCoord) const;
+	FBlock& FindOrAddBlock(const FIntPoint& BlockCoord);
+
+	TMap<FIntPoint, TUniquePtr<FBlock>> Blocks;
+	int32 NumSetCells = 0;
+};
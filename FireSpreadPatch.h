@@ -1,110 +1,151 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include <Components/BoxComponent.h>
-#include "NiagaraSystem.h"
-#include "NiagaraComponent.h"
-#include "FireSpreadPatch.generated.h"
-
-class AAudioManager;
-
-UENUM(BlueprintType)
-enum class ESurfaceBurnType : uint8
-{
-	Quick     UMETA(DisplayName = "Quick"),
-	Slow      UMETA(DisplayName = "Slow"),
-	NonBurnable UMETA(DisplayName = "Non-Burnable"),
-	Burnt     UMETA(DisplayName = "Already Burnt"),
-	Dug       UMETA(DisplayName = "Dug")
-};
-
-UCLASS()
-class BRIGHTSPARKSPROJECT_API AFireSpreadPatch : public AActor
-{
-	GENERATED_BODY()
-	
-public:	
-
-	// Sets default values for this actor's properties
-	AFireSpreadPatch();
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-	UPROPERTY(VisibleAnywhere)
-	UBoxComponent* DetectionVolume;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FireSpread")
-	TArray<AFireSpreadPatch*> AdjacentPatches;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	bool bIsBurning;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	bool bIsBurnt;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	bool bIsDug;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	bool bPendingIgnition = false;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	bool bSpecialTile = false;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	bool bVisitedForLineCheck = false;
-
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	UNiagaraSystem* FireEffect;
-
-	void Ignite(bool bInstantSpread = false);
-
-	UFUNCTION(BlueprintCallable, Category = "Fire Ground")
-	void SpreadFire();
-
-	UFUNCTION(BlueprintCallable, Category = "Fire Ground")
-	void SetUpBurntPatches();
-
-	UFUNCTION(BlueprintCallable, Category = "Fire Ground")
-	float FetchSpreadDelay();
-
-	UFUNCTION(BlueprintCallable, Category = "Fire Ground")
-	void BurnOut();
-
-	UFUNCTION(BlueprintImplementableEvent, Category = "Visuals")
-	void OnPatchBurnt();
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	float MinSpreadDelay = 5.0f;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	float MaxSpreadDelay = 15.0f;
-
-	UPROPERTY(EditAnywhere, Category = "FireSpread")
-	float BurnDuration = 45.0f;
-
-
-	// Timer Handles
-	FTimerHandle SpreadTimerHandle;
-	FTimerHandle BurnOutTimerHandle;
-
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
-	ESurfaceBurnType BurnType = ESurfaceBurnType::Quick;
-
-	UPROPERTY()
-	AAudioManager* AudioManager;
-
-
-
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include <Components/BoxComponent.h>
+#include "NiagaraSystem.h"
+#include "NiagaraComponent.h"
+#include "FireSpreadPatch.generated.h"
+
+UENUM(BlueprintType)
+enum class ESurfaceBurnType : uint8
+{
+	Quick     UMETA(DisplayName = "Quick"),
+	Slow      UMETA(DisplayName = "Slow"),
+	NonBurnable UMETA(DisplayName = "Non-Burnable"),
+	Burnt     UMETA(DisplayName = "Already Burnt"),
+	Dug       UMETA(DisplayName = "Dug")
+};
+
+// Patch transitions run and recorded by the fire subsystem
+UENUM(BlueprintType)
+enum class EFireEventType : uint8
+{
+	Ignite     UMETA(DisplayName = "Ignite"),
+	Spread     UMETA(DisplayName = "Spread"),
+	BurnOut    UMETA(DisplayName = "Burn Out"),
+	Dig        UMETA(DisplayName = "Dig")
+};
+
+// What set a tile alight, kept in fire replays so playback can tell inputs from simulation results
+UENUM(BlueprintType)
+enum class EFireIgniteSource : uint8
+{
+	Script     UMETA(DisplayName = "Script"),
+	Torch      UMETA(DisplayName = "Drip Torch"),
+	Spread     UMETA(DisplayName = "Spread"),
+	Object     UMETA(DisplayName = "Object")
+};
+
+// What a bulk tool operation does to each tile, see UFireSpreadSubsystem::ApplyTool
+UENUM(BlueprintType)
+enum class EFireToolOp : uint8
+{
+	Dig        UMETA(DisplayName = "Dig"),
+	Ignite     UMETA(DisplayName = "Ignite")
+};
+
+// Answer to a walking path request, see UFireSpreadSubsystem::FindWalkingPath
+UENUM(BlueprintType)
+enum class EFirePathStatus : uint8
+{
+	Found      UMETA(DisplayName = "Found"),
+	Pending    UMETA(DisplayName = "Pending"),
+	NoPath     UMETA(DisplayName = "No Path"),
+	Invalid    UMETA(DisplayName = "Invalid")
+};
+
+UCLASS()
+class BRIGHTSPARKSPROJECT_API AFireSpreadPatch : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+
+	// Sets default values for this actor's properties
+	AFireSpreadPatch();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+public:	
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	UPROPERTY(VisibleAnywhere)
+	UBoxComponent* DetectionVolume;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	bool bIsBurning;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	bool bIsBurnt;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	bool bIsDug;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	bool bPendingIgnition = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	bool bSpecialTile = false;
+
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	UNiagaraSystem* FireEffect;
+
+	void Ignite(bool bInstantSpread = false);
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Ground")
+	void SpreadFire();
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Ground")
+	void SetUpBurntPatches();
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Ground")
+	float FetchSpreadDelay();
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Ground")
+	void BurnOut();
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Visuals")
+	void OnPatchBurnt();
+
+	// Turn off when the burnt look is driven from the fire subsystem's OnTilesVisualChanged batch
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visuals")
+	bool bCallOnPatchBurnt = true;
+
+	// Called by the fire subsystem's end of frame visual batch when this patch's tile ignites / burns out
+	void StartBurningEffects();
+	void StopBurningEffects(bool bBurntOut = true);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	float MinSpreadDelay = 5.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	float MaxSpreadDelay = 15.0f;
+
+	UPROPERTY(EditAnywhere, Category = "FireSpread")
+	float BurnDuration = 45.0f;
+
+	// Fuel mass on the patch, burnt off at BurnRate per second while it burns. 0 gives it BurnDuration seconds worth
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FireSpread")
+	float FuelLoad = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FireSpread")
+	float BurnRate = 1.0f;
+
+
+	// This patch's index in the fire subsystem's tile table, which holds the authoritative state.
+	// Neighbours are kept there as tile indices, see UFireSpreadSubsystem::GetTileNeighbours
+	int32 PatchIndex = INDEX_NONE;
+
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fire Ground")
+	ESurfaceBurnType BurnType = ESurfaceBurnType::Quick;
+
+
+};
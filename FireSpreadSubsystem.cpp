@@ -0,0 +1,2770 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireSpreadSubsystem.h"
+#include "FireSpreadPatch.h"
+#include "FirePatchField.h"
+#include "FireGroundCollision.h"
+#include "AudioManager.h"
+#include "BasicObject.h"
+#include "Algo/Unique.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/BoxComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/Engine.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Crc.h"
+#include "Math/VectorRegister.h"
+#include "Misc/Paths.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "UObject/UObjectGlobals.h"
+#include <Kismet/GameplayStatics.h>
+
+DECLARE_CYCLE_STAT(TEXT("Process Fire Events"), STAT_FireProcessEvents, STATGROUP_FireSpread);
+DECLARE_CYCLE_STAT(TEXT("Flush Field Visuals"), STAT_FireFlushTileVisuals, STATGROUP_FireSpread);
+DECLARE_CYCLE_STAT(TEXT("Pick Spread Neighbours"), STAT_FirePickNeighbours, STATGROUP_FireSpread);
+DECLARE_CYCLE_STAT(TEXT("Step Heat Field"), STAT_FireHeatStep, STATGROUP_FireSpread);
+DECLARE_CYCLE_STAT(TEXT("Consume Fuel"), STAT_FireConsumeFuel, STATGROUP_FireSpread);
+DECLARE_CYCLE_STAT(TEXT("Step Coarse Cells"), STAT_FireLodStep, STATGROUP_FireSpread);
+DECLARE_CYCLE_STAT(TEXT("Bulk Tool Operation"), STAT_FireBulkTool, STATGROUP_FireSpread);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Coarse Fire Cells"), STAT_FireCoarseCells, STATGROUP_FireSpread);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Events Processed"), STAT_FireEventsProcessed, STATGROUP_FireSpread);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Event Backlog"), STAT_FireEventBacklog, STATGROUP_FireSpread);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cached Walking Paths"), STAT_FireCachedPaths, STATGROUP_FireSpread);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Fire Event Lateness (s)"), STAT_FireEventLateness, STATGROUP_FireSpread);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("GC Mark (ms)"), STAT_FireGCMarkMs, STATGROUP_FireSpread);
+DECLARE_MEMORY_STAT(TEXT("Fire History"), STAT_FireHistoryMemory, STATGROUP_FireSpread);
+
+static TAutoConsoleVariable<float> CVarFireFrameBudgetUs(
+    TEXT("fire.FrameBudgetUs"),
+    2000.0f,
+    TEXT("Microseconds per frame the fire simulation may spend running due spread / burn out events and applying tile visuals.\n")
+    TEXT("Work that does not fit is carried to the next frame. 0 runs everything each frame."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireMaxEventDelay(
+    TEXT("fire.MaxEventDelay"),
+    1.0f,
+    TEXT("Most seconds an event far from the camera waits behind closer ones. Events at the camera run first,\n")
+    TEXT("and the wait grows with distance up to this at fire.EventPriorityDistance."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireEventPriorityDistance(
+    TEXT("fire.EventPriorityDistance"),
+    20000.0f,
+    TEXT("Distance from the camera at which a due event waits the whole of fire.MaxEventDelay behind closer ones."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFireHitchHistorySize(
+    TEXT("fire.HitchHistorySize"),
+    128,
+    TEXT("Number of recent fire events kept for hitch watchdog records. Read when the world starts."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireHistorySeconds(
+    TEXT("fire.History.Seconds"),
+    300.0f,
+    TEXT("Seconds of fire history kept for scrubbing, 0 turns history off. Read when the world starts."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireHistoryInterval(
+    TEXT("fire.History.Interval"),
+    0.5f,
+    TEXT("Seconds between fire history frames. Read when the world starts."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireSlopeInfluence(
+    TEXT("fire.Spread.SlopeInfluence"),
+    2.0f,
+    TEXT("How strongly fire favours spreading uphill, neighbour weights scale by exp(SlopeInfluence * rise / run).\n")
+    TEXT("0 ignores the terrain."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireFullIntensityFuel(
+    TEXT("fire.Fuel.FullIntensity"),
+    15.0f,
+    TEXT("Fuel a burning tile needs left to spread into 3 neighbours, with less it spreads into fewer, down to 1."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireLodDistance(
+    TEXT("fire.Lod.Distance"),
+    20000.0f,
+    TEXT("Distance from every player past which burning patch field cells of 4 by 4 tiles burn as a whole.\n")
+    TEXT("Cells go back to per tile fire within three quarters of it. 0 keeps every tile on its own."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireLodStepSeconds(
+    TEXT("fire.Lod.StepSeconds"),
+    1.0f,
+    TEXT("Seconds between coarse cell steps, which is also how often cells go coarse or refine."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireLodBurnTolerance(
+    TEXT("fire.Lod.BurnTolerance"),
+    0.02f,
+    TEXT("Burn share either side of the game over threshold within which every coarse cell is refined,\n")
+    TEXT("so the per tile fire decides a close game."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFireSpreadEngine(
+    TEXT("fire.SpreadEngine"),
+    0,
+    TEXT("0: burning tiles spread to random neighbours after a random delay.\n")
+    TEXT("1: heat diffuses between tiles on a fixed step and tiles light at their ignition temperature.\n")
+    TEXT("Read when the world starts."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFireHeatStepSeconds(
+    TEXT("fire.Heat.StepSeconds"),
+    0.1f,
+    TEXT("Fixed timestep of the heat field, at most 8 steps are run a frame."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs FireWindCommand(
+    TEXT("fire.Wind"),
+    TEXT("fire.Wind <X> <Y>: sets the level wind the fire spreads with, 0 0 for none"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            if (UFireSpreadSubsystem* FireSubsystem = World ? World->GetSubsystem<UFireSpreadSubsystem>() : nullptr)
+            {
+                const float X = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.0f;
+                const float Y = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 0.0f;
+                FireSubsystem->SetWind(FVector2D(X, Y));
+            }
+        }));
+
+static FAutoConsoleCommandWithWorldAndArgs FireAllocCheckCommand(
+    TEXT("fire.AllocCheck"),
+    TEXT("fire.AllocCheck [Frames=600] [WarmUp=120]: after WarmUp ticks, counts the heap allocations the game thread ")
+    TEXT("makes inside the next Frames fire subsystem ticks and logs pass or fail. Light a large burn first, a steady ")
+    TEXT("burn should make none. The automation test BrightSparks.Fire.SteadyStateAllocations runs the same check."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            if (UFireSpreadSubsystem* FireSubsystem = World ? World->GetSubsystem<UFireSpreadSubsystem>() : nullptr)
+            {
+                const int32 Frames = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 600;
+                const int32 WarmUp = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 120;
+                FireSubsystem->StartAllocCheck(WarmUp, Frames);
+            }
+        }));
+
+static FAutoConsoleCommandWithWorldAndArgs FireHistoryRewindCommand(
+    TEXT("fire.History.Rewind"),
+    TEXT("fire.History.Rewind <Seconds>: pauses the fire and scrubs its history, negative seconds scrub forwards"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            if (UFireSpreadSubsystem* FireSubsystem = World ? World->GetSubsystem<UFireSpreadSubsystem>() : nullptr)
+            {
+                FireSubsystem->RewindHistory(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.0f);
+            }
+        }));
+
+static FAutoConsoleCommandWithWorldAndArgs FireHistoryResumeCommand(
+    TEXT("fire.History.Resume"),
+    TEXT("Carries the fire on from the scrubbed history frame"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            if (UFireSpreadSubsystem* FireSubsystem = World ? World->GetSubsystem<UFireSpreadSubsystem>() : nullptr)
+            {
+                FireSubsystem->ResumeFromHistory();
+            }
+        }));
+
+static FAutoConsoleCommandWithWorldAndArgs FireReplayRecordCommand(
+    TEXT("fire.Replay.Record"),
+    TEXT("fire.Replay.Record <Name>: records every fire transition to Saved/FireReplays/<Name>.frep"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            if (UFireSpreadSubsystem* FireSubsystem = World ? World->GetSubsystem<UFireSpreadSubsystem>() : nullptr)
+            {
+                FireSubsystem->StartRecording(Args.Num() > 0 ? Args[0] : TEXT("FireReplay"));
+            }
+        }));
+
+static FAutoConsoleCommandWithWorldAndArgs FireReplayStopCommand(
+    TEXT("fire.Replay.Stop"),
+    TEXT("Stops the fire replay recording"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            if (UFireSpreadSubsystem* FireSubsystem = World ? World->GetSubsystem<UFireSpreadSubsystem>() : nullptr)
+            {
+                FireSubsystem->StopRecording();
+            }
+        }));
+
+static FAutoConsoleCommandWithWorldAndArgs FireReplayPlayCommand(
+    TEXT("fire.Replay.Play"),
+    TEXT("fire.Replay.Play <Name> [Speed]: plays a fire replay back and checks it, speed 0 runs it headless as fast as possible"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            if (UFireSpreadSubsystem* FireSubsystem = World ? World->GetSubsystem<UFireSpreadSubsystem>() : nullptr)
+            {
+                const float Speed = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 1.0f;
+                FireSubsystem->PlayReplay(Args.Num() > 0 ? Args[0] : TEXT("FireReplay"), Speed);
+            }
+        }));
+
+namespace
+{
+    /*
+        Stands in for GMalloc between Begin and End and passes every call on to the allocator it
+        replaced, counting the allocations and reallocations the game thread makes. Other threads go
+        through uncounted, so render and worker allocations do not show up as the fire's. There is one
+        counter that is never destroyed, so a call that picked it up just before End still lands safely.
+    */
+    class FFireAllocationCounter final : public FMalloc
+    {
+    public:
+        static FFireAllocationCounter& Get()
+        {
+            static FFireAllocationCounter Counter;
+            return Counter;
+        }
+
+        void Begin()
+        {
+            check(IsInGameThread() && GMalloc != this);
+            NumAllocations = 0;
+            Inner = GMalloc;
+            GMalloc = this;
+        }
+
+        // Puts the replaced allocator back, returns the allocations counted since Begin
+        int32 End()
+        {
+            GMalloc = Inner;
+            return NumAllocations;
+        }
+
+        virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+        {
+            Note();
+            return Inner->Malloc(Count, Alignment);
+        }
+
+        virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+        {
+            // A realloc to 0 is a free
+            if (Count > 0) Note();
+            return Inner->Realloc(Original, Count, Alignment);
+        }
+
+        virtual void Free(void* Original) override { Inner->Free(Original); }
+        virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+        virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+        virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+        virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+        virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+        virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+        virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+        virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+    private:
+        void Note()
+        {
+            if (IsInGameThread())
+            {
+                ++NumAllocations;
+            }
+        }
+
+        FMalloc* Inner = nullptr;
+        int32 NumAllocations = 0;
+    };
+
+    FString GetReplayPath(const FString& Name)
+    {
+        return FPaths::ProjectSavedDir() / TEXT("FireReplays") / (Name + TEXT(".frep"));
+    }
+
+    // "FSNP", bump the version whenever the snapshot layout changes
+    constexpr uint32 FireSnapshotMagic = 0x504E5346;
+    constexpr uint16 FireSnapshotVersion = 1;
+
+    struct FEventDueBefore
+    {
+        bool operator()(const FFireEvent& A, const FFireEvent& B) const
+        {
+            return A.DueTime < B.DueTime;
+        }
+    };
+
+    struct FEventRunsBefore
+    {
+        bool operator()(const FFireEvent& A, const FFireEvent& B) const
+        {
+            return A.Priority < B.Priority;
+        }
+    };
+
+    // Cell of the patch hash, a default patch is 160 across
+    constexpr float PatchCellSize = 160.0f;
+
+    // Radius of the sphere the patch overlap search used to find neighbours with
+    constexpr float PatchNeighbourRadius = 80.0f;
+
+    // How far below an object the ground counts as under it, the length of the trace objects used
+    constexpr float ObjectGroundDepth = 100.0f;
+
+    FIntPoint GetPatchCell(const FVector& Location)
+    {
+        return FIntPoint(FMath::FloorToInt(Location.X / PatchCellSize), FMath::FloorToInt(Location.Y / PatchCellSize));
+    }
+
+    // Distance from the location to the patch's box, zero inside it
+    float GetDistanceToPatchBox(const AFireSpreadPatch& Patch, const FVector& Location)
+    {
+        const FVector Extent = Patch.DetectionVolume->GetScaledBoxExtent();
+        const FVector Local = Patch.DetectionVolume->GetComponentTransform().InverseTransformPositionNoScale(Location);
+        return static_cast<float>((Local - Local.BoundToBox(-Extent, Extent)).Size());
+    }
+
+    // Field tiles are TileSize cubes centred on their instance, as a patch's box is. A dense field is
+    // one box, a sparse one a box per run of tiles along a row
+    void AddFieldBoxes(const AFirePatchField& Field, TArray<FKBoxElem>& Boxes)
+    {
+        const FTransform& Transform = Field.GetActorTransform();
+        const FVector Scale = Transform.GetScale3D();
+        auto AddBox = [&](const FIntPoint& First, const FIntPoint& Last)
+            {
+                const FVector Size = FVector(Last.X - First.X + 1, Last.Y - First.Y + 1, 1.0) * Field.TileSize * Scale.GetAbs();
+                FKBoxElem& Box = Boxes.Emplace_GetRef(Size.X, Size.Y, Size.Z);
+                Box.Center = Transform.TransformPosition(FVector(First.X + Last.X, First.Y + Last.Y, 0.0) * 0.5 * Field.TileSize);
+                Box.Rotation = Transform.Rotator();
+            };
+
+        if (!Field.IsSparse())
+        {
+            if (Field.Columns > 0 && Field.Rows > 0) AddBox(FIntPoint(0, 0), FIntPoint(Field.Columns - 1, Field.Rows - 1));
+            return;
+        }
+
+        TArray<FIntPoint> Cells = Field.BurnableCells;
+        Cells.Sort([](const FIntPoint& A, const FIntPoint& B)
+            {
+                return A.Y != B.Y ? A.Y < B.Y : A.X < B.X;
+            });
+
+        int32 RunStart = 0;
+        for (int32 i = 1; i <= Cells.Num(); ++i)
+        {
+            if (i < Cells.Num() && Cells[i].Y == Cells[i - 1].Y && Cells[i].X == Cells[i - 1].X + 1) continue;
+
+            AddBox(Cells[RunStart], Cells[i - 1]);
+            RunStart = i;
+        }
+    }
+}
+
+bool UFireSpreadSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UFireSpreadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    HitchWatchdog.Init(CVarFireHitchHistorySize.GetValueOnGameThread());
+    FireRandom.GenerateNewSeed();
+    bUseHeatEngine = CVarFireSpreadEngine.GetValueOnGameThread() == 1;
+
+    const float HistorySeconds = CVarFireHistorySeconds.GetValueOnGameThread();
+    const float HistoryInterval = FMath::Max(CVarFireHistoryInterval.GetValueOnGameThread(), 0.01f);
+    if (HistorySeconds > 0.0f)
+    {
+        History.Init(FMath::CeilToInt(HistorySeconds / HistoryInterval));
+    }
+
+    PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UFireSpreadSubsystem::OnPreGarbageCollect);
+    PostReachabilityHandle = FCoreUObjectDelegates::PostReachabilityAnalysis.AddUObject(this, &UFireSpreadSubsystem::OnPostReachabilityAnalysis);
+    PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UFireSpreadSubsystem::OnPostGarbageCollect);
+}
+
+void UFireSpreadSubsystem::Deinitialize()
+{
+    FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+    FCoreUObjectDelegates::PostReachabilityAnalysis.Remove(PostReachabilityHandle);
+    FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+    ResetTiles();
+
+    Super::Deinitialize();
+}
+
+void UFireSpreadSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    // Placed patches register before any actor's BeginPlay, so objects tracing the ground in theirs
+    // already hit the shared collision. Patches spawned later register from their own BeginPlay
+    for (TActorIterator<AFireSpreadPatch> It(&InWorld); It; ++It)
+    {
+        RegisterPatch(*It);
+    }
+    FlushGroundCollision();
+}
+
+void UFireSpreadSubsystem::ResetTiles()
+{
+    StopRecording();
+    ReplayReader.Close();
+    bReplaying = false;
+    History.Reset();
+    HistoryFrameIndex = INDEX_NONE;
+
+    // Actors outliving the table, such as a sublevel shown again before it unloaded, register from scratch
+    for (AFireSpreadPatch* Patch : Patches)
+    {
+        if (Patch) Patch->PatchIndex = INDEX_NONE;
+    }
+    for (AFirePatchField* Field : Fields)
+    {
+        if (Field) Field->FirstTileIndex = INDEX_NONE;
+    }
+    for (ABasicObject* Object : Objects)
+    {
+        if (Object) Object->FireObjectIndex = INDEX_NONE;
+    }
+
+    EventQueue.Empty();
+    DueEvents.Empty();
+    DirtyTiles.Empty();
+    DirtyVisuals.Empty();
+    CarriedTiles.Empty();
+    NumCarriedTiles = 0;
+    Tiles = FFireTileTable();
+    Patches.Empty();
+    BurningTiles.Empty();
+    BurningSlots.Empty();
+    BurningFuel.Empty();
+    BurningRates.Empty();
+    ChunkVersions.Empty();
+    SpreadWeights.Reset();
+    PendingWeightBuild.Reset();
+    bWeightBuildWanted = false;
+    HeatField.Reset();
+    Lod.Reset();
+    AuthoredStates.Empty();
+    Objects.Empty();
+    AuthoredObjectsOnFire.Empty();
+    ObjectTiles.Empty();
+    TileObjects.Empty();
+    PendingObjectIgnitions.Empty();
+    Fields.Empty();
+    PatchCells.Empty();
+    MaxPatchReach = 0.0f;
+    Pathfinder.Reset();
+    StateSnapshots.Reset();
+    AudioManager = nullptr;
+    LayoutVersion++;
+
+    UWorld* World = GetWorld();
+    if (GroundCollisionActor && World && !World->bIsTearingDown)
+    {
+        GroundCollisionActor->Destroy();
+    }
+    GroundCollisionActor = nullptr;
+    GroundCollision = nullptr;
+}
+
+TStatId UFireSpreadSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UFireSpreadSubsystem, STATGROUP_Tickables);
+}
+
+// Tile Registration
+int32 UFireSpreadSubsystem::RegisterPatch(AFireSpreadPatch* Patch)
+{
+    if (!Patch) return INDEX_NONE;
+
+    const bool bNewTile = Patch->PatchIndex == INDEX_NONE;
+    bool bLayoutChanged = false;
+    if (bNewTile)
+    {
+        Patch->PatchIndex = Tiles.AddTile();
+        Patches.Add(Patch);
+        BurningSlots.Add(INDEX_NONE);
+        AuthoredStates.Add(0);
+        bLayoutChanged = true;
+    }
+
+    // Authored settings and any state set on the actor directly. The patch's own calls register
+    // it again, so the layout only counts as changed when something in it did. A new tile's
+    // neighbour links are part of the same change and do not move the version again
+    const int32 Tile = Patch->PatchIndex;
+    const FVector3f Location(Patch->GetActorLocation());
+    const float OldFuelLoad = Tiles.FuelLoads[Tile];
+    const float OldBurnRate = Tiles.BurnRates[Tile];
+    Tiles.SetFuel(Tile, Patch->FuelLoad, Patch->BurnRate, Patch->BurnDuration);
+    bLayoutChanged |= Tiles.Locations[Tile] != Location
+        || Tiles.FuelLoads[Tile] != OldFuelLoad
+        || Tiles.BurnRates[Tile] != OldBurnRate
+        || Tiles.MinSpreadDelays[Tile] != Patch->MinSpreadDelay
+        || Tiles.MaxSpreadDelays[Tile] != Patch->MaxSpreadDelay;
+    if (bLayoutChanged)
+    {
+        LayoutVersion++;
+    }
+
+    Tiles.BurnTypes[Tile] = Patch->BurnType;
+    Tiles.Locations[Tile] = Location;
+    Tiles.MinSpreadDelays[Tile] = Patch->MinSpreadDelay;
+    Tiles.MaxSpreadDelays[Tile] = Patch->MaxSpreadDelay;
+    SetTileBurning(Tile, Patch->bIsBurning);
+    Tiles.SetFlag(Tile, EFireTileFlags::Burnt, Patch->bIsBurnt);
+    Tiles.SetFlag(Tile, EFireTileFlags::Dug, Patch->bIsDug);
+    Tiles.SetFlag(Tile, EFireTileFlags::Special, Patch->bSpecialTile);
+    Tiles.SetFlag(Tile, EFireTileFlags::PendingIgnition, Patch->bPendingIgnition);
+
+    // Only the first registration is the level as authored, later ones carry the state of play
+    if (bNewTile)
+    {
+        AuthoredStates[Tile] = GetPackedTileState(Tile);
+        LinkPatchNeighbours(Tile);
+    }
+    return Tile;
+}
+
+void UFireSpreadSubsystem::LinkPatchNeighbours(int32 TileIndex)
+{
+    AFireSpreadPatch* Patch = GetPatch(TileIndex);
+    if (!Patch || !Patch->DetectionVolume) return;
+
+    const FVector Location = Patch->GetActorLocation();
+    const FIntPoint Cell = GetPatchCell(Location);
+    MaxPatchReach = FMath::Max(MaxPatchReach, static_cast<float>(Patch->DetectionVolume->GetScaledBoxExtent().Size()));
+
+    // A patch whose centre is further than the sphere radius plus the largest patch reach cannot
+    // touch either sphere. Touching counts, patches laid edge to edge are neighbours
+    const float LinkDistance = PatchNeighbourRadius + 1.0f;
+    const int32 Range = FMath::CeilToInt((PatchNeighbourRadius + MaxPatchReach) / PatchCellSize);
+    for (int32 DY = -Range; DY <= Range; ++DY)
+    {
+        for (int32 DX = -Range; DX <= Range; ++DX)
+        {
+            for (TMultiMap<FIntPoint, int32>::TConstKeyIterator It = PatchCells.CreateConstKeyIterator(Cell + FIntPoint(DX, DY)); It; ++It)
+            {
+                const int32 Other = It.Value();
+                const AFireSpreadPatch* OtherPatch = Patches[Other];
+                if (Other == TileIndex || !OtherPatch || !OtherPatch->DetectionVolume) continue;
+
+                if (GetDistanceToPatchBox(*OtherPatch, Location) <= LinkDistance)
+                {
+                    Tiles.Neighbours[TileIndex].AddUnique(Other);
+                }
+                if (GetDistanceToPatchBox(*Patch, OtherPatch->GetActorLocation()) <= LinkDistance)
+                {
+                    Tiles.Neighbours[Other].AddUnique(TileIndex);
+                }
+            }
+        }
+    }
+
+    PatchCells.Add(Cell, TileIndex);
+}
+
+void UFireSpreadSubsystem::SetTileNeighbours(int32 TileIndex, TArrayView<AFireSpreadPatch* const> NeighbourPatches)
+{
+    if (!Tiles.IsValidIndex(TileIndex)) return;
+
+    // Registering a neighbour can grow the table, so resolve every index before touching the list
+    TArray<int32, TInlineAllocator<8>> NeighbourTiles;
+    for (AFireSpreadPatch* Neighbour : NeighbourPatches)
+    {
+        const int32 NeighbourTile = RegisterPatch(Neighbour);
+        if (NeighbourTile != INDEX_NONE && NeighbourTile != TileIndex)
+        {
+            NeighbourTiles.AddUnique(NeighbourTile);
+        }
+    }
+
+    if (Tiles.Neighbours[TileIndex] != NeighbourTiles)
+    {
+        Tiles.Neighbours[TileIndex] = NeighbourTiles;
+        LayoutVersion++;
+    }
+}
+
+int32 UFireSpreadSubsystem::RegisterField(AFirePatchField* Field)
+{
+    if (!Field) return INDEX_NONE;
+    if (Field->FirstTileIndex != INDEX_NONE) return Field->FirstTileIndex;
+
+    const int32 NumTiles = Field->GetNumTiles();
+    const int32 FirstTile = Tiles.Num();
+
+    Tiles.Reserve(FirstTile + NumTiles);
+    Patches.AddZeroed(NumTiles);
+    BurningSlots.Reserve(FirstTile + NumTiles);
+    AuthoredStates.Reserve(FirstTile + NumTiles);
+
+    for (int32 Instance = 0; Instance < NumTiles; ++Instance)
+    {
+        const int32 Tile = Tiles.AddTile();
+        BurningSlots.Add(INDEX_NONE);
+        Tiles.BurnTypes[Tile] = Field->GetAuthoredBurnType(Instance);
+        Tiles.Locations[Tile] = FVector3f(Field->GetTileLocation(Instance));
+        Tiles.SetFuel(Tile, Field->FuelLoad, Field->BurnRate, Field->BurnDuration);
+        Tiles.MinSpreadDelays[Tile] = Field->MinSpreadDelay;
+        Tiles.MaxSpreadDelays[Tile] = Field->MaxSpreadDelay;
+
+        // Matches AFireSpreadPatch::SetUpBurntPatches
+        Tiles.SetFlag(Tile, EFireTileFlags::Burnt, Tiles.BurnTypes[Tile] == ESurfaceBurnType::Burnt);
+        AuthoredStates.Add(GetPackedTileState(Tile));
+
+        // The 8 surrounding grid cells, as the patch overlap search would find
+        int32 NeighbourInstances[8];
+        const int32 NumNeighbours = Field->FindNeighbourInstances(Instance, NeighbourInstances);
+        for (int32 i = 0; i < NumNeighbours; ++i)
+        {
+            Tiles.Neighbours[Tile].Add(FirstTile + NeighbourInstances[i]);
+        }
+    }
+
+    for (int32 SpecialInstance : Field->SpecialTiles)
+    {
+        if (SpecialInstance >= 0 && SpecialInstance < NumTiles)
+        {
+            Tiles.SetFlag(FirstTile + SpecialInstance, EFireTileFlags::Special, true);
+        }
+    }
+
+    Field->FirstTileIndex = FirstTile;
+    Fields.Add(Field);
+    LayoutVersion++;
+
+    UE_LOG(LogTemp, Display, TEXT("Registered patch field %s as tiles %d to %d"), *Field->GetName(), FirstTile, FirstTile + NumTiles - 1);
+    return FirstTile;
+}
+
+void UFireSpreadSubsystem::RegisterObject(ABasicObject* Object)
+{
+    if (!Object || Object->FireObjectIndex != INDEX_NONE) return;
+
+    Object->FireObjectIndex = Objects.Add(Object);
+    AuthoredObjectsOnFire.Add(Object->bIsOnFire);
+    ObjectTiles.AddDefaulted();
+    BindObject(Object);
+}
+
+// Object Binding
+void UFireSpreadSubsystem::BindObject(ABasicObject* Object)
+{
+    if (!Object || !ObjectTiles.IsValidIndex(Object->FireObjectIndex)) return;
+    const int32 Slot = Object->FireObjectIndex;
+
+    // The object's colliding shapes other than its spread sphere, reaching down as far as its ground trace did
+    const FVector Location = Object->GetActorLocation();
+    FBox Footprint(Location, Location);
+    Object->ForEachComponent<UPrimitiveComponent>(false, [&Footprint, Object](const UPrimitiveComponent* Component)
+        {
+            if (Component != Object->FireSpreadSphere && Component->IsRegistered() && Component->IsCollisionEnabled())
+            {
+                Footprint += Component->Bounds.GetBox();
+            }
+        });
+    Footprint.Min.Z -= ObjectGroundDepth;
+
+    TArray<int32, TInlineAllocator<4>> Bound;
+    FindTilesUnder(Footprint, Bound);
+
+    TArray<int32, TInlineAllocator<4>>& OldBound = ObjectTiles[Slot];
+    for (int32 Tile : OldBound)
+    {
+        if (Bound.Contains(Tile)) continue;
+
+        TArray<int32, TInlineAllocator<2>>* Over = TileObjects.Find(Tile);
+        if (Over && Over->RemoveSwap(Slot) > 0 && Over->Num() == 0)
+        {
+            TileObjects.Remove(Tile);
+        }
+    }
+
+    for (int32 Tile : Bound)
+    {
+        if (OldBound.Contains(Tile)) continue;
+
+        TileObjects.FindOrAdd(Tile).Add(Slot);
+        if (Object->bIsOnFire)
+        {
+            IgniteTile(Tile, EFireIgniteSource::Object);
+        }
+    }
+    OldBound = MoveTemp(Bound);
+}
+
+void UFireSpreadSubsystem::IgniteObjectGround(ABasicObject* Object)
+{
+    for (int32 Tile : GetObjectTiles(Object))
+    {
+        IgniteTile(Tile, EFireIgniteSource::Object);
+    }
+}
+
+TArrayView<const int32> UFireSpreadSubsystem::GetObjectTiles(const ABasicObject* Object) const
+{
+    return Object && ObjectTiles.IsValidIndex(Object->FireObjectIndex) ? TArrayView<const int32>(ObjectTiles[Object->FireObjectIndex]) : TArrayView<const int32>();
+}
+
+template <typename AllocatorType>
+void UFireSpreadSubsystem::FindTilesUnder(const FBox& Footprint, TArray<int32, AllocatorType>& OutTiles) const
+{
+    // Field tiles as the TileSize cubes the ground collision gives them
+    for (const AFirePatchField* Field : Fields)
+    {
+        if (!Field || Field->TileSize <= 0.0f) continue;
+
+        const FBox Local = Footprint.InverseTransformBy(Field->GetActorTransform());
+        const float HalfTile = 0.5f * Field->TileSize;
+        if (Local.Min.Z > HalfTile || Local.Max.Z < -HalfTile) continue;
+
+        FIntPoint Min(FMath::RoundToInt(Local.Min.X / Field->TileSize), FMath::RoundToInt(Local.Min.Y / Field->TileSize));
+        FIntPoint Max(FMath::RoundToInt(Local.Max.X / Field->TileSize), FMath::RoundToInt(Local.Max.Y / Field->TileSize));
+        if (!Field->IsSparse())
+        {
+            Min = Min.ComponentMax(FIntPoint(0, 0));
+            Max = Max.ComponentMin(FIntPoint(Field->Columns - 1, Field->Rows - 1));
+        }
+        else if (static_cast<int64>(Max.X - Min.X + 1) * (Max.Y - Min.Y + 1) > Field->GetNumTiles())
+        {
+            // Fewer tiles in the field than cells in the box, so go through the tiles
+            for (int32 Instance = 0; Instance < Field->GetNumTiles(); ++Instance)
+            {
+                const FIntPoint Coord = Field->GetTileCoord(Instance);
+                if (Coord.X >= Min.X && Coord.X <= Max.X && Coord.Y >= Min.Y && Coord.Y <= Max.Y)
+                {
+                    OutTiles.Add(Field->GetTileIndex(Instance));
+                }
+            }
+            continue;
+        }
+
+        for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+        {
+            for (int32 X = Min.X; X <= Max.X; ++X)
+            {
+                const int32 Tile = Field->GetTileIndex(Field->FindInstance(FIntPoint(X, Y)));
+                if (Tile != INDEX_NONE) OutTiles.Add(Tile);
+            }
+        }
+    }
+
+    // Each patch is in one cell of the hash, so none is found twice
+    const FIntPoint MinCell = GetPatchCell(Footprint.Min - FVector(MaxPatchReach));
+    const FIntPoint MaxCell = GetPatchCell(Footprint.Max + FVector(MaxPatchReach));
+    for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+    {
+        for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+        {
+            for (TMultiMap<FIntPoint, int32>::TConstKeyIterator It = PatchCells.CreateConstKeyIterator(FIntPoint(X, Y)); It; ++It)
+            {
+                const AFireSpreadPatch* Patch = Patches[It.Value()];
+                if (Patch && Patch->DetectionVolume && Patch->DetectionVolume->Bounds.GetBox().Intersect(Footprint))
+                {
+                    OutTiles.Add(It.Value());
+                }
+            }
+        }
+    }
+}
+
+void UFireSpreadSubsystem::UpdateObjectBindings()
+{
+    if (ObjectBindingLayoutVersion == LayoutVersion) return;
+    ObjectBindingLayoutVersion = LayoutVersion;
+
+    for (ABasicObject* Object : Objects)
+    {
+        BindObject(Object);
+    }
+}
+
+void UFireSpreadSubsystem::UpdatePathfinding()
+{
+    if (PathLayoutVersion != LayoutVersion)
+    {
+        PathLayoutVersion = LayoutVersion;
+        Pathfinder.Reset();
+
+        // Sparse fields and loose patches have no grid to walk
+        for (AFirePatchField* Field : Fields)
+        {
+            if (!Field || Field->IsSparse() || Field->FirstTileIndex == INDEX_NONE) continue;
+
+            Pathfinder.AddGrid(Field->FirstTileIndex, Field->Columns, Field->Rows, FFirePathGrid::UnburntCost);
+            for (int32 Tile = Field->FirstTileIndex; Tile < Field->FirstTileIndex + Field->Columns * Field->Rows; ++Tile)
+            {
+                Pathfinder.SetTileCost(Tile, FFirePathGrid::GetTileCost(Tiles, Tile));
+            }
+        }
+    }
+
+    Pathfinder.Update();
+    SET_DWORD_STAT(STAT_FireCachedPaths, Pathfinder.GetNumCachedPaths());
+}
+
+EFirePathStatus UFireSpreadSubsystem::FindWalkingPath(int32 StartTile, int32 GoalTile, TArray<int32>& OutTiles)
+{
+    // Grids registered since the last tick are built now rather than answering Invalid
+    if (PathLayoutVersion != LayoutVersion)
+    {
+        UpdatePathfinding();
+    }
+    return Pathfinder.FindPath(StartTile, GoalTile, OutTiles);
+}
+
+void UFireSpreadSubsystem::QueueObjectIgnitions(int32 TileIndex)
+{
+    if (const TArray<int32, TInlineAllocator<2>>* Over = TileObjects.Find(TileIndex))
+    {
+        PendingObjectIgnitions.Append(*Over);
+    }
+}
+
+void UFireSpreadSubsystem::IgniteQueuedObjects()
+{
+    // Timers are bound to the object, so ResetFire drops the ones still pending
+    for (int32 Slot : PendingObjectIgnitions)
+    {
+        ABasicObject* Object = Objects[Slot];
+        if (!Object || !Object->bIsFlammable || Object->bIsOnFire) continue;
+
+        const float Delay = FetchObjectSpreadDelay(*Object);
+        if (Delay <= 0.0f)
+        {
+            Object->StartFire();
+            continue;
+        }
+
+        FTimerHandle TimerHandle;
+        FTimerDelegate TimerDel;
+        TimerDel.BindUFunction(Object, FName("SetNextObjectOnFire"), Object);
+        GetWorld()->GetTimerManager().SetTimer(TimerHandle, TimerDel, Delay, false);
+    }
+    PendingObjectIgnitions.Reset();
+}
+
+bool UFireSpreadSubsystem::ResetToAuthoredState()
+{
+    if (!HasSimulationAuthority()) return false;
+
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    // A recording or replay cannot carry on across the reset
+    StopRecording();
+    ReplayReader.Close();
+    bReplaying = false;
+    History.Reset();
+    HistoryFrameIndex = INDEX_NONE;
+    HistoryAccumulator = 0.0f;
+
+    // Every outstanding spread and burn out
+    EventQueue.Reset();
+    DueEvents.Reset();
+    PendingObjectIgnitions.Reset();
+    BacklogDepth = 0;
+
+    // One pass over the packed states, only the tiles that moved away from them are touched
+    for (int32 Tile = 0; Tile < Tiles.Num(); ++Tile)
+    {
+        Tiles.SetFlag(Tile, EFireTileFlags::PendingIgnition, false);
+        ApplyPackedTileState(Tile, AuthoredStates[Tile]);
+    }
+    const int32 NumTilesReset = DirtyTiles.Num();
+
+    for (int32 Object = 0; Object < Objects.Num(); ++Object)
+    {
+        if (Objects[Object])
+        {
+            Objects[Object]->ResetFire(AuthoredObjectsOnFire[Object]);
+        }
+    }
+
+    FireRandom.GenerateNewSeed();
+    ResetEventCounters();
+    HeatField.Reset();
+    Lod.ClearCells(Tiles);
+
+    // Stops the burning effects and fire audio now rather than at the end of the next tick
+    FlushTileVisuals();
+
+    UE_LOG(LogTemp, Display, TEXT("Reset fire to authored state: %d of %d tiles, %d objects in %.2f ms"),
+        NumTilesReset, Tiles.Num(), Objects.Num(), FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+    return true;
+}
+
+AFireSpreadPatch* UFireSpreadSubsystem::GetPatch(int32 TileIndex) const
+{
+    return Patches.IsValidIndex(TileIndex) ? Patches[TileIndex] : nullptr;
+}
+
+TArray<int32> UFireSpreadSubsystem::GetTileNeighbours(int32 TileIndex) const
+{
+    if (!Tiles.IsValidIndex(TileIndex)) return TArray<int32>();
+    return TArray<int32>(Tiles.Neighbours[TileIndex]);
+}
+
+AFirePatchField* UFireSpreadSubsystem::GetFieldForTile(int32 TileIndex) const
+{
+    for (AFirePatchField* Field : Fields)
+    {
+        if (Field && Field->OwnsTile(TileIndex))
+        {
+            return Field;
+        }
+    }
+    return nullptr;
+}
+
+int32 UFireSpreadSubsystem::GetTileIndexFromHit(const FHitResult& Hit)
+{
+    // The shared ground body holds every tile, the impact point says which
+    if (GroundCollision && Hit.GetComponent() == GroundCollision)
+    {
+        return FindTileAt(Hit.ImpactPoint);
+    }
+
+    AActor* HitActor = Hit.GetActor();
+
+    // Objects trace the ground in their BeginPlay, which can run before the patch has registered
+    if (AFireSpreadPatch* Patch = Cast<AFireSpreadPatch>(HitActor))
+    {
+        return Patch->PatchIndex != INDEX_NONE ? Patch->PatchIndex : RegisterPatch(Patch);
+    }
+
+    // Instanced mesh hits carry the instance index in Item
+    if (AFirePatchField* Field = Cast<AFirePatchField>(HitActor))
+    {
+        return Field->GetTileIndex(Hit.Item);
+    }
+
+    return INDEX_NONE;
+}
+
+int32 UFireSpreadSubsystem::FindTileAt(const FVector& Location) const
+{
+    for (const AFirePatchField* Field : Fields)
+    {
+        if (!Field || Field->TileSize <= 0.0f) continue;
+
+        const FVector Local = Field->GetActorTransform().InverseTransformPosition(Location);
+        if (FMath::Abs(Local.Z) > 0.5f * Field->TileSize + 1.0f) continue;
+
+        const int32 Instance = Field->FindInstance(FIntPoint(FMath::RoundToInt(Local.X / Field->TileSize), FMath::RoundToInt(Local.Y / Field->TileSize)));
+        if (Instance != INDEX_NONE)
+        {
+            return Field->GetTileIndex(Instance);
+        }
+    }
+
+    // Impact points sit on the box surface, so they get a unit of slack. Where patches overlap the
+    // one whose centre is nearest wins
+    int32 BestTile = INDEX_NONE;
+    double BestDistance = TNumericLimits<double>::Max();
+    const FIntPoint Cell = GetPatchCell(Location);
+    const int32 Range = FMath::CeilToInt(MaxPatchReach / PatchCellSize);
+    for (int32 DY = -Range; DY <= Range; ++DY)
+    {
+        for (int32 DX = -Range; DX <= Range; ++DX)
+        {
+            for (TMultiMap<FIntPoint, int32>::TConstKeyIterator It = PatchCells.CreateConstKeyIterator(Cell + FIntPoint(DX, DY)); It; ++It)
+            {
+                const AFireSpreadPatch* Patch = Patches[It.Value()];
+                if (!Patch || !Patch->DetectionVolume || GetDistanceToPatchBox(*Patch, Location) > 1.0f) continue;
+
+                const double Distance = FVector::DistSquared(Patch->GetActorLocation(), Location);
+                if (Distance < BestDistance)
+                {
+                    BestDistance = Distance;
+                    BestTile = It.Value();
+                }
+            }
+        }
+    }
+    return BestTile;
+}
+
+void UFireSpreadSubsystem::FlushGroundCollision()
+{
+    if (GroundCollisionLayoutVersion == LayoutVersion) return;
+
+    UWorld* World = GetWorld();
+    if (!World || World->bIsTearingDown) return;
+    GroundCollisionLayoutVersion = LayoutVersion;
+
+    TArray<FKBoxElem> Boxes;
+    Boxes.Reserve(Patches.Num());
+    for (const AFireSpreadPatch* Patch : Patches)
+    {
+        if (!Patch || !Patch->DetectionVolume) continue;
+
+        const FVector Size = 2.0 * Patch->DetectionVolume->GetScaledBoxExtent();
+        FKBoxElem& Box = Boxes.Emplace_GetRef(Size.X, Size.Y, Size.Z);
+        Box.Center = Patch->DetectionVolume->GetComponentLocation();
+        Box.Rotation = Patch->DetectionVolume->GetComponentRotation();
+    }
+    for (const AFirePatchField* Field : Fields)
+    {
+        if (Field) AddFieldBoxes(*Field, Boxes);
+    }
+
+    if (!GroundCollision)
+    {
+        if (Boxes.Num() == 0) return;
+
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.ObjectFlags |= RF_Transient;
+        SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+        GroundCollisionActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+        if (!GroundCollisionActor) return;
+
+        GroundCollision = NewObject<UFireGroundCollisionComponent>(GroundCollisionActor, TEXT("GroundCollision"));
+        GroundCollisionActor->SetRootComponent(GroundCollision);
+        GroundCollision->RegisterComponent();
+    }
+
+    GroundCollision->SetBoxes(MoveTemp(Boxes));
+    UE_LOG(LogTemp, Display, TEXT("Built the fire ground collision, %d boxes for %d tiles"), GroundCollision->GetNumBoxes(), Tiles.Num());
+}
+
+FString UFireSpreadSubsystem::DescribeTile(int32 TileIndex) const
+{
+    if (AFireSpreadPatch* Patch = GetPatch(TileIndex))
+    {
+        return Patch->GetName();
+    }
+    if (AFirePatchField* Field = GetFieldForTile(TileIndex))
+    {
+        return FString::Printf(TEXT("%s[%d]"), *Field->GetName(), Field->GetInstanceIndex(TileIndex));
+    }
+    return FString::Printf(TEXT("Tile %d"), TileIndex);
+}
+
+// Tile Transitions
+bool UFireSpreadSubsystem::IgniteTile(int32 TileIndex, EFireIgniteSource Source)
+{
+    if (!HasSimulationAuthority()) return false;
+    if (!Tiles.IsValidIndex(TileIndex) || !Tiles.CanIgnite(TileIndex)) return false;
+
+    // Fire reaching a coarse cell lights it as a whole, anything else needs the exact tile
+    if (Tiles.HasFlag(TileIndex, EFireTileFlags::Coarse))
+    {
+        if (Source == EFireIgniteSource::Spread) return IgniteCoarseTile(TileIndex);
+        RefineLodCell(Lod.FindCell(TileIndex));
+    }
+
+    SetTileBurning(TileIndex, true);
+    RecordFireEvent(TileIndex, EFireEventType::Ignite, Source);
+    OnTileStateChanged(TileIndex);
+    QueueObjectIgnitions(TileIndex);
+
+    // Burning out is left to the fuel running down, and spreading to the heat field if it is on
+    if (bUseHeatEngine) return true;
+
+    // Once on fire try to spread to it's neighbour
+    ScheduleEvent(TileIndex, EFireEventType::Spread, FetchSpreadDelay(TileIndex));
+    return true;
+}
+
+void UFireSpreadSubsystem::SpreadFromTile(int32 TileIndex)
+{
+    if (!HasSimulationAuthority() || !Tiles.IsValidIndex(TileIndex)) return;
+
+    RecordFireEvent(TileIndex, EFireEventType::Spread);
+
+    if (SpreadWeightsLayoutVersion != LayoutVersion)
+    {
+        UpdateSpreadWeights();
+    }
+
+    // Up to 3 of the valid neighbours, weighted by wind and slope, fewer as the tile's fuel runs low
+    const int32 MaxPicks = FFireSpreadWeights::GetMaxPicks(GetTileFuel(TileIndex), GetFullIntensityFuel());
+
+    TArray<int32, TInlineAllocator<8>> Picked;
+    {
+        SCOPE_CYCLE_COUNTER(STAT_FirePickNeighbours);
+        SpreadWeights.PickNeighbours(Tiles, TileIndex, MaxPicks, FireRandom, Picked);
+    }
+
+    for (int32 Neighbour : Picked)
+    {
+        IgniteTile(Neighbour, EFireIgniteSource::Spread);
+    }
+}
+
+void UFireSpreadSubsystem::SetWind(FVector2D Wind)
+{
+    WindVector = FVector2f(Wind);
+    UpdateSpreadWeights();
+}
+
+const FFireSpreadWeights& UFireSpreadSubsystem::GetSpreadWeights()
+{
+    if (SpreadWeightsLayoutVersion != LayoutVersion)
+    {
+        UpdateSpreadWeights();
+    }
+    return SpreadWeights;
+}
+
+float UFireSpreadSubsystem::GetFullIntensityFuel() const
+{
+    return FMath::Max(CVarFireFullIntensityFuel.GetValueOnGameThread(), KINDA_SMALL_NUMBER);
+}
+
+void UFireSpreadSubsystem::UpdateSpreadWeights()
+{
+    if (SpreadWeightsLayoutVersion != LayoutVersion)
+    {
+        SpreadWeights.Init(Tiles);
+        SpreadWeightsLayoutVersion = LayoutVersion;
+        bWeightBuildWanted = true;
+    }
+
+    FFireSpreadWeightParams Params;
+    Params.Wind = WindVector;
+    Params.SlopeInfluence = CVarFireSlopeInfluence.GetValueOnGameThread();
+    bWeightBuildWanted |= SpreadWeights.SetParams(Params);
+
+    // One build at a time, a build made stale while running is dropped and the next one started
+    if (PendingWeightBuild.IsValid())
+    {
+        if (!PendingWeightBuild.IsReady()) return;
+
+        FFireSpreadWeightBuild Build = PendingWeightBuild.Consume();
+        const int32 NumApplied = SpreadWeights.ApplyBuild(Build);
+        UE_LOG(LogTemp, Verbose, TEXT("Spread weights: %d of %d tables built in %.2f ms on a worker, %d applied"),
+            Build.Tiles.Num(), Tiles.Num(), Build.BuildMs, NumApplied);
+        WeightBuildTiles = MoveTemp(Build.Tiles);
+    }
+
+    if (!bWeightBuildWanted) return;
+    bWeightBuildWanted = false;
+
+    // Only tiles that can still burn will ever spread, the rest stay stale and are built if they are needed
+    WeightBuildTiles.Reset(Tiles.Num());
+    for (int32 Tile = 0; Tile < Tiles.Num(); ++Tile)
+    {
+        if (Tiles.IsBurning(Tile) || Tiles.CanIgnite(Tile))
+        {
+            WeightBuildTiles.Add(Tile);
+        }
+    }
+
+    if (WeightBuildTiles.Num() > 0)
+    {
+        PendingWeightBuild = SpreadWeights.LaunchBuild(MoveTemp(WeightBuildTiles));
+    }
+}
+
+void UFireSpreadSubsystem::BurnOutTile(int32 TileIndex)
+{
+    if (!HasSimulationAuthority() || !Tiles.IsValidIndex(TileIndex)) return;
+
+    SetTileBurning(TileIndex, false);
+    Tiles.SetFlag(TileIndex, EFireTileFlags::Burnt, true);
+    RecordFireEvent(TileIndex, EFireEventType::BurnOut);
+    OnTileStateChanged(TileIndex);
+}
+
+bool UFireSpreadSubsystem::DigTile(int32 TileIndex)
+{
+    if (!HasSimulationAuthority() || !Tiles.IsValidIndex(TileIndex)) return false;
+    if (Tiles.HasFlag(TileIndex, EFireTileFlags::Burning | EFireTileFlags::Burnt | EFireTileFlags::Dug)) return false;
+
+    if (Tiles.HasFlag(TileIndex, EFireTileFlags::Coarse))
+    {
+        RefineLodCell(Lod.FindCell(TileIndex));
+    }
+
+    Tiles.SetFlag(TileIndex, EFireTileFlags::Dug, true);
+    Tiles.BurnTypes[TileIndex] = ESurfaceBurnType::Dug;
+    RecordFireEvent(TileIndex, EFireEventType::Dig);
+    OnTileStateChanged(TileIndex);
+    return true;
+}
+
+// Bulk Tools
+int32 UFireSpreadSubsystem::ApplyTool(EFireToolOp Op, TArrayView<const int32> TileIndices, EFireIgniteSource Source)
+{
+    if (!HasSimulationAuthority() || TileIndices.Num() == 0) return 0;
+
+    SCOPE_CYCLE_COUNTER(STAT_FireBulkTool);
+
+    // The same checks as a single dig or ignition, tiles that fail them are skipped
+    int32 NumChanged = 0;
+    bBatchingEvents = true;
+    for (int32 Tile : TileIndices)
+    {
+        NumChanged += Op == EFireToolOp::Dig ? DigTile(Tile) : IgniteTile(Tile, Source);
+    }
+    bBatchingEvents = false;
+
+    // A big batch is cheaper to heapify along with the queue than to push an event at a time
+    if (BatchedEvents.Num() > EventQueue.Num() / 8)
+    {
+        EventQueue.Append(BatchedEvents);
+        EventQueue.Heapify(FEventDueBefore());
+    }
+    else
+    {
+        for (const FFireEvent& Event : BatchedEvents)
+        {
+            EventQueue.HeapPush(Event, FEventDueBefore());
+        }
+    }
+    BatchedEvents.Reset();
+
+    FlushTileVisuals();
+
+    if (TileIndices.Num() > 1)
+    {
+        UE_LOG(LogTemp, Display, TEXT("%s %d of %d tiles"), Op == EFireToolOp::Dig ? TEXT("Dug") : TEXT("Ignited"), NumChanged, TileIndices.Num());
+    }
+    return NumChanged;
+}
+
+int32 UFireSpreadSubsystem::ApplyToolToTiles(EFireToolOp Op, const TArray<int32>& TileIndices, EFireIgniteSource Source)
+{
+    return ApplyTool(Op, TileIndices, Source);
+}
+
+int32 UFireSpreadSubsystem::ApplyToolInRect(EFireToolOp Op, FVector2D Min, FVector2D Max, EFireIgniteSource Source)
+{
+    FindTilesInRect(Min, Max, ToolTiles);
+    return ApplyTool(Op, ToolTiles, Source);
+}
+
+int32 UFireSpreadSubsystem::ApplyToolAlongPath(EFireToolOp Op, const TArray<FVector>& Points, float HalfWidth, EFireIgniteSource Source)
+{
+    FindTilesAlongPath(Points, HalfWidth, ToolTiles);
+    return ApplyTool(Op, ToolTiles, Source);
+}
+
+void UFireSpreadSubsystem::FindTilesInRect(const FVector2D& Min, const FVector2D& Max, TArray<int32>& OutTiles) const
+{
+    OutTiles.Reset();
+
+    const FVector2D RectMin = FVector2D::Min(Min, Max);
+    const FVector2D RectMax = FVector2D::Max(Min, Max);
+    FindTilesUnder(FBox(FVector(RectMin, -HALF_WORLD_MAX), FVector(RectMax, HALF_WORLD_MAX)), OutTiles);
+    OutTiles.Sort();
+}
+
+void UFireSpreadSubsystem::FindTilesAlongPath(TArrayView<const FVector> Points, float HalfWidth, TArray<int32>& OutTiles) const
+{
+    OutTiles.Reset();
+
+    // Squares of HalfWidth every HalfWidth along each segment cover the strip, the corners they
+    // reach past it are cut off by each tile's distance to the segment
+    const float Step = FMath::Max(HalfWidth, 10.0f);
+    const FVector Extent(Step, Step, HALF_WORLD_MAX);
+    for (int32 i = 0; i < Points.Num(); ++i)
+    {
+        const FVector Start(Points[i].X, Points[i].Y, 0.0);
+        const FVector End = Points.IsValidIndex(i + 1) ? FVector(Points[i + 1].X, Points[i + 1].Y, 0.0) : Start;
+        const FVector2D Segment(End - Start);
+        const int32 NumSteps = FMath::CeilToInt(Segment.Size() / Step);
+
+        const int32 FirstFound = OutTiles.Num();
+        for (int32 j = 0; j <= NumSteps; ++j)
+        {
+            const FVector2D Centre = FVector2D(Start) + Segment * (NumSteps > 0 ? static_cast<float>(j) / NumSteps : 0.0f);
+            FindTilesUnder(FBox::BuildAABB(FVector(Centre, 0.0), Extent), OutTiles);
+        }
+
+        for (int32 Found = OutTiles.Num() - 1; Found >= FirstFound; --Found)
+        {
+            const FVector3f& Location = Tiles.Locations[OutTiles[Found]];
+            if (FMath::PointDistToSegment(FVector(Location.X, Location.Y, 0.0), Start, End) > HalfWidth)
+            {
+                OutTiles.RemoveAtSwap(Found, 1, false);
+            }
+        }
+    }
+
+    // Neighbouring squares find many of the same tiles
+    OutTiles.Sort();
+    OutTiles.SetNum(Algo::Unique(OutTiles), false);
+}
+
+float UFireSpreadSubsystem::FetchSpreadDelay(int32 TileIndex) const
+{
+    // Based on the type, set the spread delay
+    return FFireTileTable::GetSpreadDelayScale(Tiles.BurnTypes[TileIndex]) *
+        FireRandom.FRandRange(Tiles.MinSpreadDelays[TileIndex], Tiles.MaxSpreadDelays[TileIndex]);
+}
+
+float UFireSpreadSubsystem::FetchObjectSpreadDelay(const ABasicObject& Object) const
+{
+    return Object.FlammabilityFactor * FireRandom.FRandRange(Object.MinSpreadDelay, Object.MaxSpreadDelay);
+}
+
+void UFireSpreadSubsystem::SetTileBurning(int32 TileIndex, bool bBurning)
+{
+    Tiles.SetFlag(TileIndex, EFireTileFlags::Burning, bBurning);
+
+    int32& Slot = BurningSlots[TileIndex];
+    if (bBurning && Slot == INDEX_NONE)
+    {
+        Slot = BurningTiles.Add(TileIndex);
+        BurningFuel.Add(Tiles.FuelLoads[TileIndex]);
+        BurningRates.Add(Tiles.BurnRates[TileIndex]);
+    }
+    else if (!bBurning && Slot != INDEX_NONE)
+    {
+        // Swap the last burning tile into the freed slot
+        const int32 MovedTile = BurningTiles.Last();
+        BurningTiles.RemoveAtSwap(Slot, 1, false);
+        BurningFuel.RemoveAtSwap(Slot, 1, false);
+        BurningRates.RemoveAtSwap(Slot, 1, false);
+        if (MovedTile != TileIndex)
+        {
+            BurningSlots[MovedTile] = Slot;
+        }
+        Slot = INDEX_NONE;
+    }
+}
+
+float UFireSpreadSubsystem::GetTileFuel(int32 TileIndex) const
+{
+    if (!Tiles.IsValidIndex(TileIndex) || Tiles.IsBurnt(TileIndex)) return 0.0f;
+
+    const int32 Slot = BurningSlots[TileIndex];
+    return Slot != INDEX_NONE ? FMath::Max(BurningFuel[Slot], 0.0f) : Tiles.FuelLoads[TileIndex];
+}
+
+void UFireSpreadSubsystem::ConsumeFuel(float Seconds, TArray<int32>* OutBurntOut)
+{
+    if (OutBurntOut)
+    {
+        OutBurntOut->Reset();
+    }
+    if (Seconds <= 0.0f || BurningFuel.Num() == 0) return;
+
+    SCOPE_CYCLE_COUNTER(STAT_FireConsumeFuel);
+
+    float* Fuel = BurningFuel.GetData();
+    const float* Rates = BurningRates.GetData();
+    const int32 NumBurning = BurningFuel.Num();
+    const VectorRegister4Float Delta = VectorSetFloat1(Seconds);
+    const VectorRegister4Float Zero = VectorZeroFloat();
+
+    int32 Slot = 0;
+    for (; Slot + 4 <= NumBurning; Slot += 4)
+    {
+        const VectorRegister4Float Left = VectorNegateMultiplyAdd(VectorLoad(Rates + Slot), Delta, VectorLoad(Fuel + Slot));
+        VectorStore(Left, Fuel + Slot);
+
+        const int32 OutMask = OutBurntOut ? VectorMaskBits(VectorCompareLE(Left, Zero)) : 0;
+        for (int32 Lane = 0; OutMask != 0 && Lane < 4; ++Lane)
+        {
+            if (OutMask & (1 << Lane)) OutBurntOut->Add(BurningTiles[Slot + Lane]);
+        }
+    }
+    for (; Slot < NumBurning; ++Slot)
+    {
+        Fuel[Slot] -= Rates[Slot] * Seconds;
+        if (OutBurntOut && Fuel[Slot] <= 0.0f) OutBurntOut->Add(BurningTiles[Slot]);
+    }
+}
+
+void UFireSpreadSubsystem::RestoreQueuedEvent(int32 TileIndex, EFireEventType Type, float Remaining)
+{
+    if (Type != EFireEventType::BurnOut)
+    {
+        ScheduleEvent(TileIndex, Type, Remaining);
+        return;
+    }
+
+    const int32 Slot = BurningSlots[TileIndex];
+    if (Slot != INDEX_NONE)
+    {
+        BurningFuel[Slot] = Remaining * BurningRates[Slot];
+    }
+}
+
+void UFireSpreadSubsystem::SetTileVisual(int32 TileIndex, EFireTileVisual Visual)
+{
+    SetTileBurning(TileIndex, Visual == EFireTileVisual::Burning);
+    Tiles.SetFlag(TileIndex, EFireTileFlags::Burnt, Visual == EFireTileVisual::Burnt);
+    Tiles.SetFlag(TileIndex, EFireTileFlags::Dug, Visual == EFireTileVisual::Dug);
+    Tiles.SetFlag(TileIndex, EFireTileFlags::PendingIgnition, false);
+}
+
+void UFireSpreadSubsystem::ApplyPackedTileState(int32 TileIndex, uint8 PackedState)
+{
+    const EFireTileVisual Visual = static_cast<EFireTileVisual>(PackedState & 0x3);
+    const ESurfaceBurnType BurnType = static_cast<ESurfaceBurnType>(PackedState >> 2);
+    if (Visual == Tiles.GetVisual(TileIndex) && BurnType == Tiles.BurnTypes[TileIndex]) return;
+
+    SetTileVisual(TileIndex, Visual);
+    Tiles.BurnTypes[TileIndex] = BurnType;
+    OnTileStateChanged(TileIndex);
+}
+
+uint8 UFireSpreadSubsystem::GetPackedTileState(int32 TileIndex) const
+{
+    return static_cast<uint8>(static_cast<uint8>(Tiles.GetVisual(TileIndex)) | (static_cast<uint8>(Tiles.BurnTypes[TileIndex]) << 2));
+}
+
+void UFireSpreadSubsystem::OnTileStateChanged(int32 TileIndex)
+{
+    // Patch actors keep their flags so Blueprints and older readers still see the state
+    if (AFireSpreadPatch* Patch = GetPatch(TileIndex))
+    {
+        Patch->bIsBurning = Tiles.IsBurning(TileIndex);
+        Patch->bIsBurnt = Tiles.IsBurnt(TileIndex);
+        Patch->bIsDug = Tiles.IsDug(TileIndex);
+        Patch->BurnType = Tiles.BurnTypes[TileIndex];
+    }
+
+    if (bUseHeatEngine)
+    {
+        HeatField.SyncTile(Tiles, TileIndex);
+    }
+
+    // The grids are built from the table when the layout moves, until then there is nothing to keep in step
+    if (PathLayoutVersion == LayoutVersion)
+    {
+        Pathfinder.SetTileCost(TileIndex, FFirePathGrid::GetTileCost(Tiles, TileIndex));
+    }
+
+    const int32 Chunk = FFireTileTable::GetChunk(TileIndex);
+    if (!ChunkVersions.IsValidIndex(Chunk))
+    {
+        ChunkVersions.SetNumZeroed(Tiles.NumChunks());
+    }
+    ++ChunkVersions[Chunk];
+
+    // Effects, materials and Blueprint notifications wait for the batch at the end of the tick
+    if (!Tiles.HasFlag(TileIndex, EFireTileFlags::VisualDirty))
+    {
+        Tiles.SetFlag(TileIndex, EFireTileFlags::VisualDirty, true);
+        DirtyTiles.Add(TileIndex);
+    }
+}
+
+void UFireSpreadSubsystem::FlushTileVisuals(uint64 BudgetStartCycles)
+{
+    // Readers get the new state before any effect, audio or notification for it goes out
+    if (DirtyTiles.Num() > 0 || StateSnapshots.GetFront()->LayoutVersion != LayoutVersion)
+    {
+        StateSnapshots.Publish(Tiles, BurningTiles, GetFireTime(), LayoutVersion);
+    }
+
+    if (DirtyTiles.Num() == 0) return;
+
+    SCOPE_CYCLE_COUNTER(STAT_FireFlushTileVisuals);
+
+    // Tiles a budget held back last time stay in front, only the ones queued since are sorted
+    const int32 NumCarried = NumCarriedTiles;
+    MakeArrayView(DirtyTiles).Slice(NumCarried, DirtyTiles.Num() - NumCarried).Sort();
+    DirtyVisuals.Reset(DirtyTiles.Num());
+    for (int32 Tile : DirtyTiles)
+    {
+        DirtyVisuals.Add(Tiles.GetVisual(Tile));
+    }
+
+    // Each field owns a contiguous block of tiles, so once sorted every field gets one slice per tile chunk
+    int32 Start = 0;
+    while (Start < DirtyTiles.Num())
+    {
+        // At least one slice goes out each flush
+        if (Start > 0 && BudgetStartCycles != 0 && IsOverFrameBudget(BudgetStartCycles)) break;
+
+        if (AFireSpreadPatch* Patch = GetPatch(DirtyTiles[Start]))
+        {
+            Tiles.SetFlag(DirtyTiles[Start], EFireTileFlags::VisualDirty, false);
+            if (DirtyVisuals[Start] == EFireTileVisual::Burning)
+            {
+                Patch->StartBurningEffects();
+            }
+            else if (DirtyVisuals[Start] == EFireTileVisual::Burnt)
+            {
+                Patch->StopBurningEffects();
+            }
+            else
+            {
+                // A restored snapshot can put a burning patch back to unburnt
+                Patch->StopBurningEffects(false);
+            }
+            ++Start;
+            continue;
+        }
+
+        AFirePatchField* Field = GetFieldForTile(DirtyTiles[Start]);
+
+        int32 End = Start + 1;
+        while (Field && End < DirtyTiles.Num() && End - Start < FireTileChunkSize && Field->OwnsTile(DirtyTiles[End]))
+        {
+            ++End;
+        }
+
+        for (int32 i = Start; i < End; ++i)
+        {
+            Tiles.SetFlag(DirtyTiles[i], EFireTileFlags::VisualDirty, false);
+        }
+        if (Field)
+        {
+            Field->ApplyTileVisuals(
+                MakeArrayView(DirtyTiles).Slice(Start, End - Start),
+                MakeArrayView(DirtyVisuals).Slice(Start, End - Start));
+        }
+        Start = End;
+    }
+
+    // One audio refresh for the whole batch instead of one per tile
+    if (!AudioManager)
+    {
+        AudioManager = Cast<AAudioManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AAudioManager::StaticClass()));
+    }
+    if (AudioManager)
+    {
+        AudioManager->UpdateFireAudio();
+    }
+
+    // What the budget held back waits for the next flush, the rest goes out sorted
+    CarriedTiles.Reset();
+    CarriedTiles.Append(DirtyTiles.GetData() + Start, DirtyTiles.Num() - Start);
+    DirtyTiles.SetNum(Start, false);
+    if (NumCarried > 0)
+    {
+        DirtyTiles.Sort();
+    }
+
+    OnTilesVisualChanged.Broadcast(DirtyTiles);
+
+    DirtyTiles.Reset();
+    DirtyTiles.Append(CarriedTiles);
+    NumCarriedTiles = DirtyTiles.Num();
+}
+
+bool UFireSpreadSubsystem::IsOverFrameBudget(uint64 StartCycles) const
+{
+    const float BudgetUs = CVarFireFrameBudgetUs.GetValueOnGameThread();
+    return BudgetUs > 0.0f && FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000.0 >= BudgetUs;
+}
+
+void UFireSpreadSubsystem::GetFireCounts(int32& NumBurning, int32& NumBurnt, int32& NumDug, float& BurnPercent) const
+{
+    const FFireStateCounters& Counters = StateSnapshots.GetFront()->Counters;
+    NumBurning = Counters.NumBurning;
+    NumBurnt = Counters.NumBurnt;
+    NumDug = Counters.NumDug;
+    BurnPercent = Counters.GetBurnPercent();
+}
+
+bool UFireSpreadSubsystem::IsTileBurning(int32 TileIndex) const
+{
+    return Tiles.IsValidIndex(TileIndex) && Tiles.IsBurning(TileIndex);
+}
+
+bool UFireSpreadSubsystem::IsTileBurnt(int32 TileIndex) const
+{
+    return Tiles.IsValidIndex(TileIndex) && Tiles.IsBurnt(TileIndex);
+}
+
+bool UFireSpreadSubsystem::IsTileDug(int32 TileIndex) const
+{
+    return Tiles.IsValidIndex(TileIndex) && Tiles.IsDug(TileIndex);
+}
+
+// Event Queue
+void UFireSpreadSubsystem::ScheduleEvent(int32 TileIndex, EFireEventType Type, float Delay)
+{
+    if (!Tiles.IsValidIndex(TileIndex)) return;
+
+    FFireEvent Event;
+    Event.TileIndex = TileIndex;
+    Event.Type = Type;
+    Event.DueTime = GetFireTime() + Delay;
+
+    if (bBatchingEvents)
+    {
+        BatchedEvents.Add(Event);
+        return;
+    }
+    EventQueue.HeapPush(Event, FEventDueBefore());
+}
+
+void UFireSpreadSubsystem::GetQueuedEvents(TArray<FFireHistoryEvent>& OutEvents) const
+{
+    const double Now = GetFireTime();
+
+    OutEvents.Reset(EventQueue.Num() + DueEvents.Num());
+    for (const TArray<FFireEvent>* Queue : { &DueEvents, &EventQueue })
+    {
+        for (const FFireEvent& Event : *Queue)
+        {
+            FFireHistoryEvent& QueuedEvent = OutEvents.AddDefaulted_GetRef();
+            QueuedEvent.TileIndex = Event.TileIndex;
+            QueuedEvent.Type = Event.Type;
+            QueuedEvent.Remaining = FMath::Max(0.0f, static_cast<float>(Event.DueTime - Now));
+        }
+    }
+
+    // Burn outs are the fuel running down, given as the time that takes so simulations and history can queue them
+    for (int32 Slot = 0; Slot < BurningTiles.Num(); ++Slot)
+    {
+        FFireHistoryEvent& BurnOut = OutEvents.AddDefaulted_GetRef();
+        BurnOut.TileIndex = BurningTiles[Slot];
+        BurnOut.Type = EFireEventType::BurnOut;
+        BurnOut.Remaining = FMath::Max(0.0f, BurningFuel[Slot] / BurningRates[Slot]);
+    }
+
+    // Tiles coarse cells lit spread once they are refined, they are given their shortest delay
+    QueryLitTiles.Reset();
+    Lod.GetLitTiles(QueryLitTiles);
+    for (int32 Tile : QueryLitTiles)
+    {
+        FFireHistoryEvent& Spread = OutEvents.AddDefaulted_GetRef();
+        Spread.TileIndex = Tile;
+        Spread.Type = EFireEventType::Spread;
+        Spread.Remaining = FFireTileTable::GetSpreadDelayScale(Tiles.BurnTypes[Tile]) * Tiles.MinSpreadDelays[Tile];
+    }
+}
+
+int32 UFireSpreadSubsystem::GetPendingSpreadEvents(TArray<FFireEventRecord>& OutEvents, int32 MaxEvents) const
+{
+    MaxEvents = FMath::Max(MaxEvents, 0);
+    OutEvents.Reset(MaxEvents);
+
+    // Only the MaxEvents soonest are kept, in a heap with the latest of them on top
+    auto IsLater = [](const FFireEventRecord& A, const FFireEventRecord& B)
+    {
+        return A.Time > B.Time;
+    };
+
+    int32 TotalPending = 0;
+    for (const TArray<FFireEvent>* Events : { &DueEvents, &EventQueue })
+    {
+        for (const FFireEvent& Event : *Events)
+        {
+            if (Event.Type != EFireEventType::Spread) continue;
+            ++TotalPending;
+
+            if (OutEvents.Num() == MaxEvents)
+            {
+                if (MaxEvents == 0 || Event.DueTime >= OutEvents.HeapTop().Time) continue;
+                OutEvents.HeapPopDiscard(IsLater, false);
+            }
+
+            FFireEventRecord Record;
+            Record.Time = Event.DueTime;
+            Record.TileIndex = Event.TileIndex;
+            Record.Type = Event.Type;
+            OutEvents.HeapPush(Record, IsLater);
+        }
+    }
+
+    OutEvents.Sort([](const FFireEventRecord& A, const FFireEventRecord& B)
+        {
+            return A.Time < B.Time;
+        });
+    return TotalPending;
+}
+
+void UFireSpreadSubsystem::CountTileStates(int32& OutBurning, int32& OutBurnt) const
+{
+    OutBurning = 0;
+    OutBurnt = 0;
+
+    for (int32 Tile = 0; Tile < Tiles.Num(); ++Tile)
+    {
+        if (Tiles.IsBurning(Tile)) ++OutBurning;
+        if (Tiles.IsBurnt(Tile)) ++OutBurnt;
+    }
+}
+
+// Snapshots
+uint32 UFireSpreadSubsystem::ComputeLayoutHash() const
+{
+    const int32 NumTiles = Tiles.Num();
+    return FCrc::MemCrc32(Tiles.Locations.GetData(), Tiles.Locations.Num() * sizeof(FVector3f), static_cast<uint32>(NumTiles));
+}
+
+void UFireSpreadSubsystem::SaveSnapshot(TArray<uint8>& OutData) const
+{
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    FBitWriter Writer(0, true);
+
+    uint32 Magic = FireSnapshotMagic;
+    uint16 Version = FireSnapshotVersion;
+    int32 NumTiles = Tiles.Num();
+    uint32 LayoutHash = ComputeLayoutHash();
+    int32 Seed = FireRandom.GetCurrentSeed();
+    Writer << Magic << Version << NumTiles << LayoutHash << Seed;
+
+    // 2 bits of visual state (which is the burning / burnt / dug set) and 3 bits of burn type
+    for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+    {
+        uint32 Visual = static_cast<uint32>(Tiles.GetVisual(Tile));
+        uint32 BurnType = static_cast<uint32>(Tiles.BurnTypes[Tile]);
+        Writer.SerializeInt(Visual, 4);
+        Writer.SerializeInt(BurnType, 8);
+    }
+
+    // Remaining burn and spread time lives in the queue, events are sorted by tile so indices delta encode
+    const double Now = GetFireTime();
+    TArray<FFireEvent> Events;
+    Events.Reserve(EventQueue.Num() + DueEvents.Num() + BurningTiles.Num());
+    Events.Append(DueEvents);
+    Events.Append(EventQueue);
+
+    // Fuel is saved as the time left until it runs out, which keeps the format of the timed burn outs before it
+    for (int32 Slot = 0; Slot < BurningTiles.Num(); ++Slot)
+    {
+        FFireEvent& BurnOut = Events.AddDefaulted_GetRef();
+        BurnOut.TileIndex = BurningTiles[Slot];
+        BurnOut.Type = EFireEventType::BurnOut;
+        BurnOut.DueTime = Now + FMath::Max(0.0f, BurningFuel[Slot] / BurningRates[Slot]);
+    }
+
+    // As in GetQueuedEvents
+    QueryLitTiles.Reset();
+    Lod.GetLitTiles(QueryLitTiles);
+    for (int32 Tile : QueryLitTiles)
+    {
+        FFireEvent& Spread = Events.AddDefaulted_GetRef();
+        Spread.TileIndex = Tile;
+        Spread.Type = EFireEventType::Spread;
+        Spread.DueTime = Now + FFireTileTable::GetSpreadDelayScale(Tiles.BurnTypes[Tile]) * Tiles.MinSpreadDelays[Tile];
+    }
+
+    Events.Sort([](const FFireEvent& A, const FFireEvent& B)
+        {
+            return A.TileIndex < B.TileIndex;
+        });
+
+    uint32 NumEvents = Events.Num();
+    Writer.SerializeIntPacked(NumEvents);
+
+    int32 PreviousTile = 0;
+    for (const FFireEvent& Event : Events)
+    {
+        uint32 TileDelta = Event.TileIndex - PreviousTile;
+        uint32 RemainingMs = FMath::Max(0, FMath::CeilToInt((Event.DueTime - Now) * 1000.0));
+        Writer.SerializeIntPacked(TileDelta);
+        Writer.WriteBit(Event.Type == EFireEventType::BurnOut ? 1 : 0);
+        Writer.SerializeIntPacked(RemainingMs);
+        PreviousTile = Event.TileIndex;
+    }
+
+    OutData.Reset();
+    OutData.Append(Writer.GetData(), Writer.GetNumBytes());
+
+    UE_LOG(LogTemp, Display, TEXT("Saved fire snapshot: %d tiles, %d events, %d bytes in %.2f ms"),
+        NumTiles, Events.Num(), OutData.Num(), FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+}
+
+bool UFireSpreadSubsystem::DecodeSnapshot(const TArray<uint8>& Data, TArray<uint8>& OutStates, TArray<FFireHistoryEvent>& OutEvents, int32& OutSeed) const
+{
+    FBitReader Reader(Data.GetData(), Data.Num() * 8);
+
+    uint32 Magic = 0;
+    uint16 Version = 0;
+    int32 NumTiles = 0;
+    uint32 LayoutHash = 0;
+    int32 Seed = 0;
+    Reader << Magic << Version << NumTiles << LayoutHash << Seed;
+
+    if (Reader.IsError() || Magic != FireSnapshotMagic || Version != FireSnapshotVersion)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Fire snapshot rejected: not a version %d snapshot"), FireSnapshotVersion);
+        return false;
+    }
+    if (NumTiles != Tiles.Num() || LayoutHash != ComputeLayoutHash())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Fire snapshot rejected: saved from a different level (%d tiles, this level has %d)"), NumTiles, Tiles.Num());
+        return false;
+    }
+
+    OutStates.SetNumUninitialized(NumTiles);
+    bool bValidTypes = true;
+    for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+    {
+        uint32 Visual = 0;
+        uint32 BurnType = 0;
+        Reader.SerializeInt(Visual, 4);
+        Reader.SerializeInt(BurnType, 8);
+        bValidTypes &= BurnType <= static_cast<uint32>(ESurfaceBurnType::Dug);
+        OutStates[Tile] = static_cast<uint8>(Visual | (BurnType << 2));
+    }
+
+    uint32 NumEvents = 0;
+    Reader.SerializeIntPacked(NumEvents);
+
+    // Every event's tile is checked, a delta that wraps could land an earlier one out of range
+    OutEvents.Reset();
+    int64 PreviousTile = 0;
+    bool bValidTiles = true;
+    for (uint32 i = 0; i < NumEvents && bValidTiles && !Reader.IsError(); ++i)
+    {
+        uint32 TileDelta = 0;
+        uint32 RemainingMs = 0;
+        Reader.SerializeIntPacked(TileDelta);
+        const bool bBurnOut = Reader.ReadBit() != 0;
+        Reader.SerializeIntPacked(RemainingMs);
+
+        const int64 TileIndex = PreviousTile + TileDelta;
+        bValidTiles = TileIndex < NumTiles;
+        if (!bValidTiles) break;
+
+        FFireHistoryEvent& Event = OutEvents.AddDefaulted_GetRef();
+        Event.TileIndex = static_cast<int32>(TileIndex);
+        Event.Type = bBurnOut ? EFireEventType::BurnOut : EFireEventType::Spread;
+        Event.Remaining = RemainingMs / 1000.0f;
+        PreviousTile = TileIndex;
+    }
+
+    if (Reader.IsError() || !bValidTypes || !bValidTiles)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Fire snapshot rejected: data is truncated or corrupt"));
+        return false;
+    }
+
+    OutSeed = Seed;
+    return true;
+}
+
+bool UFireSpreadSubsystem::ReadSnapshot(const TArray<uint8>& Data, FFireTileTable& OutTiles, TArray<FFireHistoryEvent>& OutEvents) const
+{
+    TArray<uint8> States;
+    int32 Seed = 0;
+    if (!DecodeSnapshot(Data, States, OutEvents, Seed)) return false;
+
+    // As RestoreSnapshot leaves the tiles, with every coarse cell handed back to the per tile fire
+    OutTiles = Tiles;
+    for (int32 Tile = 0; Tile < States.Num(); ++Tile)
+    {
+        const EFireTileVisual Visual = static_cast<EFireTileVisual>(States[Tile] & 0x3);
+        OutTiles.BurnTypes[Tile] = static_cast<ESurfaceBurnType>(States[Tile] >> 2);
+        OutTiles.SetFlag(Tile, EFireTileFlags::Burning, Visual == EFireTileVisual::Burning);
+        OutTiles.SetFlag(Tile, EFireTileFlags::Burnt, Visual == EFireTileVisual::Burnt);
+        OutTiles.SetFlag(Tile, EFireTileFlags::Dug, Visual == EFireTileVisual::Dug);
+        OutTiles.SetFlag(Tile, EFireTileFlags::PendingIgnition | EFireTileFlags::Coarse | EFireTileFlags::VisualDirty, false);
+    }
+    return true;
+}
+
+bool UFireSpreadSubsystem::RestoreSnapshot(const TArray<uint8>& Data)
+{
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    // Read everything before touching the tiles so a truncated snapshot changes nothing
+    TArray<uint8> States;
+    TArray<FFireHistoryEvent> Events;
+    int32 Seed = 0;
+    if (!DecodeSnapshot(Data, States, Events, Seed)) return false;
+
+    const int32 NumTiles = States.Num();
+    for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+    {
+        ApplyPackedTileState(Tile, States[Tile]);
+    }
+
+    EventQueue.Reset();
+    DueEvents.Reset();
+    for (const FFireHistoryEvent& Event : Events)
+    {
+        RestoreQueuedEvent(Event.TileIndex, Event.Type, Event.Remaining);
+    }
+    BacklogDepth = 0;
+
+    FireRandom.Initialize(Seed);
+
+    // Temperatures and coarse cells are not part of a snapshot, both start again from the restored tiles
+    HeatField.Reset();
+    Lod.ClearCells(Tiles);
+
+    // The history no longer leads up to this state
+    History.Reset();
+    HistoryFrameIndex = INDEX_NONE;
+
+    UE_LOG(LogTemp, Display, TEXT("Restored fire snapshot: %d tiles, %d events in %.2f ms"),
+        NumTiles, Events.Num(), FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+    return true;
+}
+
+void UFireSpreadSubsystem::RecordFireEvent(int32 TileIndex, EFireEventType Type, EFireIgniteSource Source)
+{
+    const double Now = GetFireTime();
+    HitchWatchdog.RecordEvent(Now, TileIndex, Type);
+
+    if (ReplayWriter.IsOpen())
+    {
+        ReplayWriter.Append(Now, TileIndex, Type, Source);
+    }
+    if (bReplaying && Type == EFireEventType::Ignite && Source == EFireIgniteSource::Spread)
+    {
+        ReplaySpreadIgnites.Add(TileIndex);
+    }
+}
+
+double UFireSpreadSubsystem::GetFireTime() const
+{
+    return bReplaying ? ReplayTime : GetWorld()->GetTimeSeconds();
+}
+
+void UFireSpreadSubsystem::ResetEventCounters()
+{
+    MaxBacklogDepth = 0;
+    MaxEventLateness = 0.0f;
+    MaxGCMarkMs = 0.0f;
+}
+
+void UFireSpreadSubsystem::StartAllocCheck(int32 WarmUpFrames, int32 Frames)
+{
+    AllocCheckWarmUp = FMath::Max(WarmUpFrames, 0);
+    AllocCheckFrames = FMath::Max(Frames, 1);
+    AllocCheckFramesLeft = AllocCheckFrames;
+    AllocCheckTicksAllocating = 0;
+    AllocCheckAllocations = 0;
+}
+
+void UFireSpreadSubsystem::CheckLoopAllocations(int32 NumAllocations)
+{
+    if (AllocCheckWarmUp > 0)
+    {
+        --AllocCheckWarmUp;
+        return;
+    }
+
+    if (NumAllocations > 0)
+    {
+        ++AllocCheckTicksAllocating;
+        AllocCheckAllocations += NumAllocations;
+        UE_LOG(LogTemp, Verbose, TEXT("fire.AllocCheck: the last tick made %d heap allocations"), NumAllocations);
+    }
+
+    if (--AllocCheckFramesLeft == 0)
+    {
+        if (AllocCheckAllocations == 0)
+        {
+            UE_LOG(LogTemp, Display, TEXT("fire.AllocCheck: passed, no tick of %d allocated (%d burning)"),
+                AllocCheckFrames, BurningTiles.Num());
+        }
+        else
+        {
+            UE_LOG(LogTemp, Error, TEXT("fire.AllocCheck: failed, %d of %d ticks made %d heap allocations (%d burning)"),
+                AllocCheckTicksAllocating, AllocCheckFrames, AllocCheckAllocations, BurningTiles.Num());
+        }
+    }
+}
+
+void UFireSpreadSubsystem::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_FireProcessEvents);
+
+    // Counters still describe the previous frame here, which is the one that took FApp::GetDeltaTime
+    HitchWatchdog.CheckFrame(*this, FApp::GetDeltaTime());
+
+    if (AllocCheckFramesLeft <= 0)
+    {
+        TickFire(DeltaTime);
+        return;
+    }
+
+    FFireAllocationCounter& Counter = FFireAllocationCounter::Get();
+    Counter.Begin();
+    TickFire(DeltaTime);
+    CheckLoopAllocations(Counter.End());
+}
+
+void UFireSpreadSubsystem::TickFire(float DeltaTime)
+{
+    // Clients trace the ground too
+    FlushGroundCollision();
+    UpdateObjectBindings();
+    UpdatePathfinding();
+
+    // Network clients only apply what the server sends them
+    if (!HasSimulationAuthority())
+    {
+        FlushTileVisuals(FPlatformTime::Cycles64());
+        return;
+    }
+
+    UpdateSpreadWeights();
+
+    // The fire is paused on a history frame
+    if (IsScrubbingHistory())
+    {
+        FlushTileVisuals(FPlatformTime::Cycles64());
+        return;
+    }
+
+    // A replay drives the fire from its log instead of the queue
+    if (bReplaying)
+    {
+        ReplayPlayhead += DeltaTime * ReplaySpeed;
+
+        FFireEventRecord Record;
+        while (ReplayReader.Peek(Record) && Record.Time <= ReplayPlayhead)
+        {
+            ReplayReader.Next(Record);
+            StepReplay(Record);
+        }
+        if (ReplayReader.IsAtEnd())
+        {
+            FinishReplay();
+        }
+
+        FlushTileVisuals(FPlatformTime::Cycles64());
+        return;
+    }
+
+    // Burn outs, due events and the visuals they change share one budget
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    // One pass over the burning tiles' fuel, whatever ran out burns out. Tiles the budget leaves
+    // keep their spent fuel, so the next pass hands them back
+    ConsumeFuel(DeltaTime, &FuelBurnOuts);
+    int32 BurntOut = 0;
+    for (int32 Tile : FuelBurnOuts)
+    {
+        // Coarse cells burn their tiles out themselves
+        if (Tiles.HasFlag(Tile, EFireTileFlags::Coarse)) continue;
+
+        // At least one goes out each tick, as with the events below
+        if (BurntOut > 0 && IsOverFrameBudget(StartCycles)) break;
+
+        BurnOutTile(Tile);
+        ++BurntOut;
+    }
+
+    const double Now = GetFireTime();
+    CollectDueEvents(Now);
+
+    EventsProcessedLastFrame = 0;
+    LastFrameMaxLateness = 0.0f;
+
+    // Always run at least one event so the fire keeps moving under any budget.
+    // RunEvent may queue new events, but never into the backlog
+    int32 Processed = 0;
+    while (DueEvents.Num() > 0)
+    {
+        FFireEvent Event;
+        DueEvents.HeapPop(Event, FEventRunsBefore(), false);
+        LastFrameMaxLateness = FMath::Max(LastFrameMaxLateness, static_cast<float>(Now - Event.DueTime));
+
+        RunEvent(Event);
+        ++Processed;
+
+        if (IsOverFrameBudget(StartCycles)) break;
+    }
+    EventsProcessedLastFrame = Processed;
+
+    if (bUseHeatEngine)
+    {
+        StepHeatField(DeltaTime);
+    }
+
+    UpdateLod(DeltaTime);
+    IgniteQueuedObjects();
+
+    BacklogDepth = DueEvents.Num();
+    MaxBacklogDepth = FMath::Max(MaxBacklogDepth, BacklogDepth);
+    MaxEventLateness = FMath::Max(MaxEventLateness, LastFrameMaxLateness);
+
+    SET_DWORD_STAT(STAT_FireEventsProcessed, EventsProcessedLastFrame);
+    SET_DWORD_STAT(STAT_FireEventBacklog, BacklogDepth);
+    SET_FLOAT_STAT(STAT_FireEventLateness, LastFrameMaxLateness);
+
+    HistoryAccumulator += DeltaTime;
+    if (HistoryAccumulator >= CVarFireHistoryInterval.GetValueOnGameThread())
+    {
+        HistoryAccumulator = 0.0f;
+        CaptureHistory();
+    }
+
+    FlushTileVisuals(StartCycles);
+    ReplayWriter.Flush();
+}
+
+void UFireSpreadSubsystem::StepHeatField(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_FireHeatStep);
+
+    if (!HeatField.IsInitialised() || HeatLayoutVersion != LayoutVersion)
+    {
+        TArray<FFireHeatGrid, TInlineAllocator<8>> Grids;
+        for (AFirePatchField* Field : Fields)
+        {
+            // Sparse fields step over their neighbour lists
+            if (Field && !Field->IsSparse())
+            {
+                Grids.Add({ Field->FirstTileIndex, Field->Columns, Field->Rows });
+            }
+        }
+        HeatField.Init(Tiles, Grids);
+        HeatLayoutVersion = LayoutVersion;
+        HeatAccumulator = 0.0f;
+    }
+
+    // A long frame runs a few steps and lets the fire fall behind rather than spiral
+    const float StepSeconds = FMath::Clamp(CVarFireHeatStepSeconds.GetValueOnGameThread(), 0.01f, 0.5f);
+    HeatAccumulator = FMath::Min(HeatAccumulator + DeltaTime, StepSeconds * 8.0f);
+
+    while (HeatAccumulator >= StepSeconds)
+    {
+        HeatAccumulator -= StepSeconds;
+        HeatField.Step(StepSeconds);
+
+        // Lighting syncs the tile back into the field before the next step
+        HeatField.FindIgnitions(HeatIgnitions);
+        for (int32 Tile : HeatIgnitions)
+        {
+            IgniteTile(Tile, EFireIgniteSource::Spread);
+        }
+    }
+}
+
+// Level of Detail
+float UFireSpreadSubsystem::GetLodBurnTolerance() const
+{
+    return FMath::Max(CVarFireLodBurnTolerance.GetValueOnGameThread(), 0.0f);
+}
+
+void UFireSpreadSubsystem::RefineCoarseCells(float HoldSeconds)
+{
+    LodHoldUntil = FMath::Max(LodHoldUntil, GetFireTime() + HoldSeconds);
+    if (Lod.GetCoarseCells().Num() == 0) return;
+
+    LodCells.Reset();
+    Lod.GetCoarseCells().GetKeys(LodCells);
+    for (int32 Cell : LodCells)
+    {
+        RefineLodCell(Cell);
+    }
+}
+
+void UFireSpreadSubsystem::RefineLodCell(int32 Cell)
+{
+    LodLitTiles.Reset();
+    Lod.Refine(Tiles, Cell, &LodLitTiles);
+
+    // Tiles the cell lit have not had their spread yet
+    for (int32 Tile : LodLitTiles)
+    {
+        ScheduleEvent(Tile, EFireEventType::Spread, FetchSpreadDelay(Tile));
+    }
+}
+
+bool UFireSpreadSubsystem::IgniteCoarseTile(int32 TileIndex)
+{
+    const int32 Cell = Lod.FindCell(TileIndex);
+    FFireLodCell* Coarse = Lod.FindCoarseCell(Cell);
+    if (!Coarse || !FFireLod::AddIgnition(*Coarse)) return false;
+
+    ApplyLodCell(Cell);
+    return true;
+}
+
+void UFireSpreadSubsystem::ApplyLodCell(int32 Cell)
+{
+    const FFireLodCell* Coarse = Lod.FindCoarseCell(Cell);
+    if (!Coarse) return;
+
+    for (int32 Rank = 0; Rank < Coarse->Order.Num(); ++Rank)
+    {
+        const int32 Tile = Coarse->Order[Rank];
+        const EFireTileVisual Visual = Coarse->GetRankVisual(Rank);
+        if (Tiles.GetVisual(Tile) != Visual)
+        {
+            SetTileVisual(Tile, Visual);
+            OnTileStateChanged(Tile);
+            if (Visual == EFireTileVisual::Burning) QueueObjectIgnitions(Tile);
+        }
+    }
+
+    if (Coarse->GetNumBurning() == 0)
+    {
+        RefineLodCell(Cell);
+    }
+}
+
+void UFireSpreadSubsystem::UpdateLod(float DeltaTime)
+{
+    const float LodDistance = CVarFireLodDistance.GetValueOnGameThread();
+
+    TArray<FVector, TInlineAllocator<4>> PlayerLocations;
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        const APlayerController* Controller = It->Get();
+        if (const APawn* Pawn = Controller ? Controller->GetPawn() : nullptr)
+        {
+            PlayerLocations.Add(Pawn->GetActorLocation());
+        }
+    }
+
+    // Recordings need every tile's transitions and the heat field every tile's temperature
+    if (LodDistance <= 0.0f || PlayerLocations.Num() == 0 || ReplayWriter.IsOpen() || bUseHeatEngine || GetFireTime() < LodHoldUntil)
+    {
+        RefineCoarseCells();
+        return;
+    }
+
+    const float StepSeconds = FMath::Max(CVarFireLodStepSeconds.GetValueOnGameThread(), 0.1f);
+    LodAccumulator += DeltaTime;
+    if (LodAccumulator < StepSeconds) return;
+
+    const float Seconds = LodAccumulator;
+    LodAccumulator = 0.0f;
+
+    SCOPE_CYCLE_COUNTER(STAT_FireLodStep);
+
+    // Cells only cover the dense fields
+    if (LodLayoutVersion != LayoutVersion)
+    {
+        RefineCoarseCells();
+
+        TArray<FFireHeatGrid, TInlineAllocator<8>> Grids;
+        for (AFirePatchField* Field : Fields)
+        {
+            if (Field && !Field->IsSparse())
+            {
+                Grids.Add({ Field->FirstTileIndex, Field->Columns, Field->Rows });
+            }
+        }
+        Lod.SetGrids(Tiles, Grids);
+        LodLayoutVersion = LayoutVersion;
+    }
+
+    auto GetNearestPlayerDistSquared = [&PlayerLocations](const FVector3f& Location)
+        {
+            double Nearest = MAX_dbl;
+            for (const FVector& Player : PlayerLocations)
+            {
+                Nearest = FMath::Min(Nearest, FVector::DistSquared(Player, FVector(Location)));
+            }
+            return Nearest;
+        };
+
+    // Coarse cells a player came near refine, the rest step and reach past their edges like a burning tile would
+    LodCells.Reset();
+    Lod.GetCoarseCells().GetKeys(LodCells);
+    const float RefineDistance = LodDistance * 0.75f;
+    for (int32 Cell : LodCells)
+    {
+        FFireLodCell* Coarse = Lod.FindCoarseCell(Cell);
+        if (!Coarse) continue;
+
+        if (GetNearestPlayerDistSquared(Coarse->Centre) < FMath::Square(RefineDistance))
+        {
+            RefineLodCell(Cell);
+            continue;
+        }
+
+        FFireLod::StepCell(*Coarse, Seconds);
+
+        const float EdgeChance = FMath::Min(3.0f * Seconds / (8.0f * Coarse->SpreadDelay), 1.0f);
+        TArray<int32, TInlineAllocator<16>> EdgeIgnitions;
+        for (int32 Rank = Coarse->GetNumBurnt(); Rank < Coarse->GetNumLit(); ++Rank)
+        {
+            for (int32 Neighbour : Tiles.Neighbours[Coarse->Order[Rank]])
+            {
+                if (Tiles.CanSpreadInto(Neighbour) && Lod.FindCell(Neighbour) != Cell && FireRandom.FRand() < EdgeChance)
+                {
+                    EdgeIgnitions.AddUnique(Neighbour);
+                }
+            }
+        }
+
+        // Lighting a neighbour can touch other coarse cells, so the cell is looked up again after
+        for (int32 Neighbour : EdgeIgnitions)
+        {
+            IgniteTile(Neighbour, EFireIgniteSource::Spread);
+        }
+        ApplyLodCell(Cell);
+    }
+
+    // Burning field tiles far from every player take their cell coarse
+    for (int32 Slot = 0; Slot < BurningTiles.Num(); ++Slot)
+    {
+        const int32 Tile = BurningTiles[Slot];
+        if (Tiles.HasFlag(Tile, EFireTileFlags::Coarse) || GetNearestPlayerDistSquared(Tiles.Locations[Tile]) < FMath::Square(LodDistance)) continue;
+
+        const int32 Cell = Lod.FindCell(Tile);
+        if (Cell != INDEX_NONE)
+        {
+            Lod.Coarsen(Tiles, Cell);
+        }
+    }
+
+    SET_DWORD_STAT(STAT_FireCoarseCells, Lod.GetCoarseCells().Num());
+}
+
+void UFireSpreadSubsystem::CollectDueEvents(double Now)
+{
+    if (EventQueue.Num() == 0 || EventQueue.HeapTop().DueTime > Now) return;
+
+    // Events near the player camera are run first, one further away may wait up to fire.MaxEventDelay longer.
+    // The camera is read as the event comes due, so the backlog heap never has to be re-sorted
+    FVector CameraLocation = FVector::ZeroVector;
+    bool bHasCamera = false;
+    if (APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0))
+    {
+        CameraLocation = CameraManager->GetCameraLocation();
+        bHasCamera = true;
+    }
+
+    const double MaxDelay = FMath::Max(CVarFireMaxEventDelay.GetValueOnGameThread(), 0.0f);
+    const double PriorityDistance = FMath::Max(CVarFireEventPriorityDistance.GetValueOnGameThread(), 1.0f);
+
+    while (EventQueue.Num() > 0 && EventQueue.HeapTop().DueTime <= Now)
+    {
+        FFireEvent Event;
+        EventQueue.HeapPop(Event, FEventDueBefore(), false);
+
+        // Priority is the time the event should have run by, so an event that has waited its delay out goes ahead of anything newer
+        const double Distance = bHasCamera ? FVector::Dist(FVector(Tiles.Locations[Event.TileIndex]), CameraLocation) : 0.0;
+        Event.Priority = Event.DueTime + MaxDelay * FMath::Min(Distance / PriorityDistance, 1.0);
+        DueEvents.HeapPush(Event, FEventRunsBefore());
+    }
+}
+
+void UFireSpreadSubsystem::RunEvent(const FFireEvent& Event)
+{
+    switch (Event.Type)
+    {
+    case EFireEventType::Spread:
+        SpreadFromTile(Event.TileIndex);
+        break;
+    case EFireEventType::BurnOut:
+        BurnOutTile(Event.TileIndex);
+        break;
+    default:
+        break;
+    }
+}
+
+// History
+void UFireSpreadSubsystem::CaptureHistory()
+{
+    if (CVarFireHistorySeconds.GetValueOnGameThread() <= 0.0f || Tiles.Num() == 0) return;
+
+    if (ChunkVersions.Num() < Tiles.NumChunks())
+    {
+        ChunkVersions.SetNumZeroed(Tiles.NumChunks());
+    }
+
+    GetQueuedEvents(HistoryEvents);
+    History.Capture(GetFireTime(), Tiles, ChunkVersions, HistoryEvents, FireRandom.GetCurrentSeed());
+
+    HistoryBytes = History.GetAllocatedBytes();
+    SET_MEMORY_STAT(STAT_FireHistoryMemory, HistoryBytes);
+}
+
+float UFireSpreadSubsystem::GetHistoryFrameTime(int32 FrameIndex) const
+{
+    return History.IsValidIndex(FrameIndex) ? static_cast<float>(History.GetFrame(FrameIndex).Time) : 0.0f;
+}
+
+bool UFireSpreadSubsystem::ScrubHistory(int32 FrameIndex)
+{
+    if (!History.IsValidIndex(FrameIndex) || !HasSimulationAuthority() || bReplaying) return false;
+
+    const FFireHistoryFrame& Frame = History.GetFrame(FrameIndex);
+    if (Frame.Chunks.Num() != Tiles.NumChunks()) return false;
+
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    // Chunks the live tiles already share with the frame are skipped, so a short scrub only touches what burned in between
+    int32 ChunksApplied = 0;
+    for (int32 Chunk = 0; Chunk < Frame.Chunks.Num(); ++Chunk)
+    {
+        if (History.IsChunkCurrent(Chunk, Frame, GetChunkVersion(Chunk))) continue;
+
+        const TArray<uint8>& States = Frame.Chunks[Chunk]->States;
+        const int32 First = Chunk << FireTileChunkShift;
+        for (int32 i = 0; i < States.Num(); ++i)
+        {
+            ApplyPackedTileState(First + i, States[i]);
+        }
+        ++ChunksApplied;
+    }
+
+    EventQueue.Reset();
+    DueEvents.Reset();
+    for (const FFireHistoryEvent& Event : Frame.Events)
+    {
+        RestoreQueuedEvent(Event.TileIndex, Event.Type, Event.Remaining);
+    }
+    BacklogDepth = 0;
+
+    FireRandom.Initialize(Frame.RandomSeed);
+    HeatField.Reset();
+    Lod.ClearCells(Tiles);
+
+    History.MarkRestored(FrameIndex, ChunkVersions);
+    HistoryFrameIndex = FrameIndex;
+    HistoryPauseTime = GetFireTime();
+
+    UE_LOG(LogTemp, Display, TEXT("Fire history at %.1f s: %d of %d chunks applied in %.2f ms"),
+        Frame.Time, ChunksApplied, Frame.Chunks.Num(), FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+    return true;
+}
+
+bool UFireSpreadSubsystem::RewindHistory(float Seconds)
+{
+    if (History.Num() == 0) return false;
+
+    const int32 FromIndex = IsScrubbingHistory() ? HistoryFrameIndex : History.Num() - 1;
+    const double TargetTime = History.GetFrame(FromIndex).Time - Seconds;
+
+    int32 BestIndex = 0;
+    for (int32 Index = 1; Index < History.Num(); ++Index)
+    {
+        if (FMath::Abs(History.GetFrame(Index).Time - TargetTime) < FMath::Abs(History.GetFrame(BestIndex).Time - TargetTime))
+        {
+            BestIndex = Index;
+        }
+    }
+    return ScrubHistory(BestIndex);
+}
+
+void UFireSpreadSubsystem::ResumeFromHistory()
+{
+    if (!IsScrubbingHistory()) return;
+
+    History.TruncateAfter(HistoryFrameIndex);
+
+    // Queued events were timed from when the scrub paused the fire
+    const double Offset = GetFireTime() - HistoryPauseTime;
+    for (FFireEvent& Event : EventQueue)
+    {
+        Event.DueTime += Offset;
+    }
+
+    HistoryFrameIndex = INDEX_NONE;
+    HistoryAccumulator = 0.0f;
+    HistoryBytes = History.GetAllocatedBytes();
+}
+
+// Replication
+bool UFireSpreadSubsystem::HasSimulationAuthority() const
+{
+    return GetWorld()->GetNetMode() != NM_Client;
+}
+
+void UFireSpreadSubsystem::ApplyReplicatedTileVisual(int32 TileIndex, EFireTileVisual Visual)
+{
+    if (!Tiles.IsValidIndex(TileIndex) || Tiles.GetVisual(TileIndex) == Visual) return;
+
+    SetTileVisual(TileIndex, Visual);
+    if (Visual == EFireTileVisual::Dug)
+    {
+        Tiles.BurnTypes[TileIndex] = ESurfaceBurnType::Dug;
+    }
+    OnTileStateChanged(TileIndex);
+}
+
+// Replay
+bool UFireSpreadSubsystem::StartRecording(const FString& Name)
+{
+    if (bReplaying) return false;
+
+    // The log has to hold every tile's own transitions
+    RefineCoarseCells();
+
+    TArray<uint8> Snapshot;
+    SaveSnapshot(Snapshot);
+
+    const FString FilePath = GetReplayPath(Name);
+    if (!ReplayWriter.Open(FilePath, Snapshot, GetFireTime()))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Could not open fire replay %s for writing"), *FilePath);
+        return false;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("Recording fire replay to %s"), *FilePath);
+    return true;
+}
+
+void UFireSpreadSubsystem::StopRecording()
+{
+    if (!ReplayWriter.IsOpen()) return;
+
+    UE_LOG(LogTemp, Display, TEXT("Fire replay recording stopped after %lld records"), ReplayWriter.GetNumRecords());
+    ReplayWriter.Close();
+}
+
+bool UFireSpreadSubsystem::PlayReplay(const FString& Name, float Speed)
+{
+    if (bReplaying) return false;
+    if (bUseHeatEngine)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Fire replays are checked against spread events and cannot play with the heat engine"));
+        return false;
+    }
+    StopRecording();
+
+    const FString FilePath = GetReplayPath(Name);
+    if (!ReplayReader.Open(FilePath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Could not read fire replay %s"), *FilePath);
+        return false;
+    }
+
+    // Events restored from the snapshot are queued on the replay clock, which starts at zero
+    bReplaying = true;
+    ReplayTime = 0.0;
+    ReplayPlayhead = 0.0;
+    ReplaySpeed = Speed;
+    ReplayRecordsChecked = 0;
+    ReplayMismatches = 0;
+    ReplayStartCycles = FPlatformTime::Cycles64();
+
+    if (!RestoreSnapshot(ReplayReader.GetSnapshot()))
+    {
+        bReplaying = false;
+        ReplayReader.Close();
+        return false;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("Playing fire replay %s at speed %.2f"), *FilePath, Speed);
+
+    if (Speed <= 0.0f)
+    {
+        // Headless, tile visuals queue up and are applied once at the end
+        FFireEventRecord Record;
+        while (ReplayReader.Next(Record))
+        {
+            StepReplay(Record);
+        }
+        FinishReplay();
+        FlushTileVisuals();
+    }
+    return true;
+}
+
+void UFireSpreadSubsystem::StepReplay(const FFireEventRecord& Record)
+{
+    ++ReplayRecordsChecked;
+
+    // Fuel burns on the replay clock, burn outs only happen when the log has them
+    ConsumeFuel(static_cast<float>(Record.Time - ReplayTime), nullptr);
+    ReplayTime = Record.Time;
+
+    if (!Tiles.IsValidIndex(Record.TileIndex))
+    {
+        ReportReplayMismatch(Record, TEXT("tile does not exist"));
+        return;
+    }
+
+    switch (Record.Type)
+    {
+    case EFireEventType::Ignite:
+        // Spread ignites are results, they are matched right after the spread that made them
+        if (Record.Source == EFireIgniteSource::Spread)
+        {
+            ReportReplayMismatch(Record, TEXT("recorded spread ignite with no spread before it"));
+        }
+        else if (!IgniteTile(Record.TileIndex, Record.Source))
+        {
+            ReportReplayMismatch(Record, TEXT("tile could not be ignited"));
+        }
+        break;
+
+    case EFireEventType::Dig:
+        if (!DigTile(Record.TileIndex))
+        {
+            ReportReplayMismatch(Record, TEXT("tile could not be dug"));
+        }
+        break;
+
+    case EFireEventType::BurnOut:
+        // The live fire burnt the tile out on the first frame its fuel was gone, allow for float drift over the frames
+        if (!Tiles.IsBurning(Record.TileIndex) || GetTileFuel(Record.TileIndex) > Tiles.BurnRates[Record.TileIndex] * 0.01f)
+        {
+            ReportReplayMismatch(Record, TEXT("burn out was not due"));
+        }
+        if (Tiles.IsBurning(Record.TileIndex))
+        {
+            BurnOutTile(Record.TileIndex);
+        }
+        break;
+
+    case EFireEventType::Spread:
+    {
+        if (!ConsumeQueuedEvent(Record.TileIndex, EFireEventType::Spread, Record.Time))
+        {
+            ReportReplayMismatch(Record, TEXT("spread was not due"));
+        }
+
+        ReplaySpreadIgnites.Reset();
+        SpreadFromTile(Record.TileIndex);
+
+        // The log holds the spread's ignites straight after it, in the order they were picked
+        int32 Matched = 0;
+        FFireEventRecord Ignite;
+        while (ReplayReader.Peek(Ignite) && Ignite.Type == EFireEventType::Ignite && Ignite.Source == EFireIgniteSource::Spread)
+        {
+            ReplayReader.Next(Ignite);
+            ++ReplayRecordsChecked;
+
+            if (!ReplaySpreadIgnites.IsValidIndex(Matched) || ReplaySpreadIgnites[Matched] != Ignite.TileIndex)
+            {
+                ReportReplayMismatch(Ignite, TEXT("spread ignited a different tile"));
+            }
+            ++Matched;
+        }
+        if (Matched < ReplaySpreadIgnites.Num())
+        {
+            ReportReplayMismatch(Record, TEXT("spread ignited more tiles than recorded"));
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+bool UFireSpreadSubsystem::ConsumeQueuedEvent(int32 TileIndex, EFireEventType Type, double Time)
+{
+    // Record times are rounded to the millisecond
+    constexpr double Tolerance = 0.002;
+
+    for (int32 i = 0; i < EventQueue.Num(); ++i)
+    {
+        const FFireEvent& Event = EventQueue[i];
+        if (Event.TileIndex == TileIndex && Event.Type == Type && Event.DueTime <= Time + Tolerance)
+        {
+            EventQueue.HeapRemoveAt(i, FEventDueBefore(), false);
+            return true;
+        }
+    }
+    return false;
+}
+
+void UFireSpreadSubsystem::ReportReplayMismatch(const FFireEventRecord& Record, const TCHAR* Reason)
+{
+    // Everything after the first mismatch tends to follow from it, so only the first few are logged
+    if (++ReplayMismatches <= 20)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Fire replay mismatch at %.3f s: %s on %s, %s"),
+            Record.Time, *UEnum::GetValueAsString(Record.Type), *DescribeTile(Record.TileIndex), Reason);
+    }
+}
+
+void UFireSpreadSubsystem::FinishReplay()
+{
+    // Put whatever is still queued back on the world clock so the fire carries on from here
+    const double Offset = GetWorld()->GetTimeSeconds() - ReplayTime;
+    for (FFireEvent& Event : EventQueue)
+    {
+        Event.DueTime += Offset;
+    }
+
+    const double ElapsedMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - ReplayStartCycles);
+    UE_LOG(LogTemp, Display, TEXT("Fire replay finished: %d records checked, %d mismatches, %.1f s of fire in %.1f ms"),
+        ReplayRecordsChecked, ReplayMismatches, ReplayTime, ElapsedMs);
+
+    bReplaying = false;
+    ReplayReader.Close();
+}
+
+// Garbage Collection Counters
+void UFireSpreadSubsystem::OnPreGarbageCollect()
+{
+    GCStartCycles = FPlatformTime::Cycles64();
+}
+
+void UFireSpreadSubsystem::OnPostReachabilityAnalysis()
+{
+    if (GCStartCycles == 0) return;
+
+    LastGCMarkMs = static_cast<float>(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - GCStartCycles));
+    MaxGCMarkMs = FMath::Max(MaxGCMarkMs, LastGCMarkMs);
+    SET_FLOAT_STAT(STAT_FireGCMarkMs, LastGCMarkMs);
+}
+
+void UFireSpreadSubsystem::OnPostGarbageCollect()
+{
+    if (GCStartCycles == 0) return;
+
+    LastGCTotalMs = static_cast<float>(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - GCStartCycles));
+    GCStartCycles = 0;
+
+    UE_LOG(LogTemp, Verbose, TEXT("Garbage collection with %d fire tiles: mark %.2f ms, total %.2f ms (max mark %.2f ms)"),
+        Tiles.Num(), LastGCMarkMs, LastGCTotalMs, MaxGCMarkMs);
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireSteadyStateAllocationsTest, "BrightSparks.Fire.SteadyStateAllocations",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+/*
+    Warms the fire loop up on a burn lit at the centre and every corner of a field, then resets the
+    field and lights a different burn with a new seed off centre, and counts the heap allocations
+    the game thread makes inside each of its ticks. The fire is ticked directly with the world clock
+    moved by hand, so only the fire's own tick is counted.
+*/
+bool FFireSteadyStateAllocationsTest::RunTest(const FString& Parameters)
+{
+    constexpr float TickSeconds = 0.5f;
+    constexpr int32 WarmUpTicks = 1200;
+    constexpr int32 CheckTicks = 600;
+
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    UFireSpreadSubsystem* FireSubsystem = World->GetSubsystem<UFireSpreadSubsystem>();
+    AFirePatchField* Field = World->SpawnActor<AFirePatchField>();
+    if (TestNotNull(TEXT("Fire subsystem"), FireSubsystem) && TestNotNull(TEXT("Patch field"), Field))
+    {
+        // The world never begins play, so the field is registered as its BeginPlay would
+        Field->FirstTileIndex = FireSubsystem->RegisterField(Field);
+
+        const int32 Columns = Field->Columns;
+        const int32 Rows = Field->Rows;
+        auto LightAt = [&](int32 X, int32 Y)
+        {
+            return FireSubsystem->IgniteTile(Field->GetTileIndex(Y * Columns + X));
+        };
+        auto TickFire = [&](int32 NumTicks)
+        {
+            for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+            {
+                World->TimeSeconds += TickSeconds;
+                FireSubsystem->Tick(TickSeconds);
+            }
+        };
+
+        // Five fronts at once grow every buffer further than the single burn checked after
+        LightAt(Columns / 2, Rows / 2);
+        LightAt(0, 0);
+        LightAt(Columns - 1, 0);
+        LightAt(0, Rows - 1);
+        LightAt(Columns - 1, Rows - 1);
+        TickFire(WarmUpTicks);
+
+        TestTrue(TEXT("Field resets"), FireSubsystem->ResetToAuthoredState());
+        TestTrue(TEXT("Checked burn lights"), LightAt(Columns / 4, Rows / 3));
+
+        FireSubsystem->StartAllocCheck(0, CheckTicks);
+        TickFire(CheckTicks);
+
+        TestFalse(TEXT("Check finished"), FireSubsystem->IsAllocCheckRunning());
+        TestEqual(TEXT("Heap allocations in the checked ticks"), FireSubsystem->GetAllocCheckAllocations(), 0);
+    }
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+    return true;
+}
+
+#endif
@@ -0,0 +1,629 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FireHeatField.h"
+#include "FireHistory.h"
+#include "FireHitchWatchdog.h"
+#include "FireLod.h"
+#include "FirePathfinding.h"
+#include "FireReplay.h"
+#include "FireSpreadWeights.h"
+#include "FireStateSnapshot.h"
+#include "FireTileTable.h"
+#include "FireSpreadSubsystem.generated.h"
+
+class AFirePatchField;
+class UFireGroundCollisionComponent;
+class AAudioManager;
+class ABasicObject;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFireTilesChanged, const TArray<int32>&, TileIndices);
+
+DECLARE_STATS_GROUP(TEXT("FireSpread"), STATGROUP_FireSpread, STATCAT_Advanced);
+
+// A timed tile transition waiting to be run by the fire subsystem
+struct FFireEvent
+{
+	int32 TileIndex = INDEX_NONE;
+	EFireEventType Type = EFireEventType::Spread;
+
+	// World time the event was scheduled for
+	double DueTime = 0.0;
+
+	// Time the event should have run by, lower runs first. Only valid while the event is in the backlog
+	double Priority = 0.0;
+};
+
+/*
+	Owns every fire tile in the world and runs the fire simulation on them.
+	Tiles come from AFireSpreadPatch actors or AFirePatchField instances and are addressed by
+	tile index, the patch actors mirror their tile's state for Blueprints and other readers.
+	Spread / burn out events are held in a single queue instead of one FTimerManager entry per
+	patch, and the due ones are processed under a per frame time budget so a large ignition
+	cannot hitch.
+*/
+UCLASS()
+class BRIGHTSPARKSPROJECT_API UFireSpreadSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Tile Registration
+	// Forgets every tile, queued event and history frame, for when the level holding the tiles goes away
+	void ResetTiles();
+
+	// Adds the patch to the tile table if needed and copies its authored settings, returns its tile index
+	int32 RegisterPatch(AFireSpreadPatch* Patch);
+
+	// Adds these patches to the tile's neighbours, they are registered too if needed. Registering a patch
+	// already links it with the patches around it, this is for neighbours set up by hand
+	void SetTileNeighbours(int32 TileIndex, TArrayView<AFireSpreadPatch* const> NeighbourPatches);
+
+	// Adds every tile of the field as one block, returns the first tile index
+	int32 RegisterField(AFirePatchField* Field);
+
+	// Keeps the object's authored fire state so a retry can put it back, and binds it to the tiles under it
+	void RegisterObject(ABasicObject* Object);
+
+	// Object Binding
+	// Finds the tiles under the object's footprint again, lighting the new ones if it burns. Objects call it when they move
+	void BindObject(ABasicObject* Object);
+
+	// Lights every tile under the object, for when it catches fire
+	void IgniteObjectGround(ABasicObject* Object);
+
+	// Tiles under the object as last bound, empty for objects that are not registered
+	TArrayView<const int32> GetObjectTiles(const ABasicObject* Object) const;
+
+	/*
+		Puts every tile and registered object back to the state it was registered with, for retrying
+		the level without loading it again. Queued events, history, the replay and the burning
+		effects are cleared and the visuals are applied before this returns.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	bool ResetToAuthoredState();
+
+	const FFireTileTable& GetTiles() const { return Tiles; }
+
+	// Bumped whenever tiles are added or their authored settings or neighbours change, not by burn state
+	uint32 GetLayoutVersion() const { return LayoutVersion; }
+	int32 GetNumTiles() const { return Tiles.Num(); }
+
+	// Neighbour weights spread picks from, brought up to the current layout first. Copy them to
+	// play the fire elsewhere with the same picks, see FFireSpreadWeights::BuildStale
+	const FFireSpreadWeights& GetSpreadWeights();
+
+	// Fuel a burning tile needs left to spread at full intensity, fire.Fuel.FullIntensity
+	float GetFullIntensityFuel() const;
+
+	// Patch actor of the tile, null for field tiles
+	AFireSpreadPatch* GetPatch(int32 TileIndex) const;
+
+	// Tile indices of the tile's neighbours, empty for an invalid tile
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	TArray<int32> GetTileNeighbours(int32 TileIndex) const;
+
+	// Every tile currently burning, in no particular order
+	const TArray<int32>& GetBurningTiles() const { return BurningTiles; }
+
+	// The fire as of the last visual batch. Take it on the game thread, the reference can then be read anywhere
+	FFireStateSnapshotRef GetStateSnapshot() const { return StateSnapshots.GetFront(); }
+
+	// Totals from the state snapshot for HUD widgets, BurnPercent is 0 to 1
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	void GetFireCounts(int32& NumBurning, int32& NumBurnt, int32& NumDug, float& BurnPercent) const;
+
+	AFirePatchField* GetFieldForTile(int32 TileIndex) const;
+
+	// Tile index of a patch actor or field instance hit by a trace, INDEX_NONE otherwise
+	int32 GetTileIndexFromHit(const FHitResult& Hit);
+
+	// Tile whose collision box holds the location, INDEX_NONE if there is none
+	int32 FindTileAt(const FVector& Location) const;
+
+	// Builds the shared ground collision again if tiles were added since, for callers about to trace the ground
+	void FlushGroundCollision();
+
+	// Patch name or field and instance, for logging
+	FString DescribeTile(int32 TileIndex) const;
+
+	// Tile Transitions
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	bool IgniteTile(int32 TileIndex, EFireIgniteSource Source = EFireIgniteSource::Script);
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	void SpreadFromTile(int32 TileIndex);
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	void BurnOutTile(int32 TileIndex);
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	bool DigTile(int32 TileIndex);
+
+	float FetchSpreadDelay(int32 TileIndex) const;
+
+	// Seconds before the object sets another alight, from the fire's own stream so replays and restored snapshots match
+	float FetchObjectSpreadDelay(const ABasicObject& Object) const;
+
+	// Fuel left on the tile, its full load until it lights and 0 once burnt
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	float GetTileFuel(int32 TileIndex) const;
+
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	bool IsTileBurning(int32 TileIndex) const;
+
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	bool IsTileBurnt(int32 TileIndex) const;
+
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	bool IsTileDug(int32 TileIndex) const;
+
+	// Bulk Tools
+	/*
+		Digs or lights every eligible tile of the list in one pass, for fire lines and backburns laid
+		by scripts and crews. Spread events are queued together and the visuals, audio and Blueprint
+		notification go out as one batch before this returns. Returns the number of tiles changed
+	*/
+	int32 ApplyTool(EFireToolOp Op, TArrayView<const int32> TileIndices, EFireIgniteSource Source = EFireIgniteSource::Script);
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	int32 ApplyToolToTiles(EFireToolOp Op, const TArray<int32>& TileIndices, EFireIgniteSource Source = EFireIgniteSource::Script);
+
+	// Every tile whose box overlaps the world space rectangle, at any height
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	int32 ApplyToolInRect(EFireToolOp Op, FVector2D Min, FVector2D Max, EFireIgniteSource Source = EFireIgniteSource::Script);
+
+	// Every tile within HalfWidth of the path through the points, at any height
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	int32 ApplyToolAlongPath(EFireToolOp Op, const TArray<FVector>& Points, float HalfWidth = 80.0f, EFireIgniteSource Source = EFireIgniteSource::Script);
+
+	// The tiles ApplyToolInRect and ApplyToolAlongPath use, sorted and without repeats
+	void FindTilesInRect(const FVector2D& Min, const FVector2D& Max, TArray<int32>& OutTiles) const;
+	void FindTilesAlongPath(TArrayView<const FVector> Points, float HalfWidth, TArray<int32>& OutTiles) const;
+
+	// Pathfinding
+	/*
+		Walking path for a crew between two tiles of the same dense field, around burning tiles and
+		preferring burnt and dug ground. Pending while it is searched on worker threads, ask again on a
+		later frame. Paths are cached until a tile in a region they cross changes state
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	EFirePathStatus FindWalkingPath(int32 StartTile, int32 GoalTile, TArray<int32>& OutTiles);
+
+	int32 GetNumCachedPaths() const { return Pathfinder.GetNumCachedPaths(); }
+
+	// Broadcast once per frame with every tile whose visual state changed, sorted by tile index
+	UPROPERTY(BlueprintAssignable, Category = "Fire Simulation")
+	FOnFireTilesChanged OnTilesVisualChanged;
+
+	// Event Queue
+	// Queues an event for the tile to run after the delay (in world seconds)
+	void ScheduleEvent(int32 TileIndex, EFireEventType Type, float Delay);
+
+	// Number of events still waiting in the queue, due or not
+	int32 GetNumPendingEvents() const { return EventQueue.Num() + DueEvents.Num(); }
+
+	// Copies up to MaxEvents of the queued spread events, soonest first, returns how many are queued in total
+	int32 GetPendingSpreadEvents(TArray<FFireEventRecord>& OutEvents, int32 MaxEvents) const;
+
+	// Every queued event with the time it still has to wait, for simulations run from the current state
+	void GetQueuedEvents(TArray<FFireHistoryEvent>& OutEvents) const;
+
+	// Spread Weights
+	// Level wind in world XY, its length is the strength, see FFireSpreadWeightParams
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	void SetWind(FVector2D Wind);
+
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	FVector2D GetWind() const { return FVector2D(WindVector); }
+
+	// Heat Engine
+	// True when fire.SpreadEngine picked the heat field over spread events for this world
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	bool IsUsingHeatEngine() const { return bUseHeatEngine; }
+
+	// Relative to the air, 1 lights a quick tile, 0 without the heat engine
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	float GetTileTemperature(int32 TileIndex) const { return HeatField.GetTemperature(TileIndex); }
+
+	// Level of Detail
+	// Number of 4 by 4 field cells burning as a whole far from the players, see FFireLod
+	UFUNCTION(BlueprintPure, Category = "Fire Simulation")
+	int32 GetNumCoarseCells() const { return Lod.GetCoarseCells().Num(); }
+
+	/*
+		Hands every coarse cell back to the per tile fire, for when an exact answer matters. No cell
+		goes coarse again for HoldSeconds. Cells holding special tiles are never coarse to begin with.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	void RefineCoarseCells(float HoldSeconds = 0.0f);
+
+	// Burn share either side of a game over threshold within which the coarse cells should be refined
+	float GetLodBurnTolerance() const;
+
+	// Walks the tile table and counts the tiles currently burning and burnt
+	void CountTileStates(int32& OutBurning, int32& OutBurnt) const;
+
+	// Tiles burning right now, the length of the fire front rather than a walk over the table
+	int32 GetNumBurningTiles() const { return BurningTiles.Num(); }
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Simulation")
+	void ResetEventCounters();
+
+	/*
+		Counts the heap allocations the game thread makes inside the fire's tick for Frames ticks after
+		WarmUpFrames, and logs pass or fail. A burn in its steady state should make none, see fire.AllocCheck
+	*/
+	void StartAllocCheck(int32 WarmUpFrames, int32 Frames);
+
+	// Whether a check is still counting, and the heap allocations its ticks have made so far
+	bool IsAllocCheckRunning() const { return AllocCheckFramesLeft > 0; }
+	int32 GetAllocCheckAllocations() const { return AllocCheckAllocations; }
+
+	// Snapshots
+	/*
+		Bit packed, versioned copy of the fire state: 5 bits per tile for visual state and burn type,
+		then every queued event as a tile delta, a type bit and the milliseconds left on it, then
+		the fire random stream. Restoring needs the same level loaded, the tile count and a hash
+		of the tile locations are checked instead of rerunning neighbour discovery.
+	*/
+	void SaveSnapshot(TArray<uint8>& OutData) const;
+
+	// Returns false and leaves the fire untouched if the data is not a snapshot of this level
+	bool RestoreSnapshot(const TArray<uint8>& Data);
+
+	// The snapshot's state on a copy of the tile table and its queued events, for headless sims. The fire is not touched
+	bool ReadSnapshot(const TArray<uint8>& Data, FFireTileTable& OutTiles, TArray<FFireHistoryEvent>& OutEvents) const;
+
+	// Hash of the tile count and locations, so state is only restored or replicated onto the level it came from
+	uint32 ComputeLayoutHash() const;
+
+	// History
+	// Frames of the last fire.History.Seconds kept for scrubbing, 0 is the oldest
+	UFUNCTION(BlueprintPure, Category = "Fire History")
+	int32 GetNumHistoryFrames() const { return History.Num(); }
+
+	UFUNCTION(BlueprintPure, Category = "Fire History")
+	float GetHistoryFrameTime(int32 FrameIndex) const;
+
+	// Pauses the fire and sets every tile, queued event and the random stream back to the frame
+	UFUNCTION(BlueprintCallable, Category = "Fire History")
+	bool ScrubHistory(int32 FrameIndex);
+
+	// Scrubs by Seconds from the current frame, backwards when positive and forwards when negative
+	UFUNCTION(BlueprintCallable, Category = "Fire History")
+	bool RewindHistory(float Seconds);
+
+	// Carries on from the scrubbed frame, the frames after it are dropped
+	UFUNCTION(BlueprintCallable, Category = "Fire History")
+	void ResumeFromHistory();
+
+	UFUNCTION(BlueprintPure, Category = "Fire History")
+	bool IsScrubbingHistory() const { return HistoryFrameIndex != INDEX_NONE; }
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire History")
+	int64 HistoryBytes = 0;
+
+	// Replication
+	// False on network clients, they show the state the server replicates and run no fire of their own
+	bool HasSimulationAuthority() const;
+
+	// Client side, sets the tile to a state received from the server and queues its visuals
+	void ApplyReplicatedTileVisual(int32 TileIndex, EFireTileVisual Visual);
+
+	// Bumped every time a tile in the chunk changes state, see FireTileChunkSize
+	uint32 GetChunkVersion(int32 Chunk) const { return ChunkVersions.IsValidIndex(Chunk) ? ChunkVersions[Chunk] : 0; }
+
+	// Replay
+	// Snapshots the fire, then appends every transition to Saved/FireReplays/<Name>.frep until stopped
+	UFUNCTION(BlueprintCallable, Category = "Fire Replay")
+	bool StartRecording(const FString& Name);
+
+	UFUNCTION(BlueprintCallable, Category = "Fire Replay")
+	void StopRecording();
+
+	/*
+		Restores the recording's starting snapshot and plays it back, running every spread and
+		burn out through the simulation and checking the result against the log. Torch, object
+		and dig records are fed in as inputs. Speed scales playback, 0 or less runs the whole log
+		inside this call with no effects or audio until it finishes.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Fire Replay")
+	bool PlayReplay(const FString& Name, float Speed = 1.0f);
+
+	UFUNCTION(BlueprintPure, Category = "Fire Replay")
+	bool IsReplaying() const { return bReplaying; }
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Replay")
+	int32 ReplayRecordsChecked = 0;
+
+	// Records the playback did not reproduce, nonzero means the simulation behaves differently
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Replay")
+	int32 ReplayMismatches = 0;
+
+	// Budget Counters
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Simulation")
+	int32 BacklogDepth = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Simulation")
+	int32 MaxBacklogDepth = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Simulation")
+	int32 EventsProcessedLastFrame = 0;
+
+	// Seconds between an event coming due and it being run
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Simulation")
+	float LastFrameMaxLateness = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Simulation")
+	float MaxEventLateness = 0.0f;
+
+	// Garbage Collection Counters
+	// Time from the start of a collection to the end of reachability analysis, for the whole engine
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Simulation")
+	float LastGCMarkMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Simulation")
+	float MaxGCMarkMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Fire Simulation")
+	float LastGCTotalMs = 0.0f;
+
+private:
+	// Moves what came due into the backlog heap, keyed on how close to the camera it is
+	void CollectDueEvents(double Now);
+	void RunEvent(const FFireEvent& Event);
+	void RecordFireEvent(int32 TileIndex, EFireEventType Type, EFireIgniteSource Source = EFireIgniteSource::Script);
+
+	// World time, or the replay clock while a replay is playing
+	double GetFireTime() const;
+
+	void StepReplay(const FFireEventRecord& Record);
+	void FinishReplay();
+	void ReportReplayMismatch(const FFireEventRecord& Record, const TCHAR* Reason);
+
+	// Removes the tile's queued event of that type if it was due by Time
+	bool ConsumeQueuedEvent(int32 TileIndex, EFireEventType Type, double Time);
+
+	// Sets the burning / burnt / dug flags to match a visual state, without queueing visuals
+	void SetTileVisual(int32 TileIndex, EFireTileVisual Visual);
+
+	// Applies a visual state and burn type packed as snapshots and history store them, queueing visuals if it changed
+	void ApplyPackedTileState(int32 TileIndex, uint8 PackedState);
+	uint8 GetPackedTileState(int32 TileIndex) const;
+
+	void CaptureHistory();
+
+	// Lays the weight tables out again after the layout changed, picks up finished builds and starts new ones
+	void UpdateSpreadWeights();
+
+	// Runs the heat field's fixed steps for the frame and acts on the tiles that crossed a threshold
+	void StepHeatField(float DeltaTime);
+
+	// Sets the burning flag and keeps BurningTiles in step with it, a tile that lights gets its full fuel load
+	void SetTileBurning(int32 TileIndex, bool bBurning);
+
+	// Fills OutTiles with every registered tile whose collision box overlaps the box
+	template <typename AllocatorType>
+	void FindTilesUnder(const FBox& Footprint, TArray<int32, AllocatorType>& OutTiles) const;
+
+	// Binds every object again once the tile layout moved, fields can register after the objects on them
+	void UpdateObjectBindings();
+
+	// Objects over the tile catch fire at the end of the tick, after their own spread delay
+	void QueueObjectIgnitions(int32 TileIndex);
+	void IgniteQueuedObjects();
+
+	// Builds the path grids again once the layout moved, then takes in and launches path searches
+	void UpdatePathfinding();
+
+	// Links the patch both ways with every registered patch its 80 unit sphere reaches or whose sphere
+	// reaches it, the same pairs the sphere overlap search in the patch's BeginPlay used to find.
+	// Leaves the layout version to RegisterPatch, which already moved it for the new tile
+	void LinkPatchNeighbours(int32 TileIndex);
+
+	// Takes far burning cells coarse, refines the ones a player came near and steps the rest
+	void UpdateLod(float DeltaTime);
+
+	void RefineLodCell(int32 Cell);
+
+	// Writes the coarse cell's shares back to its tiles, refining it once nothing in it burns
+	void ApplyLodCell(int32 Cell);
+
+	// Lights a tile of the coarse cell holding the tile rather than the tile itself
+	bool IgniteCoarseTile(int32 TileIndex);
+
+	// Burns Seconds worth of fuel off every burning tile, OutBurntOut gets the tiles that ran out
+	void ConsumeFuel(float Seconds, TArray<int32>* OutBurntOut);
+
+	// Queues a restored spread event, or sets a burning tile's fuel from a restored burn out time
+	void RestoreQueuedEvent(int32 TileIndex, EFireEventType Type, float Remaining);
+
+	// Reads and checks a whole snapshot, packed tile states and events with their time left, without applying any of it
+	bool DecodeSnapshot(const TArray<uint8>& Data, TArray<uint8>& OutStates, TArray<FFireHistoryEvent>& OutEvents, int32& OutSeed) const;
+
+	void OnPreGarbageCollect();
+	void OnPostReachabilityAnalysis();
+	void OnPostGarbageCollect();
+
+	// Copies the tile's state back onto its patch actor and queues the tile for the visual batch
+	void OnTileStateChanged(int32 TileIndex);
+
+	/*
+		Applies the queued tiles' visuals: field custom data, patch effects, one audio refresh and one broadcast.
+		Given the cycle count its frame budget started at, stops once fire.FrameBudgetUs is spent and keeps the
+		rest for the next flush. 0 applies every queued tile.
+	*/
+	void FlushTileVisuals(uint64 BudgetStartCycles = 0);
+
+	// Whether fire.FrameBudgetUs has gone by since StartCycles
+	bool IsOverFrameBudget(uint64 StartCycles) const;
+
+	// The owning tile table
+	FFireTileTable Tiles;
+
+	// Patch actor per tile, null for field tiles. This is the only object reference the
+	// simulation keeps per tile, everything else refers to tiles by index
+	UPROPERTY()
+	TArray<AFireSpreadPatch*> Patches;
+
+	// Change counter per tile chunk
+	TArray<uint32> ChunkVersions;
+
+	// Packed state of each tile as it was registered, what ResetToAuthoredState restores
+	TArray<uint8> AuthoredStates;
+
+	// Objects and whether each was on fire when registered
+	UPROPERTY()
+	TArray<ABasicObject*> Objects;
+	TBitArray<> AuthoredObjectsOnFire;
+
+	// Binding table between objects and the ground: tiles under each object by object slot, and object
+	// slots over each tile that has any. Built when objects register and again when the layout moves
+	TArray<TArray<int32, TInlineAllocator<4>>> ObjectTiles;
+	TMap<int32, TArray<int32, TInlineAllocator<2>>> TileObjects;
+	uint32 ObjectBindingLayoutVersion = 0;
+	TArray<int32> PendingObjectIgnitions;
+
+	uint32 LayoutVersion = 0;
+
+	// Tiles with the burning flag, and each tile's slot in it (INDEX_NONE when not burning)
+	TArray<int32> BurningTiles;
+	TArray<int32> BurningSlots;
+
+	// Fuel left and burn rate of each burning tile, by slot so a frame's burning is one pass over packed floats
+	TArray<float> BurningFuel;
+	TArray<float> BurningRates;
+	TArray<int32> FuelBurnOuts;
+
+	// Fields in order of their first tile index
+	UPROPERTY()
+	TArray<AFirePatchField*> Fields;
+
+	// Patch tiles by the cell of PatchCellSize their centre is in, for neighbour links and FindTileAt
+	TMultiMap<FIntPoint, int32> PatchCells;
+	float MaxPatchReach = 0.0f;
+
+	// One query only body for every patch and field tile, built again when the layout version moves
+	UPROPERTY()
+	AActor* GroundCollisionActor = nullptr;
+
+	UPROPERTY()
+	UFireGroundCollisionComponent* GroundCollision = nullptr;
+	uint32 GroundCollisionLayoutVersion = 0;
+
+	// Published by FlushTileVisuals whenever a tile changed state or the layout moved
+	FFireStateSnapshotBuffer StateSnapshots;
+
+	// Walking costs of the dense field tiles, kept in step by OnTileStateChanged
+	FFirePathfinder Pathfinder;
+	uint32 PathLayoutVersion = 0;
+
+	// Min heap on DueTime of events that have not come due yet
+	TArray<FFireEvent> EventQueue;
+
+	// Min heap on Priority of events that are due but have not been run yet, carried across frames
+	TArray<FFireEvent> DueEvents;
+
+	// While a bulk tool operation runs, ScheduleEvent collects here and the queue takes them in one go
+	TArray<FFireEvent> BatchedEvents;
+	bool bBatchingEvents = false;
+
+	// Tiles the rect and path tools work on, kept between calls
+	TArray<int32> ToolTiles;
+
+	// Coarse lit tiles gathered by GetQueuedEvents and SaveSnapshot, scratch for those const queries
+	mutable TArray<int32> QueryLitTiles;
+
+	// Every random choice of the fire goes through this so snapshots can carry it
+	FRandomStream FireRandom;
+
+	// Weighted neighbour picks for SpreadFromTile
+	FFireSpreadWeights SpreadWeights;
+	TFuture<FFireSpreadWeightBuild> PendingWeightBuild;
+	uint32 SpreadWeightsLayoutVersion = 0;
+
+	// The tile list of the last build, handed back when it lands so the next one reuses it
+	TArray<int32> WeightBuildTiles;
+	bool bWeightBuildWanted = false;
+	FVector2f WindVector = FVector2f::ZeroVector;
+
+	// Heat engine, laid out again whenever the layout version moves or the fire state is replaced
+	FFireHeatField HeatField;
+	bool bUseHeatEngine = false;
+	uint32 HeatLayoutVersion = 0;
+	float HeatAccumulator = 0.0f;
+	TArray<int32> HeatIgnitions;
+
+	// Coarse cells, laid over the dense fields again whenever the layout version moves
+	FFireLod Lod;
+	uint32 LodLayoutVersion = 0;
+	float LodAccumulator = 0.0f;
+	double LodHoldUntil = 0.0;
+	TArray<int32> LodCells;
+	TArray<int32> LodLitTiles;
+
+	// Tiles whose state changed this frame, their visuals are applied together at the end of the tick
+	TArray<int32> DirtyTiles;
+	TArray<EFireTileVisual> DirtyVisuals;
+
+	// The first NumCarriedTiles of DirtyTiles were held back by the last flush's budget
+	int32 NumCarriedTiles = 0;
+	TArray<int32> CarriedTiles;
+
+	UPROPERTY()
+	AAudioManager* AudioManager = nullptr;
+
+	// Dumps the fire state to disk when a frame goes over the hitch threshold
+	FFireHitchWatchdog HitchWatchdog;
+
+	// Everything Tick does past the hitch watchdog, so a running StartAllocCheck can count it
+	void TickFire(float DeltaTime);
+
+	// Takes in one tick's count of game thread heap allocations for StartAllocCheck
+	void CheckLoopAllocations(int32 NumAllocations);
+
+	int32 AllocCheckWarmUp = 0;
+	int32 AllocCheckFramesLeft = 0;
+	int32 AllocCheckFrames = 0;
+	int32 AllocCheckTicksAllocating = 0;
+	int32 AllocCheckAllocations = 0;
+
+	FFireHistory History;
+
+	// Queued events of the frame being captured, reused between captures
+	TArray<FFireHistoryEvent> HistoryEvents;
+
+	// Frame being shown while scrubbing, INDEX_NONE while the fire runs
+	int32 HistoryFrameIndex = INDEX_NONE;
+	float HistoryAccumulator = 0.0f;
+	double HistoryPauseTime = 0.0;
+
+	FFireReplayWriter ReplayWriter;
+	FFireReplayReader ReplayReader;
+	bool bReplaying = false;
+	float ReplaySpeed = 1.0f;
+
+	// Log time played so far, and the time of the record being replayed which the fire runs on
+	double ReplayPlayhead = 0.0;
+	double ReplayTime = 0.0;
+	uint64 ReplayStartCycles = 0;
+
+	// Tiles ignited by the spread being replayed, compared with the ignites that follow it in the log
+	TArray<int32> ReplaySpreadIgnites;
+
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostReachabilityHandle;
+	FDelegateHandle PostGCHandle;
+	uint64 GCStartCycles = 0;
+};
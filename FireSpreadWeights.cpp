@@ -0,0 +1,268 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireSpreadWeights.h"
+#include "Async/Async.h"
+
+namespace
+{
+    // Draws that land on a neighbour that is taken or cannot burn are redrawn this many times
+    // before picking straight from the remaining weights
+    constexpr int32 MaxAliasDraws = 4;
+}
+
+float FFireSpreadWeightParams::ComputeWeight(const FVector3f& From, const FVector3f& To) const
+{
+    const FVector2f Run(To.X - From.X, To.Y - From.Y);
+    const float Distance = Run.Size();
+    if (Distance <= KINDA_SMALL_NUMBER) return 1.0f;
+
+    // Downwind edges gain and upwind edges lose by the wind along them
+    const float WindScale = FMath::Max(1.0f + FVector2f::DotProduct(Run / Distance, Wind), MinWeight);
+
+    const float Slope = FMath::Clamp((To.Z - From.Z) / Distance, -1.0f, 1.0f);
+    return FMath::Max(WindScale * FMath::Exp(SlopeInfluence * Slope), MinWeight);
+}
+
+FFireSpreadEdges::FFireSpreadEdges(const FFireTileTable& Tiles)
+{
+    EdgeStarts.Reserve(Tiles.Num() + 1);
+    Targets.Reserve(Tiles.Num() * 8);
+    Locations = Tiles.Locations;
+
+    for (int32 Tile = 0; Tile < Tiles.Num(); ++Tile)
+    {
+        EdgeStarts.Add(Targets.Num());
+        const int32 NumEdges = FMath::Min(Tiles.Neighbours[Tile].Num(), FFireSpreadWeights::MaxWeightedNeighbours);
+        Targets.Append(Tiles.Neighbours[Tile].GetData(), NumEdges);
+    }
+    EdgeStarts.Add(Targets.Num());
+}
+
+void FFireSpreadWeights::Init(const FFireTileTable& Tiles)
+{
+    Edges = MakeShared<const FFireSpreadEdges>(Tiles);
+
+    const int32 NumEdges = Edges->Targets.Num();
+    Weights.SetNumUninitialized(NumEdges);
+    Probabilities.SetNumUninitialized(NumEdges);
+    Aliases.SetNumUninitialized(NumEdges);
+    TileVersions.SetNumZeroed(Tiles.Num());
+    ++Version;
+}
+
+void FFireSpreadWeights::Reset()
+{
+    Edges.Reset();
+    TileVersions.Empty();
+    Weights.Empty();
+    Probabilities.Empty();
+    Aliases.Empty();
+    ++Version;
+}
+
+bool FFireSpreadWeights::SetParams(const FFireSpreadWeightParams& InParams)
+{
+    if (Params == InParams) return false;
+
+    Params = InParams;
+    ++Version;
+    return true;
+}
+
+void FFireSpreadWeights::ComputeTile(const FFireSpreadEdges& InEdges, const FFireSpreadWeightParams& InParams, int32 Tile,
+    float* OutWeights, float* OutProbabilities, uint8* OutAliases)
+{
+    const int32 Start = InEdges.EdgeStarts[Tile];
+    const int32 NumEdges = InEdges.NumEdges(Tile);
+    if (NumEdges == 0) return;
+
+    const FVector3f& From = InEdges.Locations[Tile];
+    float Total = 0.0f;
+    for (int32 Slot = 0; Slot < NumEdges; ++Slot)
+    {
+        OutWeights[Slot] = InParams.ComputeWeight(From, InEdges.Locations[InEdges.Targets[Start + Slot]]);
+        Total += OutWeights[Slot];
+    }
+
+    // Vose's alias method: every slot keeps its own share of a 1 / NumEdges column and the
+    // rest of the column goes to a slot that is over its share
+    TArray<float, TInlineAllocator<MaxWeightedNeighbours>> Scaled;
+    TArray<int32, TInlineAllocator<MaxWeightedNeighbours>> Small;
+    TArray<int32, TInlineAllocator<MaxWeightedNeighbours>> Large;
+    Scaled.SetNumUninitialized(NumEdges);
+    for (int32 Slot = 0; Slot < NumEdges; ++Slot)
+    {
+        Scaled[Slot] = OutWeights[Slot] * NumEdges / Total;
+        (Scaled[Slot] < 1.0f ? Small : Large).Add(Slot);
+    }
+
+    while (Small.Num() > 0 && Large.Num() > 0)
+    {
+        const int32 Under = Small.Pop(false);
+        const int32 Over = Large.Pop(false);
+        OutProbabilities[Under] = Scaled[Under];
+        OutAliases[Under] = static_cast<uint8>(Over);
+
+        Scaled[Over] -= 1.0f - Scaled[Under];
+        (Scaled[Over] < 1.0f ? Small : Large).Add(Over);
+    }
+
+    // Whatever is left is a full column up to rounding
+    for (int32 Slot : Small)
+    {
+        OutProbabilities[Slot] = 1.0f;
+        OutAliases[Slot] = static_cast<uint8>(Slot);
+    }
+    for (int32 Slot : Large)
+    {
+        OutProbabilities[Slot] = 1.0f;
+        OutAliases[Slot] = static_cast<uint8>(Slot);
+    }
+}
+
+void FFireSpreadWeights::BuildTile(int32 Tile)
+{
+    const int32 Start = Edges->EdgeStarts[Tile];
+    ComputeTile(*Edges, Params, Tile, Weights.GetData() + Start, Probabilities.GetData() + Start, Aliases.GetData() + Start);
+    TileVersions[Tile] = Version;
+}
+
+TFuture<FFireSpreadWeightBuild> FFireSpreadWeights::LaunchBuild(TArray<int32>&& TilesToBuild) const
+{
+    return Async(EAsyncExecution::ThreadPool, [InEdges = Edges, InParams = Params, InVersion = Version, TilesToBuild = MoveTemp(TilesToBuild)]() mutable
+        {
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+
+            FFireSpreadWeightBuild Build;
+            Build.Version = InVersion;
+
+            int32 NumEntries = 0;
+            for (int32 Tile : TilesToBuild)
+            {
+                NumEntries += InEdges->NumEdges(Tile);
+            }
+            Build.Weights.SetNumUninitialized(NumEntries);
+            Build.Probabilities.SetNumUninitialized(NumEntries);
+            Build.Aliases.SetNumUninitialized(NumEntries);
+
+            int32 Entry = 0;
+            for (int32 Tile : TilesToBuild)
+            {
+                ComputeTile(*InEdges, InParams, Tile, Build.Weights.GetData() + Entry, Build.Probabilities.GetData() + Entry, Build.Aliases.GetData() + Entry);
+                Entry += InEdges->NumEdges(Tile);
+            }
+
+            Build.Tiles = MoveTemp(TilesToBuild);
+            Build.BuildMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+            return Build;
+        });
+}
+
+int32 FFireSpreadWeights::ApplyBuild(const FFireSpreadWeightBuild& Build)
+{
+    // Anything that made the tables stale after the build started also made the build stale
+    if (Build.Version != Version || !Edges.IsValid()) return 0;
+
+    int32 NumApplied = 0;
+    int32 Entry = 0;
+    for (int32 Tile : Build.Tiles)
+    {
+        const int32 Start = Edges->EdgeStarts[Tile];
+        const int32 NumEdges = Edges->NumEdges(Tile);
+        if (TileVersions[Tile] != Version)
+        {
+            FMemory::Memcpy(Weights.GetData() + Start, Build.Weights.GetData() + Entry, NumEdges * sizeof(float));
+            FMemory::Memcpy(Probabilities.GetData() + Start, Build.Probabilities.GetData() + Entry, NumEdges * sizeof(float));
+            FMemory::Memcpy(Aliases.GetData() + Start, Build.Aliases.GetData() + Entry, NumEdges * sizeof(uint8));
+            TileVersions[Tile] = Version;
+            ++NumApplied;
+        }
+        Entry += NumEdges;
+    }
+    return NumApplied;
+}
+
+void FFireSpreadWeights::BuildStale()
+{
+    if (!Edges.IsValid()) return;
+
+    for (int32 Tile = 0; Tile < TileVersions.Num(); ++Tile)
+    {
+        if (TileVersions[Tile] != Version)
+        {
+            BuildTile(Tile);
+        }
+    }
+}
+
+void FFireSpreadWeights::PickNeighbours(const FFireTileTable& Tiles, int32 Tile, int32 MaxPicks, FRandomStream& Random, TArray<int32, TInlineAllocator<8>>& OutPicks)
+{
+    if (TileVersions[Tile] != Version && Edges->NumEdges(Tile) > 0)
+    {
+        BuildTile(Tile);
+    }
+
+    PickBuiltNeighbours(Tile, MaxPicks, Random, [&Tiles](int32 Target) { return Tiles.CanSpreadInto(Target); }, OutPicks);
+}
+
+void FFireSpreadWeights::PickBuiltNeighbours(int32 Tile, int32 MaxPicks, FRandomStream& Random, TFunctionRef<bool(int32)> CanSpreadInto,
+    TArray<int32, TInlineAllocator<8>>& OutPicks) const
+{
+    OutPicks.Reset();
+
+    const int32 Start = Edges->EdgeStarts[Tile];
+    const int32 NumEdges = Edges->NumEdges(Tile);
+    if (NumEdges == 0) return;
+
+    checkSlow(TileVersions[Tile] == Version);
+
+    // Slots of the neighbours fire can spread into, taken ones are cleared as they are picked
+    uint64 OpenSlots = 0;
+    int32 NumOpen = 0;
+    for (int32 Slot = 0; Slot < NumEdges; ++Slot)
+    {
+        if (CanSpreadInto(Edges->Targets[Start + Slot]))
+        {
+            OpenSlots |= 1ull << Slot;
+            ++NumOpen;
+        }
+    }
+
+    const int32 NumPicks = FMath::Min(MaxPicks, NumOpen);
+    for (int32 Pick = 0; Pick < NumPicks; ++Pick)
+    {
+        int32 Picked = INDEX_NONE;
+        for (int32 Draw = 0; Draw < MaxAliasDraws && Picked == INDEX_NONE; ++Draw)
+        {
+            const int32 Column = Random.RandHelper(NumEdges);
+            const int32 Slot = Random.GetFraction() < Probabilities[Start + Column] ? Column : Aliases[Start + Column];
+            if (OpenSlots & (1ull << Slot))
+            {
+                Picked = Slot;
+            }
+        }
+
+        // Most of the neighbours are gone, pick from the weights of the ones left
+        if (Picked == INDEX_NONE)
+        {
+            float Total = 0.0f;
+            for (int32 Slot = 0; Slot < NumEdges; ++Slot)
+            {
+                if (OpenSlots & (1ull << Slot)) Total += Weights[Start + Slot];
+            }
+
+            float Target = Random.GetFraction() * Total;
+            for (int32 Slot = 0; Slot < NumEdges; ++Slot)
+            {
+                if (!(OpenSlots & (1ull << Slot))) continue;
+
+                Picked = Slot;
+                Target -= Weights[Start + Slot];
+                if (Target < 0.0f) break;
+            }
+        }
+
+        OpenSlots &= ~(1ull << Picked);
+        OutPicks.Add(Edges->Targets[Start + Picked]);
+    }
+}
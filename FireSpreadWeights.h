@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Templates/Function.h"
+#include "FireTileTable.h"
+
+// What the spread weight of an edge is worked out from
+struct FFireSpreadWeightParams
+{
+	// Level wind in world XY, its length is the strength. At 1 a neighbour straight downwind is
+	// twice as likely as one across the wind and one straight upwind only gets MinWeight
+	FVector2f Wind = FVector2f::ZeroVector;
+
+	// Fire climbs, an edge's weight is scaled by exp(SlopeInfluence * rise / run)
+	float SlopeInfluence = 2.0f;
+
+	// Floor so no neighbour ever becomes unreachable
+	float MinWeight = 0.05f;
+
+	float ComputeWeight(const FVector3f& From, const FVector3f& To) const;
+
+	bool operator==(const FFireSpreadWeightParams& Other) const
+	{
+		return Wind == Other.Wind && SlopeInfluence == Other.SlopeInfluence && MinWeight == Other.MinWeight;
+	}
+};
+
+// The tile table's neighbour lists flattened into one array, shared read only with the rebuild jobs
+struct FFireSpreadEdges
+{
+	explicit FFireSpreadEdges(const FFireTileTable& Tiles);
+
+	int32 NumEdges(int32 Tile) const { return EdgeStarts[Tile + 1] - EdgeStarts[Tile]; }
+
+	// A tile's edges are [EdgeStarts[Tile], EdgeStarts[Tile + 1])
+	TArray<int32> EdgeStarts;
+	TArray<int32> Targets;
+	TArray<FVector3f> Locations;
+};
+
+// Tables of some of the tiles, worked out on a worker thread
+struct FFireSpreadWeightBuild
+{
+	uint32 Version = 0;
+	TArray<int32> Tiles;
+
+	// Entries of each tile in Tiles, back to back in the same order
+	TArray<float> Weights;
+	TArray<float> Probabilities;
+	TArray<uint8> Aliases;
+
+	float BuildMs = 0.0f;
+};
+
+/*
+	Spread weight per neighbour edge and an alias method table per tile, so a burning tile picks
+	the neighbours it spreads into with wind and slope bias for two random draws a pick, the same
+	work as a uniform pick. Tables only depend on the locations and the params, so when the params
+	change the tables are marked stale and rebuilt on a worker for the tiles that can still spread,
+	and any stale table that is needed before the build lands is worked out on the spot. Both give
+	the same entries, so what the fire does never depends on when a build finished.
+*/
+class BRIGHTSPARKSPROJECT_API FFireSpreadWeights
+{
+public:
+	// Neighbours past this many are never picked, a patch finds 8 at most
+	static constexpr int32 MaxWeightedNeighbours = 64;
+
+	// A tile at full intensity spreads into this many neighbours
+	static constexpr int32 MaxSpreadPicks = 3;
+
+	// Neighbours a tile with this much fuel left spreads into, fewer as it runs low but never none
+	static int32 GetMaxPicks(float Fuel, float FullIntensityFuel)
+	{
+		return FMath::Clamp(FMath::CeilToInt(MaxSpreadPicks * Fuel / FMath::Max(FullIntensityFuel, KINDA_SMALL_NUMBER)), 1, MaxSpreadPicks);
+	}
+
+	// Lays the tables out for the table's neighbour lists, every table starts stale
+	void Init(const FFireTileTable& Tiles);
+	void Reset();
+	bool IsInitialised() const { return Edges.IsValid(); }
+
+	// Moves whenever the tables go stale, so a copy can tell it is out of date
+	uint32 GetVersion() const { return Version; }
+
+	// Marks every table stale when the params differ, returns true if they did
+	bool SetParams(const FFireSpreadWeightParams& InParams);
+	const FFireSpreadWeightParams& GetParams() const { return Params; }
+
+	// Starts working out the listed tiles' tables on the thread pool
+	TFuture<FFireSpreadWeightBuild> LaunchBuild(TArray<int32>&& TilesToBuild) const;
+
+	// Copies in the tables of a finished build that are still stale, returns how many
+	int32 ApplyBuild(const FFireSpreadWeightBuild& Build);
+
+	// Works out every stale table on the spot, after which a copy only needs reading and can be shared between threads
+	void BuildStale();
+
+	// Picks up to MaxPicks different neighbours fire can spread into, weighted, in pick order
+	void PickNeighbours(const FFireTileTable& Tiles, int32 Tile, int32 MaxPicks, FRandomStream& Random, TArray<int32, TInlineAllocator<8>>& OutPicks);
+
+	// The same draws from a tile whose table is current, for simulations that keep their own tile states
+	void PickBuiltNeighbours(int32 Tile, int32 MaxPicks, FRandomStream& Random, TFunctionRef<bool(int32)> CanSpreadInto,
+		TArray<int32, TInlineAllocator<8>>& OutPicks) const;
+
+private:
+	// Writes the tile's weights and alias table, NumEdges entries each
+	static void ComputeTile(const FFireSpreadEdges& InEdges, const FFireSpreadWeightParams& InParams, int32 Tile,
+		float* OutWeights, float* OutProbabilities, uint8* OutAliases);
+
+	void BuildTile(int32 Tile);
+
+	TSharedPtr<const FFireSpreadEdges> Edges;
+	FFireSpreadWeightParams Params;
+
+	// Bumped by every change that makes the tables stale, a tile's table is current when its version matches
+	uint32 Version = 1;
+	TArray<uint32> TileVersions;
+
+	// Per edge, laid out as FFireSpreadEdges
+	TArray<float> Weights;
+	TArray<float> Probabilities;
+	TArray<uint8> Aliases;
+};
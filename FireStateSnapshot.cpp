@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireStateSnapshot.h"
+
+int32 FFireStateSnapshot::CountBurningNear(const FVector3f& Location, float Radius) const
+{
+    const float RadiusSquared = Radius * Radius;
+    int32 Count = 0;
+    for (const FVector3f& BurningLocation : BurningLocations)
+    {
+        Count += FVector3f::DistSquared(BurningLocation, Location) < RadiusSquared;
+    }
+    return Count;
+}
+
+void FFireStateSnapshot::Build(const FFireTileTable& Tiles, TArrayView<const int32> InBurningTiles)
+{
+    const int32 NumTiles = Tiles.Num();
+    Flags.SetNumUninitialized(NumTiles, false);
+
+    Counters = FFireStateCounters();
+    Counters.NumTiles = NumTiles;
+
+    // One pass copies the flags and counts them
+    for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+    {
+        const EFireTileFlags TileFlags = Tiles.Flags[Tile] & ~EFireTileFlags::VisualDirty;
+        Flags[Tile] = TileFlags;
+
+        const bool bLost = EnumHasAnyFlags(TileFlags, EFireTileFlags::Burning | EFireTileFlags::Burnt);
+        Counters.NumBurning += EnumHasAnyFlags(TileFlags, EFireTileFlags::Burning);
+        Counters.NumBurnt += EnumHasAnyFlags(TileFlags, EFireTileFlags::Burnt);
+        Counters.NumDug += EnumHasAnyFlags(TileFlags, EFireTileFlags::Dug);
+
+        if (Tiles.IsBurnableType(Tile))
+        {
+            ++Counters.NumBurnable;
+            Counters.NumBurnableLost += bLost;
+        }
+        if (EnumHasAnyFlags(TileFlags, EFireTileFlags::Special))
+        {
+            ++Counters.NumSpecial;
+            Counters.NumSpecialLost += bLost;
+        }
+    }
+
+    BurningTiles.Reset(InBurningTiles.Num());
+    BurningTiles.Append(InBurningTiles.GetData(), InBurningTiles.Num());
+
+    BurningLocations.Reset(InBurningTiles.Num());
+    for (int32 Tile : InBurningTiles)
+    {
+        BurningLocations.Add(Tiles.Locations[Tile]);
+    }
+}
+
+FFireStateSnapshotBuffer::FFireStateSnapshotBuffer()
+    : Front(MakeShared<FFireStateSnapshot, ESPMode::ThreadSafe>())
+    , Back(MakeShared<FFireStateSnapshot, ESPMode::ThreadSafe>())
+{
+}
+
+void FFireStateSnapshotBuffer::Publish(const FFireTileTable& Tiles, TArrayView<const int32> BurningTiles, double FireTime, uint32 LayoutVersion)
+{
+    // Only the game thread hands out references, so a back buffer nobody else holds stays that way
+    if (!Back.IsUnique())
+    {
+        Back = MakeShared<FFireStateSnapshot, ESPMode::ThreadSafe>();
+        ++NumAllocations;
+    }
+
+    Back->Build(Tiles, BurningTiles);
+    Back->Step = NextStep++;
+    Back->FireTime = FireTime;
+    Back->LayoutVersion = LayoutVersion;
+
+    Swap(Front, Back);
+}
+
+void FFireStateSnapshotBuffer::Reset()
+{
+    Publish(FFireTileTable(), TArrayView<const int32>(), 0.0, 0);
+}
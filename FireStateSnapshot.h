@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireTileTable.h"
+
+// Tile totals of one snapshot
+struct FFireStateCounters
+{
+	int32 NumTiles = 0;
+	int32 NumBurning = 0;
+	int32 NumBurnt = 0;
+	int32 NumDug = 0;
+
+	// Tiles of a burnable type, and how many of those are burning or burnt, what the burn percent counts
+	int32 NumBurnable = 0;
+	int32 NumBurnableLost = 0;
+
+	int32 NumSpecial = 0;
+	int32 NumSpecialLost = 0;
+
+	// Fraction of the burnable tiles lost, 0 when there are none
+	float GetBurnPercent() const { return NumBurnable > 0 ? NumBurnableLost / static_cast<float>(NumBurnable) : 0.0f; }
+};
+
+/*
+	The fire as of one published step, see UFireSpreadSubsystem::GetStateSnapshot. Nothing changes
+	a snapshot once it is published, so whoever holds a reference can read it on any thread without
+	locks while the simulation carries on.
+*/
+struct BRIGHTSPARKSPROJECT_API FFireStateSnapshot
+{
+	// Moves by one with each published snapshot
+	uint64 Step = 0;
+	double FireTime = 0.0;
+	uint32 LayoutVersion = 0;
+
+	// Every tile's state flags by tile index, without the visual dirty bit
+	TArray<EFireTileFlags> Flags;
+
+	// The fire front, burning tiles and their locations in the same order
+	TArray<int32> BurningTiles;
+	TArray<FVector3f> BurningLocations;
+
+	FFireStateCounters Counters;
+
+	bool HasFlag(int32 Tile, EFireTileFlags Flag) const { return Flags.IsValidIndex(Tile) && EnumHasAnyFlags(Flags[Tile], Flag); }
+
+	// Burning tiles within Radius of the location
+	int32 CountBurningNear(const FVector3f& Location, float Radius) const;
+
+	// Copies the table's state over whatever this held, keeping the allocations
+	void Build(const FFireTileTable& Tiles, TArrayView<const int32> InBurningTiles);
+};
+
+using FFireStateSnapshotRef = TSharedRef<const FFireStateSnapshot, ESPMode::ThreadSafe>;
+
+/*
+	Front and back snapshot. Publish fills the back one and swaps it to the front, the old front is
+	written in place next time unless a reader still holds it, then a new one is made for it.
+	Published and handed out on the game thread only, readers pass the reference to other threads.
+*/
+class BRIGHTSPARKSPROJECT_API FFireStateSnapshotBuffer
+{
+public:
+	FFireStateSnapshotBuffer();
+
+	FFireStateSnapshotRef GetFront() const { return Front; }
+
+	void Publish(const FFireTileTable& Tiles, TArrayView<const int32> BurningTiles, double FireTime, uint32 LayoutVersion);
+
+	// Publishes an empty snapshot
+	void Reset();
+
+	// Snapshots made because a reader still held the back one
+	int32 GetNumAllocations() const { return NumAllocations; }
+
+private:
+	TSharedRef<FFireStateSnapshot, ESPMode::ThreadSafe> Front;
+	TSharedRef<FFireStateSnapshot, ESPMode::ThreadSafe> Back;
+	uint64 NextStep = 1;
+	int32 NumAllocations = 0;
+};
@@ -0,0 +1,412 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FireSweep.h"
+#include "FireReplay.h"
+#include "FireSpreadSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <Kismet/GameplayStatics.h>
+
+namespace
+{
+    FString GetSweepDir()
+    {
+        return FPaths::ProjectSavedDir() / TEXT("FireSweeps");
+    }
+
+    const TCHAR* GetEndName(EFireSimEnd End)
+    {
+        switch (End)
+        {
+        case EFireSimEnd::Extinguished: return TEXT("extinguished");
+        case EFireSimEnd::OverBurn:     return TEXT("over_burn");
+        case EFireSimEnd::SpecialTiles: return TEXT("special_tiles");
+        default:                        return TEXT("timeout");
+        }
+    }
+
+    FString GetRankName(EGameRank Rank)
+    {
+        return StaticEnum<EGameRank>()->GetNameStringByValue(static_cast<int64>(Rank));
+    }
+
+    FString DescribeRanks(const FFireSimParams& Params)
+    {
+        FString Ranks;
+        for (int32 Rank = 0; Rank < UE_ARRAY_COUNT(Params.RankThresholds); ++Rank)
+        {
+            Ranks += FString::Printf(Rank == 0 ? TEXT("%g") : TEXT("/%g"), Params.RankThresholds[Rank]);
+        }
+        return Ranks;
+    }
+
+    bool ParseFloat(const FString& Text, float& OutValue)
+    {
+        if (!Text.IsNumeric()) return false;
+        OutValue = FCString::Atof(*Text);
+        return true;
+    }
+
+    // Value at the fraction of the way through already sorted values
+    float GetPercentile(const TArray<float>& Sorted, float Fraction)
+    {
+        if (Sorted.Num() == 0) return 0.0f;
+        return Sorted[FMath::Clamp(FMath::FloorToInt(Fraction * (Sorted.Num() - 1)), 0, Sorted.Num() - 1)];
+    }
+
+    float GetMean(const TArray<float>& Values)
+    {
+        if (Values.Num() == 0) return 0.0f;
+
+        double Sum = 0.0;
+        for (float Value : Values) Sum += Value;
+        return static_cast<float>(Sum / Values.Num());
+    }
+}
+
+static FAutoConsoleCommandWithWorldAndArgs FireSweepCommand(
+    TEXT("fire.Sweep"),
+    TEXT("fire.Sweep <Name> [Seeds=100|a,b,c] [Plan=<replay>.frep|<csv>] [Threshold=..] [Ranks=80/70/60/50/40/0,..] [QuickDelay=..] [SlowDelay=..] [BurnDuration=..]\n")
+    TEXT("Runs headless games of the loaded level for every parameter combination and seed on all cores, results go to Saved/FireSweeps/<Name>_*.csv.\n")
+    TEXT("A replay plan starts the games from the fire state its recording started from, the fire being played is left as it is."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            UFireSpreadSubsystem* FireSubsystem = World ? World->GetSubsystem<UFireSpreadSubsystem>() : nullptr;
+            if (!FireSubsystem || FireSubsystem->GetNumTiles() == 0)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("fire.Sweep: no fire tiles in this world"));
+                return;
+            }
+
+            const FString Name = Args.Num() > 0 ? Args[0] : TEXT("FireSweep");
+
+            // Tuning the level is played with now is the base every grid point changes
+            FFireSimParams Base;
+            Base.FullIntensityFuel = FireSubsystem->GetFullIntensityFuel();
+            if (AFireGameMode* GameMode = Cast<AFireGameMode>(UGameplayStatics::GetGameMode(World)))
+            {
+                Base.BurnedThresholdPercent = GameMode->BurnedThresholdPercent;
+                Base.CheckInterval = GameMode->GameOverCheckInterval;
+                for (int32 Rank = 0; Rank < UE_ARRAY_COUNT(Base.RankThresholds); ++Rank)
+                {
+                    Base.RankThresholds[Rank] = GameMode->GetThresholdForRank(static_cast<EGameRank>(Rank));
+                }
+            }
+
+            TArray<int32> Seeds;
+            TArray<FFireEventRecord> Plan;
+            TArray<uint8> PlanSnapshot;
+            TArray<FString> GridArgs;
+            for (int32 i = 1; i < Args.Num(); ++i)
+            {
+                FString Key, Value;
+                if (!Args[i].Split(TEXT("="), &Key, &Value))
+                {
+                    UE_LOG(LogTemp, Warning, TEXT("fire.Sweep: expected Key=Value, got %s"), *Args[i]);
+                    return;
+                }
+
+                if (Key.Equals(TEXT("Seeds"), ESearchCase::IgnoreCase))
+                {
+                    TArray<FString> Values;
+                    Value.ParseIntoArray(Values, TEXT(","));
+                    if (Values.Num() == 1)
+                    {
+                        // A single number is a count of seeds from 0
+                        for (int32 Seed = 0; Seed < FCString::Atoi(*Values[0]); ++Seed) Seeds.Add(Seed);
+                    }
+                    else
+                    {
+                        for (const FString& Seed : Values) Seeds.Add(FCString::Atoi(*Seed));
+                    }
+                }
+                else if (Key.Equals(TEXT("Plan"), ESearchCase::IgnoreCase))
+                {
+                    if (!FireSweep::LoadPlan(Value, Plan, PlanSnapshot))
+                    {
+                        UE_LOG(LogTemp, Warning, TEXT("fire.Sweep: could not load plan %s"), *Value);
+                        return;
+                    }
+                }
+                else
+                {
+                    GridArgs.Add(Args[i]);
+                }
+            }
+
+            if (Seeds.Num() == 0)
+            {
+                for (int32 Seed = 0; Seed < 100; ++Seed) Seeds.Add(Seed);
+            }
+
+            TArray<FFireSimParams> Grid;
+            FString Error;
+            if (!FireSweep::BuildGrid(GridArgs, Base, Grid, Error))
+            {
+                UE_LOG(LogTemp, Warning, TEXT("fire.Sweep: %s"), *Error);
+                return;
+            }
+
+            // A recorded plan starts from the fire state the recording did, read onto a copy so the game
+            // being played keeps its own fire
+            FFireTileTable StartTiles;
+            TArray<FFireHistoryEvent> StartEvents;
+            if (PlanSnapshot.Num() > 0)
+            {
+                if (!FireSubsystem->ReadSnapshot(PlanSnapshot, StartTiles, StartEvents))
+                {
+                    UE_LOG(LogTemp, Warning, TEXT("fire.Sweep: the plan's replay was recorded on a different level"));
+                    return;
+                }
+            }
+            else
+            {
+                FireSubsystem->GetQueuedEvents(StartEvents);
+            }
+            const FFireTileTable& SimTiles = PlanSnapshot.Num() > 0 ? StartTiles : FireSubsystem->GetTiles();
+
+            // Every table is built up front so the workers only read the weights
+            FFireSpreadWeights SpreadWeights = FireSubsystem->GetSpreadWeights();
+            SpreadWeights.BuildStale();
+
+            const double StartSeconds = FPlatformTime::Seconds();
+            TArray<FFireSimResult> Results;
+            FireSweep::Run(SimTiles, SpreadWeights, StartEvents, Grid, Seeds, Plan, Results);
+            const double Seconds = FMath::Max(FPlatformTime::Seconds() - StartSeconds, 1e-6);
+
+            UE_LOG(LogTemp, Display, TEXT("fire.Sweep: %d games (%d grid points x %d seeds, %d tiles, %d plan steps) in %.2f s, %.1f sims/sec"),
+                Results.Num(), Grid.Num(), Seeds.Num(), FireSubsystem->GetNumTiles(), Plan.Num(), Seconds, Results.Num() / Seconds);
+
+            FireSweep::WriteCsv(Name, Grid, Seeds, Results);
+        }));
+
+bool FireSweep::BuildGrid(const TArray<FString>& Args, const FFireSimParams& Base, TArray<FFireSimParams>& OutGrid, FString& OutError)
+{
+    OutGrid.Reset();
+    OutGrid.Add(Base);
+
+    for (const FString& Arg : Args)
+    {
+        FString Key, ValueList;
+        if (!Arg.Split(TEXT("="), &Key, &ValueList))
+        {
+            OutError = FString::Printf(TEXT("expected Key=Value, got %s"), *Arg);
+            return false;
+        }
+
+        TArray<FString> Values;
+        ValueList.ParseIntoArray(Values, TEXT(","));
+        if (Values.Num() == 0)
+        {
+            OutError = FString::Printf(TEXT("no values for %s"), *Key);
+            return false;
+        }
+
+        // Every grid point so far is copied once per value
+        TArray<FFireSimParams> Expanded;
+        Expanded.Reserve(OutGrid.Num() * Values.Num());
+
+        for (const FFireSimParams& Point : OutGrid)
+        {
+            for (const FString& Value : Values)
+            {
+                FFireSimParams& Params = Expanded.Add_GetRef(Point);
+                bool bParsed = true;
+
+                if (Key.Equals(TEXT("Threshold"), ESearchCase::IgnoreCase))
+                {
+                    bParsed = ParseFloat(Value, Params.BurnedThresholdPercent);
+                }
+                else if (Key.Equals(TEXT("QuickDelay"), ESearchCase::IgnoreCase))
+                {
+                    bParsed = ParseFloat(Value, Params.QuickDelayScale);
+                }
+                else if (Key.Equals(TEXT("SlowDelay"), ESearchCase::IgnoreCase))
+                {
+                    bParsed = ParseFloat(Value, Params.SlowDelayScale);
+                }
+                else if (Key.Equals(TEXT("BurnDuration"), ESearchCase::IgnoreCase))
+                {
+                    bParsed = ParseFloat(Value, Params.BurnDuration);
+                }
+                else if (Key.Equals(TEXT("Ranks"), ESearchCase::IgnoreCase))
+                {
+                    // Ladders may be shorter than six, the lower ranks keep the base thresholds
+                    TArray<FString> Thresholds;
+                    Value.ParseIntoArray(Thresholds, TEXT("/"));
+                    bParsed = Thresholds.Num() <= UE_ARRAY_COUNT(Params.RankThresholds);
+                    for (int32 Rank = 0; bParsed && Rank < Thresholds.Num(); ++Rank)
+                    {
+                        bParsed = ParseFloat(Thresholds[Rank], Params.RankThresholds[Rank]);
+                    }
+                }
+                else
+                {
+                    OutError = FString::Printf(TEXT("unknown sweep parameter %s"), *Key);
+                    return false;
+                }
+
+                if (!bParsed)
+                {
+                    OutError = FString::Printf(TEXT("could not parse %s=%s"), *Key, *Value);
+                    return false;
+                }
+            }
+        }
+        OutGrid = MoveTemp(Expanded);
+    }
+    return true;
+}
+
+bool FireSweep::LoadPlan(const FString& Name, TArray<FFireEventRecord>& OutPlan, TArray<uint8>& OutSnapshot)
+{
+    OutPlan.Reset();
+    OutSnapshot.Reset();
+
+    if (Name.EndsWith(TEXT(".frep")))
+    {
+        FFireReplayReader Reader;
+        if (!Reader.Open(FPaths::ProjectSavedDir() / TEXT("FireReplays") / Name)) return false;
+
+        // The player's inputs only, the spread and burn outs are what the sweep plays out itself
+        FFireEventRecord Record;
+        while (Reader.Next(Record))
+        {
+            const bool bPlayerIgnite = Record.Type == EFireEventType::Ignite && Record.Source != EFireIgniteSource::Spread;
+            if (bPlayerIgnite || Record.Type == EFireEventType::Dig)
+            {
+                OutPlan.Add(Record);
+            }
+        }
+        OutSnapshot = Reader.GetSnapshot();
+        return true;
+    }
+
+    TArray<FString> Lines;
+    if (!FFileHelper::LoadFileToStringArray(Lines, *(GetSweepDir() / (Name + TEXT(".csv"))))) return false;
+
+    for (const FString& Line : Lines)
+    {
+        TArray<FString> Fields;
+        Line.TrimStartAndEnd().ParseIntoArray(Fields, TEXT(","));
+
+        // Skips blank lines, comments and a header row
+        if (Fields.Num() < 3 || !Fields[0].TrimStartAndEnd().IsNumeric()) continue;
+
+        FFireEventRecord& Step = OutPlan.AddDefaulted_GetRef();
+        Step.Time = FCString::Atod(*Fields[0]);
+        Step.TileIndex = FCString::Atoi(*Fields[1]);
+        Step.Type = Fields[2].TrimStartAndEnd().Equals(TEXT("dig"), ESearchCase::IgnoreCase) ? EFireEventType::Dig : EFireEventType::Ignite;
+    }
+
+    OutPlan.StableSort([](const FFireEventRecord& A, const FFireEventRecord& B)
+        {
+            return A.Time < B.Time;
+        });
+    return true;
+}
+
+void FireSweep::Run(const FFireTileTable& Layout, const FFireSpreadWeights& SpreadWeights, TArrayView<const FFireHistoryEvent> StartEvents,
+    TArrayView<const FFireSimParams> Grid, TArrayView<const int32> Seeds, TArrayView<const FFireEventRecord> Plan,
+    TArray<FFireSimResult>& OutResults)
+{
+    const int32 NumRuns = Grid.Num() * Seeds.Num();
+    OutResults.SetNum(NumRuns);
+    if (NumRuns == 0) return;
+
+    const int32 NumWorkers = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, NumRuns);
+    FThreadSafeCounter NextRun;
+
+    ParallelFor(NumWorkers, [&](int32)
+        {
+            // One sim per worker keeps its arrays between games. Games are handed out one at a
+            // time rather than in fixed blocks since a game can last anywhere from seconds to an hour
+            FFireHeadlessSim Sim(Layout, SpreadWeights);
+            for (int32 RunIndex = NextRun.Increment() - 1; RunIndex < NumRuns; RunIndex = NextRun.Increment() - 1)
+            {
+                OutResults[RunIndex] = Sim.Run(Grid[RunIndex / Seeds.Num()], Seeds[RunIndex % Seeds.Num()], StartEvents, Plan);
+            }
+        });
+}
+
+bool FireSweep::WriteCsv(const FString& Name, TArrayView<const FFireSimParams> Grid, TArrayView<const int32> Seeds,
+    TArrayView<const FFireSimResult> Results)
+{
+    check(Results.Num() == Grid.Num() * Seeds.Num());
+
+    FString Runs = TEXT("point,seed,end,won,end_time,burn_percent,saved_percent,rank,special_tiles,special_lost,events\n");
+    FString Summary = TEXT("point,threshold,ranks,quick_delay,slow_delay,burn_duration,runs,win_rate,")
+        TEXT("saved_mean,saved_p10,saved_p50,saved_p90,rank_ss,rank_s,rank_a,rank_b,rank_c,rank_d,rank_e,")
+        TEXT("extinguish_mean,extinguish_p10,extinguish_p50,extinguish_p90,special_loss_rate,special_game_over_rate,over_burn_rate,timeout_rate\n");
+
+    for (int32 Point = 0; Point < Grid.Num(); ++Point)
+    {
+        const FFireSimParams& Params = Grid[Point];
+
+        TArray<float> Saved;
+        TArray<float> ExtinguishTimes;
+        int32 RankCounts[7] = {};
+        int32 Wins = 0, SpecialGameOvers = 0, OverBurns = 0, Timeouts = 0;
+        double SpecialLossSum = 0.0;
+        int32 SpecialLossRuns = 0;
+
+        for (int32 SeedIndex = 0; SeedIndex < Seeds.Num(); ++SeedIndex)
+        {
+            const FFireSimResult& Result = Results[Point * Seeds.Num() + SeedIndex];
+
+            Runs += FString::Printf(TEXT("%d,%d,%s,%d,%.2f,%.4f,%d,%s,%d,%d,%d\n"),
+                Point, Seeds[SeedIndex], GetEndName(Result.End), Result.bWon ? 1 : 0, Result.EndTime, Result.BurnPercent,
+                Result.SavedPercent, *GetRankName(Result.Rank), Result.SpecialTiles, Result.SpecialTilesLost, Result.EventsRun);
+
+            Saved.Add(static_cast<float>(Result.SavedPercent));
+            RankCounts[FMath::Clamp(static_cast<int32>(Result.Rank), 0, 6)]++;
+            Wins += Result.bWon ? 1 : 0;
+            SpecialGameOvers += Result.End == EFireSimEnd::SpecialTiles ? 1 : 0;
+            OverBurns += Result.End == EFireSimEnd::OverBurn ? 1 : 0;
+            Timeouts += Result.End == EFireSimEnd::Timeout ? 1 : 0;
+
+            // Only won games see the fire go out
+            if (Result.bWon)
+            {
+                ExtinguishTimes.Add(Result.EndTime);
+            }
+            if (Result.SpecialTiles > 0)
+            {
+                SpecialLossSum += Result.SpecialTilesLost / static_cast<double>(Result.SpecialTiles);
+                SpecialLossRuns++;
+            }
+        }
+
+        Saved.Sort();
+        ExtinguishTimes.Sort();
+        const float NumSeeds = static_cast<float>(FMath::Max(Seeds.Num(), 1));
+
+        Summary += FString::Printf(TEXT("%d,%g,%s,%g,%g,%g,%d,%.4f,"),
+            Point, Params.BurnedThresholdPercent, *DescribeRanks(Params), Params.QuickDelayScale, Params.SlowDelayScale,
+            Params.BurnDuration, Seeds.Num(), Wins / NumSeeds);
+        Summary += FString::Printf(TEXT("%.2f,%g,%g,%g,"),
+            GetMean(Saved), GetPercentile(Saved, 0.1f), GetPercentile(Saved, 0.5f), GetPercentile(Saved, 0.9f));
+        for (int32 Count : RankCounts)
+        {
+            Summary += FString::Printf(TEXT("%d,"), Count);
+        }
+        Summary += FString::Printf(TEXT("%.2f,%.2f,%.2f,%.2f,%.4f,%.4f,%.4f,%.4f\n"),
+            GetMean(ExtinguishTimes), GetPercentile(ExtinguishTimes, 0.1f), GetPercentile(ExtinguishTimes, 0.5f), GetPercentile(ExtinguishTimes, 0.9f),
+            SpecialLossRuns > 0 ? SpecialLossSum / SpecialLossRuns : 0.0, SpecialGameOvers / NumSeeds, OverBurns / NumSeeds, Timeouts / NumSeeds);
+    }
+
+    const FString RunsPath = GetSweepDir() / (Name + TEXT("_runs.csv"));
+    const FString SummaryPath = GetSweepDir() / (Name + TEXT("_summary.csv"));
+    if (!FFileHelper::SaveStringToFile(Runs, *RunsPath) || !FFileHelper::SaveStringToFile(Summary, *SummaryPath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("fire.Sweep: could not write %s"), *SummaryPath);
+        return false;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("fire.Sweep: wrote %s and %s"), *RunsPath, *SummaryPath);
+    return true;
+}
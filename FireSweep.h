@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireSimulation.h"
+
+class UWorld;
+
+/*
+	Balancing runs: plays every point of a parameter grid against every seed with FFireHeadlessSim,
+	spread over all task graph workers, and writes the outcomes to Saved/FireSweeps as CSV.
+	Started from the console with fire.Sweep, which also works in a -nullrhi game for batch use.
+*/
+namespace FireSweep
+{
+	/*
+		Builds the cartesian product of "Key=a,b,c" arguments on top of Base. Keys:
+			Threshold     BurnedThresholdPercent
+			Ranks         rank ladders, SS/S/A/B/C/D thresholds separated by '/'
+			QuickDelay    spread delay scale of Quick tiles
+			SlowDelay     spread delay scale of Slow tiles
+			BurnDuration  burn duration of every tile, 0 keeps each tile's own
+		Unknown keys and values that do not parse are reported in OutError.
+	*/
+	BRIGHTSPARKSPROJECT_API bool BuildGrid(const TArray<FString>& Args, const FFireSimParams& Base, TArray<FFireSimParams>& OutGrid, FString& OutError);
+
+	/*
+		Loads the player's digs and ignites. A .frep name takes the torch, object, script and dig
+		records of a fire replay, anything else is read as Saved/FireSweeps/<Name>.csv with one
+		"seconds,tile,dig|ignite" row per step. OutSnapshot is the replay's starting fire state,
+		empty for scripted plans.
+	*/
+	BRIGHTSPARKSPROJECT_API bool LoadPlan(const FString& Name, TArray<FFireEventRecord>& OutPlan, TArray<uint8>& OutSnapshot);
+
+	// Runs Grid.Num() * Seeds.Num() games, results are grid point major. SpreadWeights need every table built
+	BRIGHTSPARKSPROJECT_API void Run(const FFireTileTable& Layout, const FFireSpreadWeights& SpreadWeights, TArrayView<const FFireHistoryEvent> StartEvents,
+		TArrayView<const FFireSimParams> Grid, TArrayView<const int32> Seeds, TArrayView<const FFireEventRecord> Plan,
+		TArray<FFireSimResult>& OutResults);
+
+	// <Name>_runs.csv with a row per game and <Name>_summary.csv with the distributions per grid point
+	BRIGHTSPARKSPROJECT_API bool WriteCsv(const FString& Name, TArrayView<const FFireSimParams> Grid, TArrayView<const int32> Seeds,
+		TArrayView<const FFireSimResult> Results);
+}
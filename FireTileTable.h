@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireSpreadPatch.h"
+
+// Tiles are grouped into chunks of consecutive indices for change tracking
+constexpr int32 FireTileChunkShift = 10;
+constexpr int32 FireTileChunkSize = 1 << FireTileChunkShift;
+
+// Byte oriented varints shared by the replay log and replication payloads
+namespace FireEncoding
+{
+	inline void WriteVarint(TArray<uint8>& Out, uint64 Value)
+	{
+		do
+		{
+			uint8 Byte = Value & 0x7F;
+			Value >>= 7;
+			if (Value != 0) Byte |= 0x80;
+			Out.Add(Byte);
+		} while (Value != 0);
+	}
+
+	inline bool ReadVarint(const uint8* Data, int64 Size, int64& InOutOffset, uint64& OutValue)
+	{
+		OutValue = 0;
+		for (int32 Shift = 0; Shift < 64; Shift += 7)
+		{
+			if (InOutOffset >= Size) return false;
+
+			const uint8 Byte = Data[InOutOffset++];
+			OutValue |= static_cast<uint64>(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0) return true;
+		}
+		return false;
+	}
+}
+
+// Per tile state bits
+enum class EFireTileFlags : uint8
+{
+	None            = 0,
+	Burning         = 1 << 0,
+	Burnt           = 1 << 1,
+	Dug             = 1 << 2,
+	Special         = 1 << 3,
+	PendingIgnition = 1 << 4,
+
+	// Set while the tile's cell is simulated as a whole far from the players, see FFireLod
+	Coarse          = 1 << 5,
+
+	// Set while the tile is waiting in the subsystem's visual update batch
+	VisualDirty     = 1 << 7
+};
+ENUM_CLASS_FLAGS(EFireTileFlags)
+
+// Values written to the first per instance custom data float of field tiles
+enum class EFireTileVisual : uint8
+{
+	Unburnt,
+	Burning,
+	Burnt,
+	Dug
+};
+
+/*
+	Struct of arrays holding every fire tile in the world, addressed by tile index.
+	Tiles are either an AFireSpreadPatch actor or an instance of an AFirePatchField, the
+	table itself holds no object pointers so it can be copied and read off the game thread.
+*/
+struct FFireTileTable
+{
+	TArray<EFireTileFlags> Flags;
+	TArray<ESurfaceBurnType> BurnTypes;
+	TArray<FVector3f> Locations;
+	TArray<float> BurnDurations;
+
+	// Fuel mass a tile lights with and how much of it burns per second, BurnDurations is how long that lasts
+	TArray<float> FuelLoads;
+	TArray<float> BurnRates;
+
+	TArray<float> MinSpreadDelays;
+	TArray<float> MaxSpreadDelays;
+	TArray<TArray<int32, TInlineAllocator<8>>> Neighbours;
+
+	int32 Num() const { return Flags.Num(); }
+	int32 NumChunks() const { return (Num() + FireTileChunkSize - 1) >> FireTileChunkShift; }
+	static int32 GetChunk(int32 Tile) { return Tile >> FireTileChunkShift; }
+	bool IsValidIndex(int32 Tile) const { return Flags.IsValidIndex(Tile); }
+
+	int32 AddTile()
+	{
+		BurnTypes.AddDefaulted();
+		Locations.AddDefaulted();
+		BurnDurations.Add(45.0f);
+		FuelLoads.Add(45.0f);
+		BurnRates.Add(1.0f);
+		MinSpreadDelays.Add(5.0f);
+		MaxSpreadDelays.Add(15.0f);
+		Neighbours.AddDefaulted();
+		return Flags.Add(EFireTileFlags::None);
+	}
+
+	void Reserve(int32 NumTiles)
+	{
+		Flags.Reserve(NumTiles);
+		BurnTypes.Reserve(NumTiles);
+		Locations.Reserve(NumTiles);
+		BurnDurations.Reserve(NumTiles);
+		FuelLoads.Reserve(NumTiles);
+		BurnRates.Reserve(NumTiles);
+		MinSpreadDelays.Reserve(NumTiles);
+		MaxSpreadDelays.Reserve(NumTiles);
+		Neighbours.Reserve(NumTiles);
+	}
+
+	// A FuelLoad of 0 or less gives the tile BurnDuration seconds worth of fuel at its burn rate
+	void SetFuel(int32 Tile, float FuelLoad, float BurnRate, float BurnDuration)
+	{
+		BurnRates[Tile] = FMath::Max(BurnRate, KINDA_SMALL_NUMBER);
+		FuelLoads[Tile] = FuelLoad > 0.0f ? FuelLoad : BurnDuration * BurnRates[Tile];
+		BurnDurations[Tile] = FuelLoads[Tile] / BurnRates[Tile];
+	}
+
+	bool HasFlag(int32 Tile, EFireTileFlags Flag) const { return EnumHasAnyFlags(Flags[Tile], Flag); }
+	void SetFlag(int32 Tile, EFireTileFlags Flag, bool bValue)
+	{
+		if (bValue) EnumAddFlags(Flags[Tile], Flag);
+		else EnumRemoveFlags(Flags[Tile], Flag);
+	}
+
+	bool IsBurning(int32 Tile) const { return HasFlag(Tile, EFireTileFlags::Burning); }
+	bool IsBurnt(int32 Tile) const { return HasFlag(Tile, EFireTileFlags::Burnt); }
+	bool IsDug(int32 Tile) const { return HasFlag(Tile, EFireTileFlags::Dug); }
+	bool IsSpecial(int32 Tile) const { return HasFlag(Tile, EFireTileFlags::Special); }
+
+	bool IsBurnableType(int32 Tile) const { return IsBurnableType(BurnTypes[Tile]); }
+
+	static bool IsBurnableType(ESurfaceBurnType Type)
+	{
+		return Type == ESurfaceBurnType::Quick || Type == ESurfaceBurnType::Slow;
+	}
+
+	// Same rules as AFireSpreadPatch::Ignite
+	bool CanIgnite(int32 Tile) const { return CanIgnite(Flags[Tile], BurnTypes[Tile]); }
+	static bool CanIgnite(EFireTileFlags TileFlags, ESurfaceBurnType Type)
+	{
+		return !EnumHasAnyFlags(TileFlags, EFireTileFlags::Burning | EFireTileFlags::Burnt | EFireTileFlags::Dug)
+			&& Type != ESurfaceBurnType::NonBurnable;
+	}
+
+	// Same rules as the neighbour filter in AFireSpreadPatch::SpreadFire
+	bool CanSpreadInto(int32 Tile) const { return CanSpreadInto(Flags[Tile]); }
+	static bool CanSpreadInto(EFireTileFlags TileFlags)
+	{
+		return !EnumHasAnyFlags(TileFlags, EFireTileFlags::Burning | EFireTileFlags::Burnt | EFireTileFlags::PendingIgnition | EFireTileFlags::Dug);
+	}
+
+	// Type constant the random spread delay is multiplied by, see AFireSpreadPatch::FetchSpreadDelay
+	static float GetSpreadDelayScale(ESurfaceBurnType Type)
+	{
+		switch (Type)
+		{
+		case ESurfaceBurnType::Quick: return 2.f;
+		case ESurfaceBurnType::Slow:  return 5.f;
+		default:                      return 0.f;
+		}
+	}
+
+	EFireTileVisual GetVisual(int32 Tile) const
+	{
+		if (IsBurning(Tile)) return EFireTileVisual::Burning;
+		if (IsBurnt(Tile)) return EFireTileVisual::Burnt;
+		if (IsDug(Tile)) return EFireTileVisual::Dug;
+		return EFireTileVisual::Unburnt;
+	}
+};